@@ -31,6 +31,7 @@ sudo apt install -y \
     libjack-jackd2-dev \
     jackd2 \
     libsndfile1-dev \
+    libfftw3-dev \
     pkg-config
 
 echo ""
@@ -51,6 +52,13 @@ else
     exit 1
 fi
 
+if pkg-config --exists fftw3f; then
+    echo "✓ FFTW development libraries installed successfully"
+else
+    echo "✗ FFTW installation failed"
+    exit 1
+fi
+
 if command -v gcc >/dev/null 2>&1; then
     echo "✓ GCC compiler available"
 else
@@ -1,38 +1,205 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
 #include <jack/jack.h>
+#include <jack/ringbuffer.h>
 #include "audio_engine.h"
 #include "jack_client.h"
+#include "limiter.h"
+#include "bus.h"
+#include "dsp.h"
+#include "voice_filter.h"
+#include "reverb.h"
+#include "params.h"
+#include "trace.h"
+#include "worker_pool.h"
+#include "recorder.h"
+#include "live_sampler.h"
+#include "midi_clock.h"
+#include "sequencer.h"
+#include "sample_cache.h"
 
 // Engine state
 static audio_engine_config_t engine_config;
 static int engine_initialized = 0;
 
-// Voice management
+// Voice management (voices are only touched by the audio thread once running)
 static audio_voice_t voices[MAX_VOICES];
 static int next_voice_id = 1;
-static pthread_mutex_t voice_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#if MAX_VOICES > VOICE_FILTER_MAX_VOICES
+#error "MAX_VOICES exceeds the voice filter bank size"
+#endif
+
+// Sample played by each MIDI channel (published atomically by control threads)
+static audio_sample_t *channel_samples[16];
+
+// Filter settings per MIDI channel, applied to its voices (audio thread only)
+typedef struct {
+    int mode;                   // filter_mode_t
+    float cutoff;               // 0-127
+    float resonance;            // 0-127
+} channel_filter_t;
+
+static channel_filter_t channel_filters[16];
+
+// Envelope times per MIDI channel for looped samples (audio thread only)
+typedef struct {
+    float attack_ms;
+    float release_ms;
+} channel_envelope_t;
+
+static channel_envelope_t channel_envelopes[16];
+
+// Start/end offsets per MIDI channel as fractions of the sample (audio thread only)
+// Snapped to zero crossings at note-on
+typedef struct {
+    float start;
+    float end;
+} channel_range_t;
+
+static channel_range_t channel_ranges[16];
+
+// Continuous controllers per MIDI channel, stored as events arrive
+// and turned into voice modulation targets once per block (audio thread only)
+typedef struct {
+    float bend;                 // -1.0 - 1.0
+    float mod_wheel;            // 0.0 - 1.0
+    float pressure;             // Channel aftertouch, 0.0 - 1.0
+    float bend_ratio;           // Pitch multiplier for the current bend
+    int bend_changed;           // bend_ratio needs recomputing
+    int cutoff_changed;         // Voice filters need the new mod wheel cutoff
+} channel_mod_t;
+
+static channel_mod_t channel_mods[16];
+
+// Per-voice filters; filtered voices are rendered into interleaved lanes
+// (frame * VOICE_LANES + voice * 2 + channel) so the bank runs across voices
+// Each render thread has its own block of lanes, so threads never write the same cache line
+#define VOICE_LANES (MAX_VOICES * 2)
+static voice_filter_bank_t filter_bank;
+static float *voice_lanes = NULL;          // render_threads blocks of scratch_capacity frames
+
+// Multi-core rendering: threads 1.. mix their voices into their own copies of the
+// channel buses and master (last), summed into the engine's buses after the join
+static int render_threads = 1;             // Including the audio thread
+static audio_bus_t thread_buses[ENGINE_RENDER_MAX_THREADS][ENGINE_CHANNEL_BUSES + 1];
+
+// Voices rendered by one task: a run of the active voice list
+typedef struct {
+    int first;
+    int end;
+} render_range_t;
+
+typedef struct {
+    const int *active_voices;
+    render_range_t ranges[ENGINE_RENDER_MAX_THREADS];
+    jack_nframes_t nframes;
+} render_job_t;
+
+// Commands from control threads to the audio thread
+typedef enum {
+    ENGINE_CMD_TRIGGER,
+    ENGINE_CMD_STOP_VOICE,
+    ENGINE_CMD_STOP_ALL,
+    ENGINE_CMD_STOP_SAMPLE,
+    ENGINE_CMD_SET_FILTER,
+    ENGINE_CMD_SET_ENVELOPE,
+    ENGINE_CMD_SET_RANGE,
+    ENGINE_CMD_SET_KIT
+} engine_command_type_t;
+
+typedef struct {
+    int type;                   // engine_command_type_t
+    audio_sample_t *sample;     // Sample to trigger or stop (TRIGGER/STOP_SAMPLE)
+    audio_sample_t *const *kit; // Sample of each MIDI channel (ENGINE_CMD_SET_KIT)
+    float volume;               // Voice volume (ENGINE_CMD_TRIGGER)
+    int voice_id;               // Voice to start or stop
+    int bus;                    // MIDI channel (SET_FILTER/SET_ENVELOPE/SET_RANGE)
+    int effect_type;            // Filter mode (ENGINE_CMD_SET_FILTER)
+    int value;                  // Attack ms, start (SET_ENVELOPE/SET_RANGE)
+    int value2;                 // Release ms, end (SET_ENVELOPE/SET_RANGE)
+} engine_command_t;
+
+// Lock-free queues consumed at the start of each block
+// Producers serialize on queue_mutex; the audio thread never locks
+static jack_ringbuffer_t *event_ring = NULL;
+static jack_ringbuffer_t *command_ring = NULL;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Cached JACK format and ports (updated from JACK callbacks, not queried per cycle)
+static int engine_sample_rate = 48000;     // Published by the sample rate callback
+static int applied_sample_rate = 48000;    // Rate voice ratios were computed for (audio thread)
+static jack_nframes_t engine_buffer_size = 0;
+static jack_port_t *output_ports[2] = {NULL, NULL};
+
+// Mix buses (one per MIDI channel plus master), allocated in the buffer size callback
+// Voices mix into their channel bus; each bus runs its inserts once per block
+static audio_bus_t channel_buses[ENGINE_CHANNEL_BUSES];
+static audio_bus_t master_bus;
+
+// Reverb send bus: channel buses feed it post-insert, the wet return goes to master
+static audio_bus_t reverb_bus;
+static jack_nframes_t scratch_capacity = 0;
+
+// Output stage: smoothed master/polyphony gain and look-ahead limiter
+static limiter_t output_limiter;
+static float unlimited_gain = 0.0f;        // Gain at the end of the last block (limit_output off)
 
 // Statistics
 static unsigned long total_frames_processed = 0;
 static int last_active_voices = 0;
+static unsigned long events_dropped = 0;
+static unsigned long notes_dropped = 0;
+static unsigned long sample_hits = 0;
+static unsigned long sample_misses = 0;
+static unsigned long kits_applied = 0;
+
+// Meter ballistics (audio thread only): channel buses, then reverb send and output
+#define METER_REVERB ENGINE_CHANNEL_BUSES
+#define METER_OUTPUT (ENGINE_CHANNEL_BUSES + 1)
+#define METER_COUNT (ENGINE_CHANNEL_BUSES + 2)
+
+typedef struct {
+    float peak[2];
+    float mean_square[2];
+} meter_state_t;
+
+static meter_state_t meter_states[METER_COUNT];
+static int meter_sample_rate = 0;           // Rate and block size the coefficients are for
+static jack_nframes_t meter_frames = 0;
+static float meter_peak_fall = 0.0f;        // Peak multiplier per block
+static float meter_rms_coeff = 1.0f;        // Mean square smoothing per block
+
+// MIDI clock tempo and position at the start of the current block (audio thread only)
+static midi_clock_state_t engine_clock;
+
+// Meters published once per block; readers retry while meters_seq is odd or changes
+static engine_meters_t published_meters;
+static unsigned int meters_seq = 0;
 
 // Default configuration
 audio_engine_config_t audio_engine_get_default_config(void) {
     audio_engine_config_t config = {
         .max_voices = MAX_VOICES,
         .master_gain = 0.7f,
-        .auto_gain_control = 1
+        .auto_gain_control = 1,
+        .pitch_bend_range = 2.0f,
+        .mod_wheel_cutoff = 0.0f,
+        .aftertouch_volume = 0.0f,
+        .limit_output = 1,
+        .render_threads = 1
     };
     return config;
 }
 
 // Initialize voice management
 static void init_voices(void) {
-    pthread_mutex_lock(&voice_mutex);
     for (int i = 0; i < MAX_VOICES; i++) {
         voices[i].sample = NULL;
         voices[i].playback_position = 0.0f;
@@ -40,13 +207,21 @@ static void init_voices(void) {
         voices[i].volume = 1.0f;
         voices[i].active = 0;
         voices[i].voice_id = 0;
+        voices[i].channel = -1;
+        voices[i].note = -1;
+        voices[i].envelope = 1.0f;
+        voices[i].envelope_step = 0.0f;
+        voices[i].releasing = 0;
+        voices[i].end_position = 0.0f;
+        voices[i].pressure = 0.0f;
+        voices[i].pitch_mod = voices[i].pitch_mod_target = 1.0f;
+        voices[i].gain_mod = voices[i].gain_mod_target = 1.0f;
     }
-    pthread_mutex_unlock(&voice_mutex);
 }
 
-// Find free voice slot
+// Find free voice slot (within the configured polyphony)
 static int find_free_voice(void) {
-    for (int i = 0; i < MAX_VOICES; i++) {
+    for (int i = 0; i < engine_config.max_voices; i++) {
         if (!voices[i].active) {
             return i;
         }
@@ -54,16 +229,557 @@ static int find_free_voice(void) {
     return -1; // No free voices
 }
 
-// Get sample with simple access (no interpolation for now - JACK handles sample rate)
-static inline float get_sample_simple(audio_sample_t *sample, int position, int channel) {
+// Read one frame of a mip level (shift 0 = the sample itself); 'position' is in sample frames
+static inline float get_level_sample(const audio_sample_t *sample, const float *data, int shift,
+                                     int position, int channel) {
     if (position >= sample->frames) {
         return 0.0f;
     }
     
+    position >>= shift;
     if (sample->channels == 1) {
-        return sample->data[position];
+        return data[position];
     } else {
-        return sample->data[position * 2 + channel];
+        return data[position * 2 + channel];
+    }
+}
+
+// Playback increment for a sample at the current engine rate (audio thread only)
+static inline float voice_rate_ratio(audio_sample_t *sample) {
+    return (float)sample->sample_rate / (float)applied_sample_rate;
+}
+
+// Filter cutoff of a channel including the mod wheel offset
+static float channel_cutoff(int channel) {
+    float cutoff = channel_filters[channel & 0x0F].cutoff +
+                   channel_mods[channel & 0x0F].mod_wheel * engine_config.mod_wheel_cutoff;
+    if (cutoff < 0.0f) cutoff = 0.0f;
+    if (cutoff > FILTER_VALUE_MAX) cutoff = FILTER_VALUE_MAX;
+    return cutoff;
+}
+
+// Start a voice on a free slot (audio thread only)
+// 'offset' delays the start within the current block (sequenced notes)
+static void start_voice(audio_sample_t *sample, float volume, int voice_id, int channel, int note, int offset) {
+    int voice_slot = find_free_voice();
+    if (voice_slot < 0) {
+        __atomic_add_fetch(&notes_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    // Channel start/end offsets, snapped to zero crossings so they don't click
+    // (looped samples keep their loop, so only the start applies)
+    int start_frame = 0;
+    int end_frame = sample->frames;
+    if (channel >= 0) {
+        const channel_range_t *range = &channel_ranges[channel & 0x0F];
+        if (range->start > 0.0f) {
+            start_frame = audio_sample_snap_to_zero_crossing(sample, (int)(range->start * sample->frames));
+        }
+        if (range->end < 1.0f && sample->loop_end == 0) {
+            end_frame = audio_sample_snap_to_zero_crossing(sample, (int)(range->end * sample->frames));
+        }
+        int last_start = sample->loop_end > 0 ? sample->loop_end - 1 : end_frame - 1;
+        if (start_frame > last_start) {
+            start_frame = last_start > 0 ? last_start : 0;
+        }
+    }
+    
+    // Cached samples always have their head; the cache reloads the rest once it sees the miss
+    if (sample->cached) {
+        if (__atomic_load_n(&sample->evicted_frame, __ATOMIC_ACQUIRE) > 0) {
+            __atomic_add_fetch(&sample_misses, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_add_fetch(&sample_hits, 1, __ATOMIC_RELAXED);
+        }
+    }
+    
+    voices[voice_slot].sample = sample;
+    voices[voice_slot].playback_position = (float)start_frame;
+    voices[voice_slot].end_position = (float)end_frame;
+    voices[voice_slot].sample_rate_ratio = voice_rate_ratio(sample);
+    voices[voice_slot].volume = volume;
+    voices[voice_slot].voice_id = voice_id;
+    voices[voice_slot].channel = channel;
+    voices[voice_slot].note = note;
+    voices[voice_slot].releasing = 0;
+    voices[voice_slot].envelope = 1.0f;
+    voices[voice_slot].envelope_step = 0.0f;
+    voices[voice_slot].start_offset = offset;
+    voices[voice_slot].release_offset = -1;
+    voices[voice_slot].eviction_fade = 1.0f;
+    voices[voice_slot].active = 1;
+    
+    // Looped samples sustain until released, so they get an attack/release envelope
+    if (sample->loop_end > 0 && channel >= 0) {
+        float attack_frames = channel_envelopes[channel & 0x0F].attack_ms * applied_sample_rate / 1000.0f;
+        if (attack_frames >= 1.0f) {
+            voices[voice_slot].envelope = 0.0f;
+            voices[voice_slot].envelope_step = 1.0f / attack_frames;
+        }
+    }
+    
+    // Voices take their channel's filter settings and current modulation;
+    // triggered samples play unfiltered
+    voices[voice_slot].pressure = 0.0f;
+    voices[voice_slot].pitch_mod = voices[voice_slot].pitch_mod_target = 1.0f;
+    voices[voice_slot].gain_mod = voices[voice_slot].gain_mod_target = 1.0f;
+    if (channel >= 0) {
+        const channel_filter_t *cf = &channel_filters[channel & 0x0F];
+        const channel_mod_t *mod = &channel_mods[channel & 0x0F];
+        voices[voice_slot].pitch_mod = voices[voice_slot].pitch_mod_target = mod->bend_ratio;
+        voices[voice_slot].gain_mod = voices[voice_slot].gain_mod_target =
+            1.0f + engine_config.aftertouch_volume * mod->pressure;
+        voice_filter_start(&filter_bank, voice_slot, cf->mode, channel_cutoff(channel), cf->resonance);
+    } else {
+        voice_filter_start(&filter_bank, voice_slot, FILTER_LOWPASS, FILTER_VALUE_MAX, 0.0f);
+    }
+}
+
+// Release the looped voices held by a note (one-shots play to the end)
+// 'offset' delays the release within the current block (sequenced notes)
+static void release_note(int channel, int note, int offset) {
+    float release_frames = channel_envelopes[channel & 0x0F].release_ms * applied_sample_rate / 1000.0f;
+    if (release_frames < 1.0f) {
+        release_frames = 1.0f;
+    }
+    
+    for (int v = 0; v < MAX_VOICES; v++) {
+        audio_voice_t *voice = &voices[v];
+        if (voice->active && !voice->releasing && voice->channel == channel && voice->note == note &&
+            voice->sample->loop_end > 0) {
+            voice->releasing = 1;
+            if (offset > 0) {
+                voice->release_offset = offset;
+                voice->release_step = -1.0f / release_frames;
+            } else {
+                voice->envelope_step = -1.0f / release_frames;
+            }
+        }
+    }
+}
+
+// Pick up this block's smoothed parameter values (audio thread only)
+// Filter changes glide through voice_filter_modulate; sends and gains are read while mixing
+static void apply_parameters(jack_nframes_t nframes) {
+    params_update(applied_sample_rate, nframes);
+    
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        int cutoff_id = ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_FILTER_CUTOFF);
+        int resonance_id = ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_FILTER_RESONANCE);
+        if (params_changed(cutoff_id) || params_changed(resonance_id)) {
+            channel_filters[ch].cutoff = params_value(cutoff_id);
+            channel_filters[ch].resonance = params_value(resonance_id);
+            channel_mods[ch].cutoff_changed = 1;
+        }
+        
+        int bitcrush_id = ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_BITCRUSH);
+        if (params_changed(bitcrush_id)) {
+            effect_t *effect = bus_find_insert(&channel_buses[ch], EFFECT_BITCRUSH);
+            if (effect) {
+                effect_set_value(effect, (int)(params_value(bitcrush_id) + 0.5f), applied_sample_rate);
+            }
+        }
+    }
+}
+
+// Store a continuous controller event; voices pick it up at the next block start
+static void apply_controller_event(const midi_event_t *e) {
+    channel_mod_t *mod = &channel_mods[e->channel & 0x0F];
+    
+    switch (e->type) {
+        case MIDI_EVENT_PITCH:
+            mod->bend = midi_event_pitch_value(e) / 8192.0f;
+            mod->bend_changed = 1;
+            break;
+            
+        case MIDI_EVENT_CC:
+            if (e->data1 == MIDI_CC_MOD_WHEEL) {
+                mod->mod_wheel = e->data2 / 127.0f;
+                mod->cutoff_changed = 1;
+            }
+            break;
+            
+        case MIDI_EVENT_PRESSURE:
+            mod->pressure = e->data1 / 127.0f;
+            break;
+            
+        case MIDI_EVENT_KEY_PRESSURE:
+            for (int v = 0; v < MAX_VOICES; v++) {
+                if (voices[v].active && voices[v].channel == e->channel && voices[v].note == e->data1) {
+                    voices[v].pressure = e->data2 / 127.0f;
+                }
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+// Turn the controllers into per-voice targets, once per block
+// Expensive functions (powf for the bend) run only when a controller changed;
+// render_voice ramps linearly from the previous targets across the block
+static void update_modulation(void) {
+    for (int ch = 0; ch < 16; ch++) {
+        channel_mod_t *mod = &channel_mods[ch];
+        if (mod->bend_changed) {
+            mod->bend_ratio = powf(2.0f, mod->bend * engine_config.pitch_bend_range / 12.0f);
+            mod->bend_changed = 0;
+        }
+    }
+    
+    for (int v = 0; v < MAX_VOICES; v++) {
+        audio_voice_t *voice = &voices[v];
+        if (!voice->active || voice->channel < 0) {
+            continue;
+        }
+        
+        const channel_mod_t *mod = &channel_mods[voice->channel & 0x0F];
+        float pressure = mod->pressure > voice->pressure ? mod->pressure : voice->pressure;
+        voice->pitch_mod_target = mod->bend_ratio;
+        voice->gain_mod_target = 1.0f + engine_config.aftertouch_volume * pressure;
+        
+        if (mod->cutoff_changed) {
+            const channel_filter_t *cf = &channel_filters[voice->channel & 0x0F];
+            voice_filter_modulate(&filter_bank, v, cf->mode, channel_cutoff(voice->channel), cf->resonance);
+        }
+    }
+    
+    for (int ch = 0; ch < 16; ch++) {
+        channel_mods[ch].cutoff_changed = 0;
+    }
+}
+
+// Add a voice's next frames into left/right ('stride' floats between frames)
+// Sustain loops wrap until the release envelope ends the voice; one-shots stop at the end
+static void render_voice(audio_voice_t *voice, float *left, float *right, int stride, jack_nframes_t nframes) {
+    audio_sample_t *sample = voice->sample;
+    int looped = sample->loop_end > 0;
+    float end = looped ? (float)sample->loop_end : voice->end_position;
+    int evicted = __atomic_load_n(&sample->evicted_frame, __ATOMIC_ACQUIRE);
+    float loop_length = (float)(sample->loop_end - sample->loop_start);
+    float envelope = voice->envelope;
+    float envelope_step = voice->envelope_step;
+    
+    // Sequenced notes start and release at exact frames within the block
+    jack_nframes_t first_frame = voice->start_offset < (int)nframes ? (jack_nframes_t)voice->start_offset : nframes;
+    int release_at = voice->release_offset;
+    voice->start_offset = 0;
+    voice->release_offset = -1;
+    
+    // Modulation ramps linearly from last block's targets to this block's
+    float ratio = voice->sample_rate_ratio * voice->pitch_mod;
+    float ratio_step = (voice->sample_rate_ratio * voice->pitch_mod_target - ratio) / (float)nframes;
+    float volume = voice->volume * voice->gain_mod;
+    float volume_step = (voice->volume * voice->gain_mod_target - volume) / (float)nframes;
+    voice->pitch_mod = voice->pitch_mod_target;
+    voice->gain_mod = voice->gain_mod_target;
+    
+    // Read the mip level whose rate is closest to the playback ratio (within half an octave),
+    // so voices pitched far up neither alias nor skip through memory; positions stay in sample frames
+    const float *data = sample->data;
+    int shift = 0;
+    int levels = __atomic_load_n(&sample->mip_count, __ATOMIC_ACQUIRE);
+    if (levels > 0) {
+        float top_ratio = fmaxf(ratio, ratio + ratio_step * nframes);
+        while (shift < levels && top_ratio > (float)M_SQRT2 * (float)(1 << shift)) {
+            shift++;
+        }
+        if (shift > 0) {
+            data = sample->mip_data[shift - 1];
+        }
+    }
+    
+    // Mip levels and sustain loops stay resident; full-rate data may end at the
+    // evicted tail, and a voice heading there fades out in time to reach it silent.
+    // The fade follows this block's resident_end, so a voice whose next frames were
+    // reloaded meanwhile ramps back up instead of dying
+    int truncated = evicted > 0 && shift == 0 && !(looped && evicted >= sample->loop_end);
+    float resident_end = truncated ? (float)evicted : INFINITY;
+    float fade_frames = ENGINE_EVICTION_FADE_MS * applied_sample_rate / 1000.0f;
+    float fade_length = fade_frames * ratio;
+    float fade_start = resident_end - fade_length;
+    float fade_rise = 1.0f / fade_frames;
+    float fade = voice->eviction_fade;
+    
+    for (jack_nframes_t f = first_frame; f < nframes; f++) {
+        if ((int)f == release_at) {
+            envelope_step = voice->release_step;
+        }
+        if (voice->playback_position >= end) {
+            if (!looped) {
+                voice->active = 0;
+                break;
+            }
+            voice->playback_position -= loop_length;
+        }
+        if (voice->playback_position >= resident_end) {
+            voice->active = 0;
+            break;
+        }
+        if (fade < 1.0f || voice->playback_position >= fade_start) {
+            fade = fminf(fminf(fade + fade_rise, 1.0f), (resident_end - voice->playback_position) / fade_length);
+        }
+        int int_position = (int)voice->playback_position;
+        float gain = volume * envelope * fade;
+        
+        if (sample->channels == 1) {
+            // Mono sample
+            float sample_value = get_level_sample(sample, data, shift, int_position, 0) * gain;
+            
+            left[f * stride] += sample_value;
+            right[f * stride] += sample_value;
+        } else {
+            // Stereo sample
+            left[f * stride] += get_level_sample(sample, data, shift, int_position, 0) * gain;
+            right[f * stride] += get_level_sample(sample, data, shift, int_position, 1) * gain;
+        }
+        
+        // Attack ramps up to sustain; release ramps down to silence
+        envelope += envelope_step;
+        if (envelope >= 1.0f) {
+            envelope = 1.0f;
+            envelope_step = 0.0f;
+        } else if (envelope <= 0.0f) {
+            voice->active = 0;
+            break;
+        }
+        
+        // Advance voice playback position with sample rate conversion and pitch modulation
+        voice->playback_position += ratio;
+        ratio += ratio_step;
+        volume += volume_step;
+    }
+    
+    voice->envelope = envelope;
+    voice->envelope_step = envelope_step;
+    voice->eviction_fade = fade;
+}
+
+// Bus a voice mixes into: the engine's own buses for task 0, the task's copies otherwise
+static audio_bus_t* voice_bus(int task, int channel) {
+    if (task == 0) {
+        return channel >= 0 ? &channel_buses[channel & 0x0F] : &master_bus;
+    }
+    return &thread_buses[task][channel >= 0 ? (channel & 0x0F) : ENGINE_CHANNEL_BUSES];
+}
+
+// Render one run of voices (audio thread or a render thread)
+// Unfiltered voices mix straight into their bus, filtered ones render into their lanes,
+// go through the filter bank together and are then mixed into their bus
+static void render_voice_range(int task, void *arg) {
+    const render_job_t *job = arg;
+    const render_range_t *range = &job->ranges[task];
+    jack_nframes_t nframes = job->nframes;
+    float *task_lanes = voice_lanes + (size_t)task * scratch_capacity * VOICE_LANES;
+    
+    if (task > 0) {
+        for (int b = 0; b <= ENGINE_CHANNEL_BUSES; b++) {
+            bus_begin_block(&thread_buses[task][b]);
+        }
+    }
+    
+    int filtered_voices[MAX_VOICES];
+    int filtered_count = 0;
+    int first_lane = -1;
+    int end_lane = 0;
+    for (int i = range->first; i < range->end; i++) {
+        int v = job->active_voices[i];
+        audio_voice_t *voice = &voices[v];
+        
+        if (voice_filter_is_bypassed(&filter_bank, v)) {
+            audio_bus_t *bus = voice_bus(task, voice->channel);
+            bus_activate(bus, nframes);
+            render_voice(voice, bus->left, bus->right, 1, nframes);
+            continue;
+        }
+        
+        float *lanes = task_lanes + v * 2;
+        for (jack_nframes_t f = 0; f < nframes; f++) {
+            lanes[f * VOICE_LANES] = 0.0f;
+            lanes[f * VOICE_LANES + 1] = 0.0f;
+        }
+        render_voice(voice, lanes, lanes + 1, VOICE_LANES, nframes);
+        filtered_voices[filtered_count++] = v;
+        if (first_lane < 0) {
+            first_lane = (v * 2) & ~3;
+        }
+        end_lane = (v * 2 + 2 + 3) & ~3;
+    }
+    
+    if (filtered_count == 0) {
+        return;
+    }
+    
+    // Filter the run's lanes at once (lanes of unfiltered voices in between pass through unchanged)
+    voice_filter_process(&filter_bank, task_lanes, VOICE_LANES, first_lane, end_lane - first_lane, nframes);
+    
+    for (int i = 0; i < filtered_count; i++) {
+        int v = filtered_voices[i];
+        audio_bus_t *bus = voice_bus(task, voices[v].channel);
+        bus_activate(bus, nframes);
+        
+        const float *lanes = task_lanes + v * 2;
+        for (jack_nframes_t f = 0; f < nframes; f++) {
+            bus->left[f] += lanes[f * VOICE_LANES];
+            bus->right[f] += lanes[f * VOICE_LANES + 1];
+        }
+    }
+}
+
+// Split the active voices into runs of similar size, one per render thread,
+// or a single run when there are too few voices to be worth the hand-off
+// Runs only break between slot pairs, so no two threads filter the same 4-lane vector
+static int split_voices(render_job_t *job, const int *active_voices, int active_count) {
+    int tasks = active_count / ENGINE_RENDER_MIN_VOICES;
+    if (tasks > render_threads) {
+        tasks = render_threads;
+    }
+    if (tasks < 1) {
+        tasks = 1;
+    }
+    
+    int per_task = (active_count + tasks - 1) / tasks;
+    int t = 0;
+    job->ranges[0].first = 0;
+    for (int i = 1; i < active_count && t < tasks - 1; i++) {
+        if (i - job->ranges[t].first >= per_task && active_voices[i] / 2 != active_voices[i - 1] / 2) {
+            job->ranges[t].end = i;
+            job->ranges[++t].first = i;
+        }
+    }
+    job->ranges[t].end = active_count;
+    return t + 1;
+}
+
+// Apply trigger/stop commands (audio thread only)
+static void process_queued_commands(void) {
+    engine_command_t cmd;
+    
+    while (jack_ringbuffer_read_space(command_ring) >= sizeof(cmd)) {
+        jack_ringbuffer_read(command_ring, (char*)&cmd, sizeof(cmd));
+        
+        switch (cmd.type) {
+            case ENGINE_CMD_TRIGGER:
+                start_voice(cmd.sample, cmd.volume, cmd.voice_id, -1, -1, 0);
+                break;
+                
+            case ENGINE_CMD_STOP_VOICE:
+                for (int i = 0; i < MAX_VOICES; i++) {
+                    if (voices[i].active && voices[i].voice_id == cmd.voice_id) {
+                        voices[i].active = 0;
+                        break;
+                    }
+                }
+                break;
+                
+            case ENGINE_CMD_STOP_ALL:
+                for (int i = 0; i < MAX_VOICES; i++) {
+                    voices[i].active = 0;
+                }
+                break;
+                
+            case ENGINE_CMD_STOP_SAMPLE:
+                for (int i = 0; i < MAX_VOICES; i++) {
+                    if (voices[i].sample == cmd.sample) {
+                        voices[i].active = 0;
+                    }
+                }
+                break;
+                
+            case ENGINE_CMD_SET_ENVELOPE:
+                channel_envelopes[cmd.bus & 0x0F].attack_ms = (float)cmd.value;
+                channel_envelopes[cmd.bus & 0x0F].release_ms = (float)cmd.value2;
+                break;
+                
+            case ENGINE_CMD_SET_RANGE:
+                channel_ranges[cmd.bus & 0x0F].start = cmd.value / 127.0f;
+                channel_ranges[cmd.bus & 0x0F].end = cmd.value2 / 127.0f;
+                break;
+                
+            case ENGINE_CMD_SET_FILTER:
+                channel_filters[cmd.bus & 0x0F].mode = cmd.effect_type;
+                channel_mods[cmd.bus & 0x0F].cutoff_changed = 1;
+                break;
+                
+            // Every channel changes before this block's notes; playing voices keep their sample
+            case ENGINE_CMD_SET_KIT:
+                for (int ch = 0; ch < 16; ch++) {
+                    __atomic_store_n(&channel_samples[ch], cmd.kit[ch], __ATOMIC_RELEASE);
+                }
+                __atomic_add_fetch(&kits_applied, 1, __ATOMIC_RELEASE);
+                break;
+        }
+    }
+}
+
+// Apply queued MIDI events (audio thread only)
+static void process_queued_events(void) {
+    midi_event_t events[64];
+    size_t available = jack_ringbuffer_read_space(event_ring) / sizeof(midi_event_t);
+    
+    while (available > 0) {
+        size_t count = available < 64 ? available : 64;
+        jack_ringbuffer_read(event_ring, (char*)events, count * sizeof(midi_event_t));
+        available -= count;
+        
+        for (size_t i = 0; i < count; i++) {
+            const midi_event_t *e = &events[i];
+            
+            switch (e->type) {
+                case MIDI_EVENT_NOTE_ON: {
+                    audio_sample_t *sample = __atomic_load_n(&channel_samples[e->channel & 0x0F],
+                                                             __ATOMIC_ACQUIRE);
+                    if (sample) {
+                        // Voice ids are shared with audio_engine_trigger_sample
+                        int voice_id = __atomic_fetch_add(&next_voice_id, 1, __ATOMIC_RELAXED);
+                        start_voice(sample, e->data2 / 127.0f, voice_id, e->channel, e->data1, 0);
+                    }
+                    break;
+                }
+                
+                case MIDI_EVENT_NOTE_OFF:
+                    release_note(e->channel, e->data1, 0);
+                    break;
+                
+                case MIDI_EVENT_PITCH:
+                case MIDI_EVENT_CC:
+                case MIDI_EVENT_PRESSURE:
+                case MIDI_EVENT_KEY_PRESSURE:
+                    apply_controller_event(e);
+                    break;
+                
+                default:
+                    // Other events are not used yet
+                    break;
+            }
+        }
+    }
+}
+
+// Register the engine parameters with their defaults and smoothing times
+static void register_parameters(void) {
+    char name[PARAMS_MAX_NAME];
+    
+    params_init();
+    params_register(ENGINE_PARAM_MASTER_GAIN, "master_gain", 0.0f, 1.0f, engine_config.master_gain, 20.0f);
+    params_register(ENGINE_PARAM_REVERB_RETURN, "reverb_return", 0.0f, 127.0f, 64.0f, 20.0f);
+    
+    // Named by MIDI channel (1-16)
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        snprintf(name, sizeof(name), "ch%d_filter_cutoff", ch + 1);
+        params_register(ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_FILTER_CUTOFF), name,
+                        0.0f, FILTER_VALUE_MAX, FILTER_VALUE_MAX, 30.0f);
+        snprintf(name, sizeof(name), "ch%d_filter_resonance", ch + 1);
+        params_register(ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_FILTER_RESONANCE), name,
+                        0.0f, FILTER_VALUE_MAX, 0.0f, 30.0f);
+        snprintf(name, sizeof(name), "ch%d_reverb_send", ch + 1);
+        params_register(ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_REVERB_SEND), name,
+                        0.0f, 127.0f, 0.0f, 20.0f);
+        snprintf(name, sizeof(name), "ch%d_bitcrush", ch + 1);
+        params_register(ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_BITCRUSH), name,
+                        0.0f, EFFECT_VALUE_MAX, 0.0f, 0.0f);
     }
 }
 
@@ -80,13 +796,80 @@ int audio_engine_init(audio_engine_config_t *config) {
         engine_config = *config;
     }
     
+    if (engine_config.max_voices < 1 || engine_config.max_voices > MAX_VOICES) {
+        engine_config.max_voices = MAX_VOICES;
+    }
+    
     printf("Initializing audio engine...\n");
-    printf("Max voices: %d\n", engine_config.max_voices);
+    printf("Max voices: %d (of %d)\n", engine_config.max_voices, MAX_VOICES);
     printf("Master gain: %.2f\n", engine_config.master_gain);
     printf("Auto gain control: %s\n", engine_config.auto_gain_control ? "enabled" : "disabled");
     
     // Initialize voice management
     init_voices();
+    limiter_init(&output_limiter, LIMITER_DEFAULT_CEILING,
+                 LIMITER_DEFAULT_RELEASE_MS, LIMITER_DEFAULT_SMOOTHING_MS);
+    limiter_set_input_gain(&output_limiter, engine_config.master_gain);
+    unlimited_gain = engine_config.master_gain;
+    register_parameters();
+    
+    // Render threads besides the audio thread (sized before the buffers below)
+    render_threads = 1;
+    if (engine_config.render_threads > 1) {
+        int threads = engine_config.render_threads < ENGINE_RENDER_MAX_THREADS ?
+                      engine_config.render_threads : ENGINE_RENDER_MAX_THREADS;
+        if (worker_pool_start(threads - 1) == 0) {
+            render_threads = worker_pool_get_threads() + 1;
+        } else {
+            printf("Warning: Rendering voices on the audio thread only\n");
+        }
+    }
+    printf("Render threads: %d\n", render_threads);
+    
+    // Cache JACK ports and format; callbacks keep them current afterwards
+    output_ports[0] = jack_client_get_output_port(0);
+    output_ports[1] = jack_client_get_output_port(1);
+    
+    int sample_rate = jack_client_get_sample_rate();
+    int buffer_size = jack_client_get_buffer_size();
+    audio_engine_sample_rate_changed(sample_rate > 0 ? sample_rate : 48000, NULL);
+    applied_sample_rate = engine_sample_rate;
+    
+    // Every channel bus gets the same insert chain, bypassed until configured
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        bus_add_insert(&channel_buses[ch], EFFECT_BITCRUSH, 0, applied_sample_rate);
+        channel_filters[ch].mode = FILTER_LOWPASS;
+        channel_filters[ch].cutoff = FILTER_VALUE_MAX;
+        channel_filters[ch].resonance = 0.0f;
+        channel_envelopes[ch].attack_ms = 10.0f;
+        channel_envelopes[ch].release_ms = 500.0f;
+        channel_ranges[ch].start = 0.0f;
+        channel_ranges[ch].end = 1.0f;
+        channel_mods[ch].bend = 0.0f;
+        channel_mods[ch].mod_wheel = 0.0f;
+        channel_mods[ch].pressure = 0.0f;
+        channel_mods[ch].bend_ratio = 1.0f;
+        channel_mods[ch].bend_changed = 0;
+        channel_mods[ch].cutoff_changed = 0;
+    }
+    voice_filter_init(&filter_bank, applied_sample_rate);
+    if (audio_engine_buffer_size_changed(buffer_size > 0 ? buffer_size : 1024, NULL) < 0) {
+        return -1;
+    }
+    
+    // Create event and command queues (locked in RAM, read by the audio thread)
+    event_ring = jack_ringbuffer_create(ENGINE_EVENT_QUEUE_SIZE * sizeof(midi_event_t));
+    command_ring = jack_ringbuffer_create(ENGINE_COMMAND_QUEUE_SIZE * sizeof(engine_command_t));
+    if (!event_ring || !command_ring) {
+        printf("Error: Cannot allocate engine event queues\n");
+        if (event_ring) jack_ringbuffer_free(event_ring);
+        if (command_ring) jack_ringbuffer_free(command_ring);
+        event_ring = NULL;
+        command_ring = NULL;
+        return -1;
+    }
+    jack_ringbuffer_mlock(event_ring);
+    jack_ringbuffer_mlock(command_ring);
     
     engine_initialized = 1;
     printf("Audio engine initialized successfully\n");
@@ -102,13 +885,104 @@ void audio_engine_cleanup(void) {
     
     printf("Cleaning up audio engine...\n");
     
-    // Stop all voices
-    audio_engine_stop_all_voices();
-    
+    // The JACK client must be deactivated by now, so voices can be reset directly
     engine_initialized = 0;
+    init_voices();
+    worker_pool_stop();
+    
+    jack_ringbuffer_free(event_ring);
+    jack_ringbuffer_free(command_ring);
+    event_ring = NULL;
+    command_ring = NULL;
+    
+    for (int ch = 0; ch < 16; ch++) {
+        channel_samples[ch] = NULL;
+    }
+    
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        bus_free(&channel_buses[ch]);
+    }
+    bus_free(&master_bus);
+    bus_free(&reverb_bus);
+    for (int t = 1; t < ENGINE_RENDER_MAX_THREADS; t++) {
+        for (int b = 0; b <= ENGINE_CHANNEL_BUSES; b++) {
+            bus_free(&thread_buses[t][b]);
+        }
+    }
+    render_threads = 1;
+    reverb_cleanup();
+    free(voice_lanes);
+    voice_lanes = NULL;
+    scratch_capacity = 0;
+    
     printf("Audio engine cleaned up\n");
 }
 
+// Fold one block into a meter (NULL buffers measure silence)
+static void meter_block(meter_state_t *meter, const float *left, const float *right, jack_nframes_t nframes) {
+    const float *buffers[2] = { left, right };
+    
+    for (int c = 0; c < 2; c++) {
+        float peak = 0.0f;
+        float mean_square = 0.0f;
+        if (buffers[c]) {
+            peak = dsp_peak(buffers[c], nframes);
+            mean_square = dsp_sum_squares(buffers[c], nframes) / (float)nframes;
+        }
+        
+        float held = meter->peak[c] * meter_peak_fall;
+        meter->peak[c] = peak > held ? peak : held;
+        meter->mean_square[c] += (mean_square - meter->mean_square[c]) * meter_rms_coeff;
+    }
+}
+
+// Measure the buses and publish the meters (audio thread only, never blocks)
+static void update_meters(const int *active_voices, int active_count, jack_nframes_t nframes,
+                          const float *left_out, const float *right_out) {
+    if (applied_sample_rate != meter_sample_rate || nframes != meter_frames) {
+        float block_seconds = (float)nframes / (float)applied_sample_rate;
+        meter_peak_fall = powf(10.0f, -ENGINE_METER_PEAK_FALL_DB * block_seconds / 20.0f);
+        meter_rms_coeff = 1.0f - expf(-1000.0f * block_seconds / ENGINE_METER_RMS_MS);
+        meter_sample_rate = applied_sample_rate;
+        meter_frames = nframes;
+    }
+    
+    // Inactive buses hold stale data; they measure as silence
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        audio_bus_t *bus = &channel_buses[ch];
+        meter_block(&meter_states[ch], bus->active ? bus->left : NULL, bus->active ? bus->right : NULL, nframes);
+    }
+    meter_block(&meter_states[METER_REVERB], reverb_bus.active ? reverb_bus.left : NULL,
+                reverb_bus.active ? reverb_bus.right : NULL, nframes);
+    meter_block(&meter_states[METER_OUTPUT], left_out, right_out ? right_out : left_out, nframes);
+    
+    unsigned int seq = meters_seq;
+    __atomic_store_n(&meters_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    engine_meters_t *m = &published_meters;
+    m->frames = total_frames_processed;
+    m->active_voices = active_count;
+    memset(m->channel_voices, 0, sizeof(m->channel_voices));
+    for (int i = 0; i < active_count; i++) {
+        int channel = voices[active_voices[i]].channel;
+        if (channel >= 0) {
+            m->channel_voices[channel & 0x0F]++;
+        }
+    }
+    m->limiter_gain = limiter_get_gain(&output_limiter);
+    for (int i = 0; i < METER_COUNT; i++) {
+        engine_meter_t *out = i < ENGINE_CHANNEL_BUSES ? &m->channels[i] :
+                              (i == METER_REVERB ? &m->reverb : &m->output);
+        for (int c = 0; c < 2; c++) {
+            out->peak[c] = meter_states[i].peak[c];
+            out->rms[c] = sqrtf(meter_states[i].mean_square[c]);
+        }
+    }
+    
+    __atomic_store_n(&meters_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 // Main JACK process callback
 int audio_engine_process(jack_nframes_t nframes, void *arg) {
     (void)arg;
@@ -117,125 +991,250 @@ int audio_engine_process(jack_nframes_t nframes, void *arg) {
         return 0;
     }
     
-    // Get output buffers from JACK
+    // Port handles are cached; buffers must still be fetched every cycle
     jack_default_audio_sample_t *left_out = 
-        (jack_default_audio_sample_t*)jack_port_get_buffer(jack_client_get_output_port(0), nframes);
-    jack_default_audio_sample_t *right_out = 
-        (jack_default_audio_sample_t*)jack_port_get_buffer(jack_client_get_output_port(1), nframes);
+        (jack_default_audio_sample_t*)jack_port_get_buffer(output_ports[0], nframes);
+    jack_default_audio_sample_t *right_out = output_ports[1] ?
+        (jack_default_audio_sample_t*)jack_port_get_buffer(output_ports[1], nframes) : NULL;
     
-    // Clear output buffers
-    memset(left_out, 0, nframes * sizeof(jack_default_audio_sample_t));
-    if (right_out) {
-        memset(right_out, 0, nframes * sizeof(jack_default_audio_sample_t));
+    audio_engine_render(left_out, right_out, nframes);
+    recorder_write(left_out, right_out, nframes);
+    live_sampler_capture(nframes);
+    return 0;
+}
+
+// Render one block into the caller's buffers (right_out NULL = mono)
+// Runs in the JACK process callback, or directly for offline rendering without JACK
+void audio_engine_render(float *left_out, float *right_out, jack_nframes_t nframes) {
+    if (!engine_initialized) {
+        return;
     }
+    trace_record(TRACE_PROCESS_BEGIN, (int)nframes, 0);
     
-    // Quick check: skip processing if no voices are active
-    pthread_mutex_lock(&voice_mutex);
-    int has_active_voices = 0;
-    for (int v = 0; v < MAX_VOICES; v++) {
-        if (voices[v].active) {
-            has_active_voices = 1;
-            break;
+    // Apply everything queued by control threads since the last block
+    process_queued_commands();
+    process_queued_events();
+    apply_parameters(nframes);
+    update_modulation();
+    
+    // Keep extrapolating if the MIDI thread was publishing a tick just now
+    if (midi_clock_read(&engine_clock, applied_sample_rate) < 0 && engine_clock.running) {
+        engine_clock.beat += engine_clock.beats_per_frame * nframes;
+    }
+    
+    // Pick up a sample rate change published by the sample rate callback
+    int sample_rate = __atomic_load_n(&engine_sample_rate, __ATOMIC_ACQUIRE);
+    if (sample_rate != applied_sample_rate) {
+        applied_sample_rate = sample_rate;
+        limiter_configure(&output_limiter, sample_rate, engine_buffer_size);
+        for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+            bus_set_sample_rate(&channel_buses[ch], sample_rate);
+        }
+        bus_set_sample_rate(&master_bus, sample_rate);
+        voice_filter_set_sample_rate(&filter_bank, sample_rate);
+        for (int v = 0; v < MAX_VOICES; v++) {
+            if (voices[v].active && voices[v].sample) {
+                voices[v].sample_rate_ratio = voice_rate_ratio(voices[v].sample);
+            }
         }
     }
     
-    if (!has_active_voices) {
-        pthread_mutex_unlock(&voice_mutex);
-        total_frames_processed += nframes;
-        return 0;
+    // Sequenced notes start and stop at their exact frame within this block
+    sequencer_event_t sequenced[SEQUENCER_BLOCK_EVENTS];
+    int sequenced_count = sequencer_render(&engine_clock, applied_sample_rate, nframes,
+                                           sequenced, SEQUENCER_BLOCK_EVENTS);
+    for (int i = 0; i < sequenced_count; i++) {
+        const sequencer_event_t *e = &sequenced[i];
+        if (e->type == MIDI_EVENT_NOTE_ON) {
+            audio_sample_t *sample = __atomic_load_n(&channel_samples[e->channel & 0x0F], __ATOMIC_ACQUIRE);
+            if (sample) {
+                int voice_id = __atomic_fetch_add(&next_voice_id, 1, __ATOMIC_RELAXED);
+                start_voice(sample, e->velocity / 127.0f, voice_id, e->channel, e->note, e->offset);
+            }
+        } else {
+            release_note(e->channel, e->note, e->offset);
+        }
     }
     
-    // First pass: count active voices for efficient processing
+    // First pass: collect active voices; skip mixing if there are none
     int active_voices[MAX_VOICES];
     int active_count = 0;
     for (int v = 0; v < MAX_VOICES; v++) {
         if (voices[v].active && voices[v].sample) {
             active_voices[active_count++] = v;
+            __atomic_store_n(&voices[v].sample->last_used, total_frames_processed, __ATOMIC_RELAXED);
         }
     }
     
-    // Get current JACK sample rate for conversion
-    int jack_sample_rate = jack_client_get_sample_rate();
+    // Buses stay silent this block unless a voice mixes into them
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        bus_begin_block(&channel_buses[ch]);
+    }
+    bus_begin_block(&master_bus);
+    bus_begin_block(&reverb_bus);
     
-    // Second pass: mix only active voices
-    for (int i = 0; i < active_count; i++) {
-        int v = active_voices[i];
-        
-        audio_voice_t *voice = &voices[v];
-        audio_sample_t *sample = voice->sample;
-        
-        // Calculate sample rate ratio
-        voice->sample_rate_ratio = (float)sample->sample_rate / (float)jack_sample_rate;
-        
-        // Check if voice has finished playing
-        int int_position = (int)voice->playback_position;
-        if (int_position >= sample->frames) {
-            voice->active = 0;
-            continue;
+    // Bus buffers are sized by the buffer size callback; never mix past them
+    // With no voices, keep running until the reverb tail and limiter look-ahead have played out
+    if ((active_count == 0 && limiter_is_idle(&output_limiter) && reverb_is_idle()) ||
+        nframes > scratch_capacity) {
+        memset(left_out, 0, nframes * sizeof(jack_default_audio_sample_t));
+        if (right_out) {
+            memset(right_out, 0, nframes * sizeof(jack_default_audio_sample_t));
         }
-        
-        // Mix this voice into the output buffers
-        for (jack_nframes_t f = 0; f < nframes; f++) {
-            int_position = (int)voice->playback_position;
-            if (int_position >= sample->frames) {
-                voice->active = 0;
-                break;
+        __atomic_store_n(&total_frames_processed, total_frames_processed + nframes, __ATOMIC_RELEASE);
+        __atomic_store_n(&last_active_voices, active_count, __ATOMIC_RELAXED);
+        update_meters(active_voices, active_count, nframes, left_out, right_out);
+        trace_record(TRACE_PROCESS_END, active_count, 0);
+        return;
+    }
+    
+    // Buses are always stereo, downmixed at the output if needed
+    bus_activate(&master_bus, nframes);
+    
+    // Second pass: render the voices, spread over the render threads
+    render_job_t job;
+    job.active_voices = active_voices;
+    job.nframes = nframes;
+    int tasks = split_voices(&job, active_voices, active_count);
+    worker_pool_run(render_voice_range, &job, tasks);
+    
+    // Sum the other threads' buses into the engine's
+    for (int t = 1; t < tasks; t++) {
+        for (int b = 0; b <= ENGINE_CHANNEL_BUSES; b++) {
+            const audio_bus_t *from = &thread_buses[t][b];
+            if (!from->active) {
+                continue;
             }
+            audio_bus_t *to = b < ENGINE_CHANNEL_BUSES ? &channel_buses[b] : &master_bus;
+            bus_activate(to, nframes);
+            dsp_mix(from->left, to->left, nframes, 1.0f);
+            dsp_mix(from->right, to->right, nframes, 1.0f);
+        }
+    }
+    
+    // Run each channel bus's inserts once and sum it into master and the reverb send
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        audio_bus_t *bus = &channel_buses[ch];
+        if (bus->active) {
+            bus_process_inserts(bus, nframes);
+            dsp_mix(bus->left, master_bus.left, nframes, 1.0f);
+            dsp_mix(bus->right, master_bus.right, nframes, 1.0f);
             
-            if (sample->channels == 1) {
-                // Mono sample
-                float sample_value = get_sample_simple(sample, int_position, 0) * voice->volume;
-                
-                left_out[f] += sample_value;
-                if (right_out) {
-                    right_out[f] += sample_value;  // Duplicate to right for stereo
-                }
-            } else {
-                // Stereo sample
-                float left = get_sample_simple(sample, int_position, 0) * voice->volume;
-                float right = get_sample_simple(sample, int_position, 1) * voice->volume;
-                
-                left_out[f] += left;
-                if (right_out) {
-                    right_out[f] += right;
-                } else {
-                    // Mono output: mix stereo to mono
-                    left_out[f] += (left + right) * 0.5f;
-                }
+            int send_id = ENGINE_PARAM_CHANNEL(ch, ENGINE_PARAM_CH_REVERB_SEND);
+            float send_from = params_previous(send_id) / 127.0f;
+            float send_to = params_value(send_id) / 127.0f;
+            if ((send_from > 0.0f || send_to > 0.0f) && reverb_is_enabled()) {
+                bus_activate(&reverb_bus, nframes);
+                dsp_mix_ramp(bus->left, reverb_bus.left, nframes, send_from, send_to);
+                dsp_mix_ramp(bus->right, reverb_bus.right, nframes, send_from, send_to);
             }
-            
-            // Advance voice playback position with sample rate conversion
-            voice->playback_position += voice->sample_rate_ratio;
         }
     }
     
-    pthread_mutex_unlock(&voice_mutex);
+    // Reverb runs every block while enabled so its tail keeps playing after the send stops
+    reverb_process(reverb_bus.active ? reverb_bus.left : NULL, reverb_bus.active ? reverb_bus.right : NULL,
+                   master_bus.left, master_bus.right, nframes,
+                   params_value(ENGINE_PARAM_REVERB_RETURN) / 127.0f);
+    bus_process_inserts(&master_bus, nframes);
     
-    // Apply master gain and auto gain control
-    float gain = engine_config.master_gain;
+    // Master gain and auto gain control; the limiter ramps towards it per sample
+    float gain = params_value(ENGINE_PARAM_MASTER_GAIN);
     if (engine_config.auto_gain_control && active_count > 1) {
         gain *= (1.0f / sqrtf(active_count));  // Reduce gain with more voices
     }
+    limiter_set_input_gain(&output_limiter, gain);
     
-    // Apply gain and soft limiting
-    for (jack_nframes_t f = 0; f < nframes; f++) {
-        left_out[f] *= gain;
-        
-        // Soft limiting to prevent clipping
-        if (left_out[f] > 0.95f) left_out[f] = 0.95f;
-        else if (left_out[f] < -0.95f) left_out[f] = -0.95f;
-        
-        if (right_out) {
-            right_out[f] *= gain;
-            if (right_out[f] > 0.95f) right_out[f] = 0.95f;
-            else if (right_out[f] < -0.95f) right_out[f] = -0.95f;
+    // Without the limiter (offline stems, limited after summing) only the gain is applied
+    if (!engine_config.limit_output) {
+        dsp_apply_ramp(master_bus.left, master_bus.left, nframes, unlimited_gain, gain);
+        dsp_apply_ramp(master_bus.right, master_bus.right, nframes, unlimited_gain, gain);
+        unlimited_gain = gain;
+        for (jack_nframes_t f = 0; f < nframes; f++) {
+            if (right_out) {
+                left_out[f] = master_bus.left[f];
+                right_out[f] = master_bus.right[f];
+            } else {
+                left_out[f] = (master_bus.left[f] + master_bus.right[f]) * 0.5f;
+            }
         }
+    } else if (right_out) {
+        limiter_process(&output_limiter, master_bus.left, master_bus.right, left_out, right_out, nframes);
+    } else {
+        for (jack_nframes_t f = 0; f < nframes; f++) {
+            master_bus.left[f] = (master_bus.left[f] + master_bus.right[f]) * 0.5f;
+        }
+        limiter_process(&output_limiter, master_bus.left, NULL, left_out, NULL, nframes);
     }
     
     // Update statistics
-    total_frames_processed += nframes;
-    last_active_voices = active_count;
+    __atomic_store_n(&total_frames_processed, total_frames_processed + nframes, __ATOMIC_RELEASE);
+    __atomic_store_n(&last_active_voices, active_count, __ATOMIC_RELAXED);
+    update_meters(active_voices, active_count, nframes, left_out, right_out);
+    trace_record(TRACE_PROCESS_END, active_count, 0);
+}
+
+// JACK buffer size callback: resize the bus and voice filter buffers
+// JACK stops the driver during the change, so allocating here is safe
+int audio_engine_buffer_size_changed(jack_nframes_t nframes, void *arg) {
+    (void)arg;
     
+    if (nframes > scratch_capacity) {
+        for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+            if (bus_allocate(&channel_buses[ch], nframes) < 0) {
+                return -1;
+            }
+        }
+        if (bus_allocate(&master_bus, nframes) < 0 || bus_allocate(&reverb_bus, nframes) < 0) {
+            return -1;
+        }
+        for (int t = 1; t < render_threads; t++) {
+            for (int b = 0; b <= ENGINE_CHANNEL_BUSES; b++) {
+                if (bus_allocate(&thread_buses[t][b], nframes) < 0) {
+                    return -1;
+                }
+            }
+        }
+        
+        size_t lanes_size = (size_t)render_threads * nframes * VOICE_LANES * sizeof(float);
+        float *new_lanes = NULL;
+        if (posix_memalign((void**)&new_lanes, DSP_ALIGNMENT, lanes_size) != 0) {
+            printf("Error: Cannot allocate voice filter buffers for %u frames\n", nframes);
+            return -1;
+        }
+        memset(new_lanes, 0, lanes_size);
+        free(voice_lanes);
+        voice_lanes = new_lanes;
+        scratch_capacity = nframes;
+    }
+    
+    // Shrinking keeps the larger buffers, so dropping the period never allocates
+    engine_buffer_size = nframes;
+    
+    // Reverb partitions are one period long
+    reverb_set_block_size(nframes);
+    
+    // Look-ahead sub-blocks must divide the new period
+    limiter_configure(&output_limiter, __atomic_load_n(&engine_sample_rate, __ATOMIC_ACQUIRE), nframes);
+    return 0;
+}
+
+// JACK sample rate callback: the audio thread recomputes voice ratios next block
+int audio_engine_sample_rate_changed(jack_nframes_t sample_rate, void *arg) {
+    (void)arg;
+    
+    if (sample_rate == 0) {
+        return -1;
+    }
+    __atomic_store_n(&engine_sample_rate, (int)sample_rate, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// JACK xrun callback (notification thread, not real-time)
+int audio_engine_xrun(void *arg) {
+    (void)arg;
+    
+    printf("Warning: JACK xrun #%lu (%d active voices, %u frame buffer)\n",
+           jack_client_get_xrun_count(), audio_engine_get_active_voices(), engine_buffer_size);
     return 0;
 }
 
@@ -246,80 +1245,214 @@ void audio_engine_shutdown(void *arg) {
     audio_engine_stop_all_voices();
 }
 
+// Push a command to the audio thread
+static int queue_command(const engine_command_t *cmd) {
+    int result = 0;
+    
+    pthread_mutex_lock(&queue_mutex);
+    if (jack_ringbuffer_write_space(command_ring) >= sizeof(*cmd)) {
+        jack_ringbuffer_write(command_ring, (const char*)cmd, sizeof(*cmd));
+    } else {
+        result = -1;
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    
+    return result;
+}
+
+// Queue a batch of MIDI events for the audio thread with a single publish
+int audio_engine_queue_events(const midi_event_t *events, int count) {
+    if (!engine_initialized || !events || count <= 0) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&queue_mutex);
+    
+    // Queue as many whole events as fit; the rest are dropped
+    int space = jack_ringbuffer_write_space(event_ring) / sizeof(midi_event_t);
+    int queued = count < space ? count : space;
+    if (queued > 0) {
+        jack_ringbuffer_write(event_ring, (const char*)events, queued * sizeof(midi_event_t));
+    }
+    __atomic_add_fetch(&events_dropped, count - queued, __ATOMIC_RELAXED);
+    trace_record(TRACE_MIDI_QUEUED, queued, count - queued);
+    
+    pthread_mutex_unlock(&queue_mutex);
+    
+    return queued;
+}
+
+// Set the sample played by a MIDI channel (-1 for all channels)
+void audio_engine_set_channel_sample(int channel, audio_sample_t *sample) {
+    for (int ch = 0; ch < 16; ch++) {
+        if (channel < 0 || channel == ch) {
+            __atomic_store_n(&channel_samples[ch], sample, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// Swap the samples of all 16 channels at the next block ('samples' must stay valid until
+// audio_engine_get_kits_applied() has counted the swap)
+int audio_engine_set_kit(audio_sample_t *const *samples) {
+    if (!engine_initialized || !samples) {
+        return -1;
+    }
+    
+    engine_command_t cmd = { .type = ENGINE_CMD_SET_KIT, .kit = samples };
+    return queue_command(&cmd);
+}
+
+// Kit swaps applied by the audio thread so far
+unsigned long audio_engine_get_kits_applied(void) {
+    return __atomic_load_n(&kits_applied, __ATOMIC_ACQUIRE);
+}
+
 // Trigger a sample to play
 int audio_engine_trigger_sample(audio_sample_t *sample, float volume) {
     if (!engine_initialized || !sample) {
         return -1;
     }
     
-    pthread_mutex_lock(&voice_mutex);
+    engine_command_t cmd = {
+        .type = ENGINE_CMD_TRIGGER,
+        .sample = sample,
+        .volume = volume,
+        .voice_id = __atomic_fetch_add(&next_voice_id, 1, __ATOMIC_RELAXED)
+    };
     
-    int voice_slot = find_free_voice();
-    if (voice_slot < 0) {
-        pthread_mutex_unlock(&voice_mutex);
-        printf("Warning: No free voices available\n");
+    if (queue_command(&cmd) < 0) {
+        printf("Warning: Engine command queue full\n");
         return -1;
     }
     
-    // Setup new voice
-    voices[voice_slot].sample = sample;
-    voices[voice_slot].playback_position = 0.0f;
-    voices[voice_slot].sample_rate_ratio = 1.0f;  // Will be calculated in process callback
-    voices[voice_slot].volume = volume;
-    voices[voice_slot].voice_id = next_voice_id++;
-    voices[voice_slot].active = 1;
-    
-    int voice_id = voices[voice_slot].voice_id;
-    
-    pthread_mutex_unlock(&voice_mutex);
-    
-    printf("Triggered sample (Voice ID: %d, Slot: %d)\n", voice_id, voice_slot);
+    printf("Triggered sample (Voice ID: %d)\n", cmd.voice_id);
     printf("  Sample: %d frames, %d channels, %d Hz\n", 
            sample->frames, sample->channels, sample->sample_rate);
     
-    return voice_id;
+    return cmd.voice_id;
 }
 
 // Stop a specific voice
 void audio_engine_stop_voice(int voice_id) {
-    pthread_mutex_lock(&voice_mutex);
-    
-    for (int i = 0; i < MAX_VOICES; i++) {
-        if (voices[i].active && voices[i].voice_id == voice_id) {
-            voices[i].active = 0;
-            printf("Stopped voice ID: %d\n", voice_id);
-            break;
-        }
+    if (!engine_initialized) {
+        return;
     }
     
-    pthread_mutex_unlock(&voice_mutex);
+    engine_command_t cmd = { .type = ENGINE_CMD_STOP_VOICE, .voice_id = voice_id };
+    if (queue_command(&cmd) == 0) {
+        printf("Stopped voice ID: %d\n", voice_id);
+    }
 }
 
 // Stop all voices
 void audio_engine_stop_all_voices(void) {
-    pthread_mutex_lock(&voice_mutex);
+    if (!engine_initialized) {
+        return;
+    }
     
-    for (int i = 0; i < MAX_VOICES; i++) {
-        voices[i].active = 0;
+    engine_command_t cmd = { .type = ENGINE_CMD_STOP_ALL };
+    if (queue_command(&cmd) == 0) {
+        printf("Stopped all voices\n");
+    }
+}
+
+// Stop every voice playing a sample (before its data is overwritten)
+int audio_engine_stop_sample(audio_sample_t *sample) {
+    if (!engine_initialized || !sample) {
+        return -1;
     }
     
-    pthread_mutex_unlock(&voice_mutex);
-    printf("Stopped all voices\n");
+    engine_command_t cmd = { .type = ENGINE_CMD_STOP_SAMPLE, .sample = sample };
+    return queue_command(&cmd);
 }
 
-// Get number of active voices
-int audio_engine_get_active_voices(void) {
-    pthread_mutex_lock(&voice_mutex);
+// Set an insert effect parameter on a channel bus
+int audio_engine_set_bus_effect(int channel, int effect_type, int value) {
+    // Only the channel buses carry inserts (a bitcrusher each)
+    if (!engine_initialized || channel < 0 || channel >= ENGINE_CHANNEL_BUSES ||
+        effect_type != EFFECT_BITCRUSH) {
+        return -1;
+    }
     
-    int count = 0;
-    for (int i = 0; i < MAX_VOICES; i++) {
-        if (voices[i].active) {
-            count++;
-        }
+    return params_set(ENGINE_PARAM_CHANNEL(channel, ENGINE_PARAM_CH_BITCRUSH), (float)value);
+}
+
+// Set the filter of a MIDI channel's voices (filter_mode_t, cutoff/resonance 0-127)
+int audio_engine_set_channel_filter(int channel, int mode, int cutoff, int resonance) {
+    if (!engine_initialized || channel < 0 || channel >= ENGINE_CHANNEL_BUSES) {
+        return -1;
+    }
+    
+    // The mode switches at the next block; cutoff and resonance glide
+    engine_command_t cmd = { .type = ENGINE_CMD_SET_FILTER, .bus = channel, .effect_type = mode };
+    if (queue_command(&cmd) < 0) {
+        return -1;
+    }
+    
+    params_set(ENGINE_PARAM_CHANNEL(channel, ENGINE_PARAM_CH_FILTER_CUTOFF), (float)cutoff);
+    params_set(ENGINE_PARAM_CHANNEL(channel, ENGINE_PARAM_CH_FILTER_RESONANCE), (float)resonance);
+    return 0;
+}
+
+// Set the attack/release times for a channel's looped samples
+int audio_engine_set_channel_envelope(int channel, int attack_ms, int release_ms) {
+    if (!engine_initialized || channel < 0 || channel >= ENGINE_CHANNEL_BUSES) {
+        return -1;
     }
     
-    pthread_mutex_unlock(&voice_mutex);
-    return count;
+    engine_command_t cmd = {
+        .type = ENGINE_CMD_SET_ENVELOPE,
+        .bus = channel,
+        .value = attack_ms < 0 ? 0 : attack_ms,
+        .value2 = release_ms < 0 ? 0 : release_ms
+    };
+    
+    return queue_command(&cmd);
+}
+
+// Set the start/end offsets of a channel's samples (0-127 of the sample length)
+int audio_engine_set_channel_range(int channel, int start, int end) {
+    if (!engine_initialized || channel < 0 || channel >= ENGINE_CHANNEL_BUSES) {
+        return -1;
+    }
+    
+    if (start < 0) start = 0;
+    if (end > 127) end = 127;
+    if (end <= start) {
+        return -1;
+    }
+    
+    engine_command_t cmd = { .type = ENGINE_CMD_SET_RANGE, .bus = channel, .value = start, .value2 = end };
+    return queue_command(&cmd);
+}
+
+// Set a channel's reverb send level, or the reverb return level for channel -1 (0-127)
+int audio_engine_set_reverb_send(int channel, int value) {
+    if (!engine_initialized || channel < -1 || channel >= ENGINE_CHANNEL_BUSES) {
+        return -1;
+    }
+    
+    int id = channel >= 0 ? ENGINE_PARAM_CHANNEL(channel, ENGINE_PARAM_CH_REVERB_SEND) : ENGINE_PARAM_REVERB_RETURN;
+    return params_set(id, (float)value);
+}
+
+// Load the reverb impulse response (copied; must be called before JACK is activated)
+// The IR is resampled to the current JACK rate once, here
+int audio_engine_set_reverb_ir(const audio_sample_t *ir, float max_seconds) {
+    if (!engine_initialized || jack_client_is_active()) {
+        return -1;
+    }
+    return reverb_init(ir, __atomic_load_n(&engine_sample_rate, __ATOMIC_ACQUIRE), engine_buffer_size, max_seconds);
+}
+
+// Get number of active voices (as of the last processed block)
+int audio_engine_get_active_voices(void) {
+    return __atomic_load_n(&last_active_voices, __ATOMIC_RELAXED);
+}
+
+// Frames rendered so far; advances once each block has finished with its voices
+unsigned long audio_engine_get_frames_processed(void) {
+    return __atomic_load_n(&total_frames_processed, __ATOMIC_ACQUIRE);
 }
 
 // Legacy function for compatibility
@@ -327,27 +1460,40 @@ int audio_engine_play_sample(audio_sample_t *sample) {
     return audio_engine_trigger_sample(sample, 1.0f);
 }
 
-// Set master gain
+// Set master gain (any thread; the audio thread glides to it)
 int audio_engine_set_master_gain(float gain) {
-    if (gain < 0.0f || gain > 1.0f) {
+    if (!engine_initialized || gain < 0.0f || gain > 1.0f) {
         return -1;
     }
     
-    engine_config.master_gain = gain;
-    return 0;
+    return params_set(ENGINE_PARAM_MASTER_GAIN, gain);
 }
 
-// Get master gain
+// Get master gain (last value set)
 float audio_engine_get_master_gain(void) {
-    return engine_config.master_gain;
+    return engine_initialized ? params_get(ENGINE_PARAM_MASTER_GAIN) : engine_config.master_gain;
 }
 
 // Free audio sample
 void audio_sample_free(audio_sample_t *sample) {
     if (sample) {
-        if (sample->data) {
+        // A background mip build reads the data; stop it first
+        __atomic_store_n(&sample->mip_cancel, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&sample->mip_building, __ATOMIC_ACQUIRE)) {
+            usleep(1000);
+        }
+        
+        if (sample->cached) {
+            sample_cache_remove(sample);
+        } else if (!sample->pooled) {
             free(sample->data);
         }
+        if (!sample->pooled) {
+            free(sample->zero_crossings);
+        }
+        for (int i = 0; i < sample->mip_count; i++) {
+            free(sample->mip_data[i]);
+        }
         free(sample);
     }
 }
@@ -365,6 +1511,15 @@ audio_sample_t* audio_sample_clone(audio_sample_t *sample) {
     
     *clone = *sample;
     
+    // Mip levels belong to the original; the clone plays from its own data only
+    memset(clone->mip_data, 0, sizeof(clone->mip_data));
+    clone->mip_count = 0;
+    clone->mip_building = 0;
+    clone->mip_cancel = 0;
+    clone->pooled = 0;
+    clone->cached = 0;
+    clone->evicted_frame = 0;
+    
     size_t data_size = sample->frames * sample->channels * sizeof(float);
     clone->data = malloc(data_size);
     if (!clone->data) {
@@ -373,25 +1528,112 @@ audio_sample_t* audio_sample_clone(audio_sample_t *sample) {
     }
     
     memcpy(clone->data, sample->data, data_size);
+    
+    if (sample->zero_crossings) {
+        size_t index_size = sample->zero_crossing_count * sizeof(int);
+        clone->zero_crossings = malloc(index_size);
+        if (!clone->zero_crossings) {
+            free(clone->data);
+            free(clone);
+            return NULL;
+        }
+        memcpy(clone->zero_crossings, sample->zero_crossings, index_size);
+    }
     return clone;
 }
 
+// Nearest rising zero crossing to a frame (binary search, real-time safe)
+int audio_sample_snap_to_zero_crossing(const audio_sample_t *sample, int frame) {
+    const int *index = sample->zero_crossings;
+    int count = sample->zero_crossing_count;
+    if (!index || count == 0) {
+        return frame;
+    }
+    
+    // First crossing at or after the frame
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (index[mid] < frame) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    if (low == count) {
+        return index[count - 1];
+    }
+    if (low > 0 && frame - index[low - 1] < index[low] - frame) {
+        return index[low - 1];
+    }
+    return index[low];
+}
+
+// Copy the meters of the last processed block (never blocks the audio thread)
+// Returns -1 if no consistent copy could be taken (the audio thread kept publishing)
+int audio_engine_read_meters(engine_meters_t *meters) {
+    for (int attempt = 0; attempt < 100; attempt++) {
+        unsigned int seq = __atomic_load_n(&meters_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        
+        memcpy(meters, &published_meters, sizeof(*meters));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&meters_seq, __ATOMIC_RELAXED) == seq) {
+            meters->events_dropped = __atomic_load_n(&events_dropped, __ATOMIC_RELAXED);
+            meters->notes_dropped = __atomic_load_n(&notes_dropped, __ATOMIC_RELAXED);
+            meters->sample_hits = __atomic_load_n(&sample_hits, __ATOMIC_RELAXED);
+            meters->sample_misses = __atomic_load_n(&sample_misses, __ATOMIC_RELAXED);
+            return 0;
+        }
+    }
+    return -1;
+}
+
 // Print engine statistics
 void audio_engine_print_stats(void) {
     printf("Audio Engine Statistics:\n");
     printf("  Total frames processed: %lu\n", total_frames_processed);
-    printf("  Active voices: %d\n", last_active_voices);
-    printf("  Master gain: %.2f\n", engine_config.master_gain);
+    printf("  Active voices: %d\n", audio_engine_get_active_voices());
+    printf("  Events dropped (queue full): %lu\n", __atomic_load_n(&events_dropped, __ATOMIC_RELAXED));
+    printf("  Notes dropped (no free voice): %lu\n", __atomic_load_n(&notes_dropped, __ATOMIC_RELAXED));
+    printf("  Master gain: %.2f\n", audio_engine_get_master_gain());
     printf("  Auto gain control: %s\n", engine_config.auto_gain_control ? "enabled" : "disabled");
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        audio_bus_t *bus = &channel_buses[ch];
+        for (int i = 0; i < bus->insert_count; i++) {
+            if (!bus->inserts[i].bypassed) {
+                printf("  Channel %d insert: %s %d\n", ch + 1,
+                       effect_type_name(bus->inserts[i].type), bus->inserts[i].value);
+            }
+        }
+        if (channel_filters[ch].mode != FILTER_LOWPASS || channel_filters[ch].cutoff < FILTER_VALUE_MAX ||
+            channel_filters[ch].resonance > 0.0f) {
+            printf("  Channel %d filter: %s cutoff %.0f resonance %.0f\n", ch + 1,
+                   voice_filter_mode_name(channel_filters[ch].mode),
+                   channel_filters[ch].cutoff, channel_filters[ch].resonance);
+        }
+    }
+    reverb_print_stats();
+    printf("  CC mappings:\n");
+    params_print_cc_map();
+    printf("  Limiter: ceiling %.2f, %d frame look-ahead, gain %.2f\n",
+           output_limiter.ceiling, output_limiter.lookahead, limiter_get_gain(&output_limiter));
+    
+    printf("  Engine sample rate: %d Hz\n", engine_sample_rate);
+    printf("  Engine buffer size: %u frames (scratch %u)\n", engine_buffer_size, scratch_capacity);
     
     if (jack_client_is_active()) {
-        printf("  JACK sample rate: %d Hz\n", jack_client_get_sample_rate());
-        printf("  JACK buffer size: %d frames\n", jack_client_get_buffer_size());
+        printf("  JACK xruns: %lu\n", jack_client_get_xrun_count());
     }
 }
 
 // Get CPU load (placeholder)
 int audio_engine_get_cpu_load(void) {
     // Could implement actual CPU monitoring here
-    return last_active_voices * 10; // Rough estimate
+    return audio_engine_get_active_voices() * 10; // Rough estimate
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define AUDIO_ENGINE_H
 
 #include <jack/jack.h>
+#include "midi.h"
+
+// Half-rate mip levels kept per sample at most (level k is band-limited and decimated by 2^k)
+#define AUDIO_SAMPLE_MAX_MIP_LEVELS 4
 
 // Audio sample structure (same as before)
 typedef struct {
@@ -9,6 +13,21 @@ typedef struct {
     int frames;         // Number of frames (samples per channel)
     int channels;       // Number of channels (1=mono, 2=stereo)
     int sample_rate;    // Sample rate in Hz
+    int loop_start;     // Sustain loop start frame
+    int loop_end;       // Sustain loop end frame (exclusive, 0 = one-shot)
+    float peak;         // Peak level (linear, measured at load)
+    float rms;          // RMS level (measured at load)
+    int *zero_crossings;        // Rising zero crossings (ascending frame numbers, may be NULL)
+    int zero_crossing_count;
+    float *mip_data[AUDIO_SAMPLE_MAX_MIP_LEVELS];   // Levels 1..mip_count, same layout as data
+    int mip_count;              // Levels ready to read (published after their data)
+    int mip_building;           // Background build running (audio_sample_free waits for it)
+    int mip_cancel;             // Asks the background build to stop
+    int pooled;                 // data and zero_crossings live in the shared sample pool (not freed)
+    int cached;                 // data is mapped by the sample cache, which may evict its tail
+    int evicted_frame;          // First frame that is not resident (0 = all resident)
+    int file_offset;            // Source file frame of data[0] (leading silence trimmed at load)
+    unsigned long last_used;    // Engine frame count when a voice last played it (cache LRU)
 } audio_sample_t;
 
 // Audio voice structure for polyphonic playback
@@ -19,6 +38,21 @@ typedef struct {
     float volume;               // Voice volume (0.0 - 1.0)
     int active;                 // 1 if voice is active, 0 if free
     int voice_id;               // Unique voice identifier
+    int channel;                // MIDI channel that started the voice (-1 if none)
+    int note;                   // MIDI note that started the voice (-1 if none)
+    float envelope;             // Envelope level (looped samples; one-shots stay at 1.0)
+    float envelope_step;        // Envelope change per frame
+    int releasing;              // Note released; the voice ends when the envelope reaches 0
+    float end_position;         // One-shot end frame (sample end or channel end offset)
+    float pressure;             // Poly aftertouch (0.0 - 1.0)
+    float pitch_mod;            // Pitch multiplier from modulation (ramped per block)
+    float pitch_mod_target;
+    float gain_mod;             // Gain multiplier from modulation (ramped per block)
+    float gain_mod_target;
+    int start_offset;           // Frames of the current block before the voice starts
+    int release_offset;         // Frame of the current block where the release starts (-1 = none)
+    float release_step;         // Envelope step from release_offset on
+    float eviction_fade;        // Gain ahead of an evicted tail (recovers once the tail is back)
 } audio_voice_t;
 
 // Audio engine configuration
@@ -26,9 +60,78 @@ typedef struct {
     int max_voices;             // Maximum number of simultaneous voices
     float master_gain;          // Master volume (0.0 - 1.0)
     int auto_gain_control;      // Enable automatic gain control for polyphony
+    float pitch_bend_range;     // Pitch bend range in semitones
+    float mod_wheel_cutoff;     // Mod wheel filter cutoff offset at full travel (0-127 units)
+    float aftertouch_volume;    // Gain added by full aftertouch (0.0 = off)
+    int limit_output;           // Output limiter (off for offline stems that are limited after summing)
+    int render_threads;         // Threads rendering voices, including the audio thread (1 = single-threaded)
 } audio_engine_config_t;
 
-#define MAX_VOICES 8
+#define MAX_VOICES 16
+
+// Multi-core voice rendering: most threads per block, and the fewest voices
+// per thread that are worth the hand-off (fewer voices render single-threaded)
+#define ENGINE_RENDER_MAX_THREADS 4
+#define ENGINE_RENDER_MIN_VOICES 4
+
+// MIDI controller used for the mod wheel
+#define MIDI_CC_MOD_WHEEL 1
+
+// Queue capacities (events/commands pending between two audio blocks)
+#define ENGINE_EVENT_QUEUE_SIZE 1024
+#define ENGINE_COMMAND_QUEUE_SIZE 64
+
+// One mix bus per MIDI channel, summed into the master bus
+#define ENGINE_CHANNEL_BUSES 16
+
+// Engine parameters in the parameter store (params.h), settable from any
+// control thread and mappable to MIDI CCs. Channel parameters are laid out
+// per MIDI channel: ENGINE_PARAM_CHANNEL(channel, ENGINE_PARAM_CH_*)
+enum {
+    ENGINE_PARAM_MASTER_GAIN = 0,       // 0.0 - 1.0
+    ENGINE_PARAM_REVERB_RETURN,         // 0-127
+    ENGINE_PARAM_CHANNEL_BASE
+};
+
+enum {
+    ENGINE_PARAM_CH_FILTER_CUTOFF = 0,  // 0-127
+    ENGINE_PARAM_CH_FILTER_RESONANCE,   // 0-127
+    ENGINE_PARAM_CH_REVERB_SEND,        // 0-127
+    ENGINE_PARAM_CH_BITCRUSH,           // 0-127
+    ENGINE_PARAM_CH_COUNT
+};
+
+#define ENGINE_PARAM_CHANNEL(channel, param) \
+    (ENGINE_PARAM_CHANNEL_BASE + (channel) * ENGINE_PARAM_CH_COUNT + (param))
+#define ENGINE_PARAM_COUNT ENGINE_PARAM_CHANNEL(ENGINE_CHANNEL_BUSES, 0)
+
+// Meter ballistics: peaks fall back at this rate, RMS is averaged over this window
+#define ENGINE_METER_PEAK_FALL_DB 20.0f     // dB per second
+#define ENGINE_METER_RMS_MS 300.0f
+
+// Voices reaching the evicted tail of a cached sample fade out over this long instead of cutting off
+#define ENGINE_EVICTION_FADE_MS 5.0f
+
+// Levels of one stereo bus (linear)
+typedef struct {
+    float peak[2];
+    float rms[2];
+} engine_meter_t;
+
+// Meters and counters published by the audio thread once per block
+typedef struct {
+    unsigned long frames;                           // Frames processed
+    unsigned long events_dropped;                   // MIDI events lost to a full queue
+    unsigned long notes_dropped;                    // Notes lost to a full voice pool
+    unsigned long sample_hits;                      // Note-ons of cached samples that were fully resident
+    unsigned long sample_misses;                    // Note-ons that found the tail evicted
+    int active_voices;
+    int channel_voices[ENGINE_CHANNEL_BUSES];       // Voices per MIDI channel
+    float limiter_gain;                             // Limiter gain reduction (1.0 = none)
+    engine_meter_t channels[ENGINE_CHANNEL_BUSES];  // Channel buses, post insert
+    engine_meter_t reverb;                          // Reverb send
+    engine_meter_t output;                          // JACK outputs, post limiter
+} engine_meters_t;
 
 // Audio engine functions
 int audio_engine_init(audio_engine_config_t *config);
@@ -36,13 +139,42 @@ void audio_engine_cleanup(void);
 
 // JACK integration
 int audio_engine_process(jack_nframes_t nframes, void *arg);
+void audio_engine_render(float *left_out, float *right_out, jack_nframes_t nframes);
 void audio_engine_shutdown(void *arg);
+int audio_engine_buffer_size_changed(jack_nframes_t nframes, void *arg);
+int audio_engine_sample_rate_changed(jack_nframes_t sample_rate, void *arg);
+int audio_engine_xrun(void *arg);
 
 // Voice management
 int audio_engine_trigger_sample(audio_sample_t *sample, float volume);
 void audio_engine_stop_voice(int voice_id);
 void audio_engine_stop_all_voices(void);
+int audio_engine_stop_sample(audio_sample_t *sample);
 int audio_engine_get_active_voices(void);
+unsigned long audio_engine_get_frames_processed(void);
+
+// MIDI event queue (lock-free, applied by the audio thread at the next block)
+int audio_engine_queue_events(const midi_event_t *events, int count);
+void audio_engine_set_channel_sample(int channel, audio_sample_t *sample);
+int audio_engine_set_kit(audio_sample_t *const *samples);
+unsigned long audio_engine_get_kits_applied(void);
+
+// Bus insert effects (effect_type_t from effects.h, value 0-127, applied at the next block)
+// These and the filter/send setters below write the parameter store
+int audio_engine_set_bus_effect(int channel, int effect_type, int value);
+
+// Per-voice filter of a MIDI channel (filter_mode_t from voice_filter.h, cutoff/resonance 0-127)
+int audio_engine_set_channel_filter(int channel, int mode, int cutoff, int resonance);
+
+// Attack/release for looped samples (sustain until note off)
+int audio_engine_set_channel_envelope(int channel, int attack_ms, int release_ms);
+
+// Start/end offsets (0-127 of the sample length, snapped to zero crossings at note-on)
+int audio_engine_set_channel_range(int channel, int start, int end);
+
+// Convolution reverb send (IR must be set before JACK activation; levels 0-127, channel -1 = return)
+int audio_engine_set_reverb_ir(const audio_sample_t *ir, float max_seconds);
+int audio_engine_set_reverb_send(int channel, int value);
 
 // Legacy compatibility
 int audio_engine_play_sample(audio_sample_t *sample);
@@ -55,8 +187,10 @@ float audio_engine_get_master_gain(void);
 // Sample management
 void audio_sample_free(audio_sample_t *sample);
 audio_sample_t* audio_sample_clone(audio_sample_t *sample);
+int audio_sample_snap_to_zero_crossing(const audio_sample_t *sample, int frame);
 
 // Statistics and monitoring
+int audio_engine_read_meters(engine_meters_t *meters);   // Any non-RT thread
 void audio_engine_print_stats(void);
 int audio_engine_get_cpu_load(void);
 
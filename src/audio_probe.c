@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+#include "audio_probe.h"
+
+// Combinations to try, in order of preference (same order as start_jack.sh)
+static const struct {
+    int sample_rate;
+    int period;
+} preferred_formats[] = {
+    { 48000, 1024 },
+    { 44100, 1024 },
+    { 48000, 512 },
+    { 22050, 1024 }
+};
+
+#define NUM_PREFERRED_FORMATS (int)(sizeof(preferred_formats) / sizeof(preferred_formats[0]))
+#define PROBE_PERIODS 2
+
+// Test one rate/period combination on an open PCM
+// hw_params are refined step by step so the constraints are checked jointly
+static int test_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t *params,
+                          int sample_rate, int period, int periods) {
+    static const snd_pcm_format_t formats[] = {
+        SND_PCM_FORMAT_S32_LE, SND_PCM_FORMAT_S24_3LE, SND_PCM_FORMAT_S16_LE
+    };
+    int err;
+    
+    err = snd_pcm_hw_params_any(pcm, params);
+    if (err < 0) {
+        return err;
+    }
+    
+    // JACK's ALSA backend uses mmap access
+    if (snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_MMAP_NONINTERLEAVED) < 0 &&
+        snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0) {
+        return -EINVAL;
+    }
+    
+    err = -EINVAL;
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]) && err < 0; i++) {
+        err = snd_pcm_hw_params_set_format(pcm, params, formats[i]);
+    }
+    if (err < 0) {
+        return err;
+    }
+    
+    err = snd_pcm_hw_params_set_rate(pcm, params, sample_rate, 0);
+    if (err < 0) {
+        return err;
+    }
+    
+    err = snd_pcm_hw_params_set_period_size(pcm, params, period, 0);
+    if (err < 0) {
+        return err;
+    }
+    
+    return snd_pcm_hw_params_set_periods(pcm, params, periods, 0);
+}
+
+// Probe one device with every preferred format
+// Returns a bitmask of supported preferred_formats entries (0 if none or unavailable)
+static unsigned int probe_device(const char *device, const char *card_name) {
+    snd_pcm_t *pcm;
+    snd_pcm_hw_params_t *params;
+    unsigned int supported = 0;
+    
+    int err = snd_pcm_open(&pcm, device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        printf("  %-10s %s: %s\n", device, card_name, snd_strerror(err));
+        return 0;
+    }
+    
+    snd_pcm_hw_params_malloc(&params);
+    
+    for (int i = 0; i < NUM_PREFERRED_FORMATS; i++) {
+        if (test_hw_params(pcm, params, preferred_formats[i].sample_rate,
+                           preferred_formats[i].period, PROBE_PERIODS) == 0) {
+            supported |= 1u << i;
+            printf("  %-10s %s: %d Hz, %d frames x %d OK\n", device, card_name,
+                   preferred_formats[i].sample_rate, preferred_formats[i].period, PROBE_PERIODS);
+        }
+    }
+    
+    snd_pcm_hw_params_free(params);
+    snd_pcm_close(pcm);
+    return supported;
+}
+
+// Probe all ALSA cards in-process
+int audio_probe_devices(audio_device_config_t *configs, int max_configs) {
+    char devices[16][32];
+    char names[16][64];
+    int card_numbers[16];
+    unsigned int supported[16];
+    int device_count = 0;
+    int card = -1;
+    int count = 0;
+    
+    printf("Probing ALSA playback devices...\n");
+    
+    // Direct hardware access for every card
+    while (snd_card_next(&card) == 0 && card >= 0 && device_count < 8) {
+        char *name = NULL;
+        if (snd_card_get_name(card, &name) == 0 && name) {
+            snprintf(names[device_count], sizeof(names[device_count]), "%s", name);
+            free(name);
+        } else {
+            snprintf(names[device_count], sizeof(names[device_count]), "card %d", card);
+        }
+        snprintf(devices[device_count], sizeof(devices[device_count]), "hw:%d", card);
+        card_numbers[device_count] = card;
+        supported[device_count] = probe_device(devices[device_count], names[device_count]);
+        device_count++;
+    }
+    
+    if (device_count == 0) {
+        printf("  No ALSA sound cards found\n");
+        return 0;
+    }
+    
+    // Fall back to the plugin layer only if no card accepts a format directly
+    int any_supported = 0;
+    for (int d = 0; d < device_count; d++) {
+        any_supported |= supported[d] != 0;
+    }
+    if (!any_supported) {
+        int hw_count = device_count;
+        for (int d = 0; d < hw_count; d++) {
+            snprintf(devices[hw_count + d], sizeof(devices[0]), "plughw:%d", card_numbers[d]);
+            memcpy(names[hw_count + d], names[d], sizeof(names[0]));
+            supported[hw_count + d] = probe_device(devices[hw_count + d], names[d]);
+            device_count++;
+        }
+    }
+    
+    // Best format first across all cards, like the order in start_jack.sh
+    for (int i = 0; i < NUM_PREFERRED_FORMATS; i++) {
+        for (int d = 0; d < device_count && count < max_configs; d++) {
+            if (!(supported[d] & (1u << i))) {
+                continue;
+            }
+            audio_device_config_t *config = &configs[count++];
+            snprintf(config->device, sizeof(config->device), "%s", devices[d]);
+            snprintf(config->card_name, sizeof(config->card_name), "%s", names[d]);
+            config->sample_rate = preferred_formats[i].sample_rate;
+            config->period = preferred_formats[i].period;
+            config->periods = PROBE_PERIODS;
+        }
+    }
+    
+    return count;
+}
+
+// Check a single configuration against the hardware
+int audio_probe_config(const audio_device_config_t *config) {
+    snd_pcm_t *pcm;
+    snd_pcm_hw_params_t *params;
+    
+    int err = snd_pcm_open(&pcm, config->device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        return err;
+    }
+    
+    snd_pcm_hw_params_malloc(&params);
+    err = test_hw_params(pcm, params, config->sample_rate, config->period, config->periods);
+    snd_pcm_hw_params_free(params);
+    snd_pcm_close(pcm);
+    
+    return err;
+}
@@ -0,0 +1,24 @@
+#ifndef AUDIO_PROBE_H
+#define AUDIO_PROBE_H
+
+// A playback configuration jackd can be started with
+typedef struct {
+    char device[32];        // ALSA device (e.g. "hw:1" or "plughw:0")
+    char card_name[64];     // Human readable card name
+    int sample_rate;        // Sample rate in Hz
+    int period;             // Period size in frames (-p)
+    int periods;            // Number of periods (-n)
+} audio_device_config_t;
+
+// Maximum number of candidate configurations returned by a probe
+#define AUDIO_PROBE_MAX_CONFIGS 32
+
+// Probe all ALSA cards in-process and list configurations they accept,
+// best first. Returns the number of configurations found.
+int audio_probe_devices(audio_device_config_t *configs, int max_configs);
+
+// Check a single configuration against the hardware
+// Returns 0 if supported, negative ALSA error code otherwise
+int audio_probe_config(const audio_device_config_t *config);
+
+#endif // AUDIO_PROBE_H
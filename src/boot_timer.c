@@ -0,0 +1,66 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "boot_timer.h"
+
+// Recorded phase: name and time it finished
+typedef struct {
+    const char *name;
+    double end_ms;
+} boot_phase_t;
+
+// Internal state
+static struct timespec start_time;
+static boot_phase_t phases[BOOT_TIMER_MAX_PHASES];
+static int phase_count = 0;
+static int timer_started = 0;
+
+// Start timing (marks the beginning of the first phase)
+void boot_timer_start(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    phase_count = 0;
+    timer_started = 1;
+}
+
+double boot_timer_elapsed_ms(void) {
+    struct timespec now;
+    
+    if (!timer_started) {
+        return 0.0;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec) * 1000.0 +
+           (now.tv_nsec - start_time.tv_nsec) / 1000000.0;
+}
+
+// Mark the end of a phase (the phase started at the previous mark)
+// 'phase' must be a string literal or otherwise outlive the report
+void boot_timer_mark(const char *phase) {
+    if (!timer_started || phase_count >= BOOT_TIMER_MAX_PHASES) {
+        return;
+    }
+    
+    phases[phase_count].name = phase;
+    phases[phase_count].end_ms = boot_timer_elapsed_ms();
+    phase_count++;
+}
+
+// Print where startup time went
+void boot_timer_report(void) {
+    if (!timer_started) {
+        return;
+    }
+    
+    printf("Boot timing:\n");
+    
+    double previous = 0.0;
+    for (int i = 0; i < phase_count; i++) {
+        printf("  %-28s %8.1f ms  (at %8.1f ms)\n",
+               phases[i].name, phases[i].end_ms - previous, phases[i].end_ms);
+        previous = phases[i].end_ms;
+    }
+    
+    printf("  %-28s %8.1f ms\n", "Total to ready", previous);
+}
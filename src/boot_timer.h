@@ -0,0 +1,15 @@
+#ifndef BOOT_TIMER_H
+#define BOOT_TIMER_H
+
+// Maximum number of phases recorded in one boot
+#define BOOT_TIMER_MAX_PHASES 32
+
+// Boot timing functions
+void boot_timer_start(void);
+void boot_timer_mark(const char *phase);
+void boot_timer_report(void);
+
+// Milliseconds since boot_timer_start()
+double boot_timer_elapsed_ms(void);
+
+#endif // BOOT_TIMER_H
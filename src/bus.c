@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bus.h"
+#include "dsp.h"
+
+// Grow the bus buffers to hold 'frames' (shrinking keeps the larger buffers)
+int bus_allocate(audio_bus_t *bus, int frames) {
+    if (frames <= bus->capacity) {
+        return 0;
+    }
+    
+    float *new_left = NULL;
+    float *new_right = NULL;
+    if (posix_memalign((void**)&new_left, DSP_ALIGNMENT, frames * sizeof(float)) != 0 ||
+        posix_memalign((void**)&new_right, DSP_ALIGNMENT, frames * sizeof(float)) != 0) {
+        printf("Error: Cannot allocate bus buffers for %d frames\n", frames);
+        free(new_left);
+        return -1;
+    }
+    
+    // Pre-touch so the first cycle doesn't page fault
+    memset(new_left, 0, frames * sizeof(float));
+    memset(new_right, 0, frames * sizeof(float));
+    
+    free(bus->left);
+    free(bus->right);
+    bus->left = new_left;
+    bus->right = new_right;
+    bus->capacity = frames;
+    return 0;
+}
+
+void bus_free(audio_bus_t *bus) {
+    free(bus->left);
+    free(bus->right);
+    memset(bus, 0, sizeof(*bus));
+}
+
+// Append an insert effect; returns the slot index or -1 if the chain is full
+int bus_add_insert(audio_bus_t *bus, int type, int value, int sample_rate) {
+    if (bus->insert_count >= BUS_MAX_INSERTS) {
+        return -1;
+    }
+    
+    effect_init(&bus->inserts[bus->insert_count], type, value, sample_rate);
+    return bus->insert_count++;
+}
+
+// First insert of a given type, or NULL
+effect_t* bus_find_insert(audio_bus_t *bus, int type) {
+    for (int i = 0; i < bus->insert_count; i++) {
+        if (bus->inserts[i].type == type) {
+            return &bus->inserts[i];
+        }
+    }
+    return NULL;
+}
+
+// Start a new block: the bus is silent until something mixes into it
+void bus_begin_block(audio_bus_t *bus) {
+    bus->was_active = bus->active;
+    bus->active = 0;
+}
+
+// Called before the first mix into the bus this block
+void bus_activate(audio_bus_t *bus, int nframes) {
+    if (bus->active) {
+        return;
+    }
+    
+    memset(bus->left, 0, nframes * sizeof(float));
+    memset(bus->right, 0, nframes * sizeof(float));
+    
+    // Coming back from silence: don't replay stale filter memories
+    if (!bus->was_active) {
+        for (int i = 0; i < bus->insert_count; i++) {
+            effect_reset(&bus->inserts[i]);
+        }
+    }
+    bus->active = 1;
+}
+
+// Run the insert chain over the block
+void bus_process_inserts(audio_bus_t *bus, int nframes) {
+    for (int i = 0; i < bus->insert_count; i++) {
+        effect_process(&bus->inserts[i], bus->left, bus->right, nframes);
+    }
+}
+
+// Recompute insert coefficients for a new sample rate
+void bus_set_sample_rate(audio_bus_t *bus, int sample_rate) {
+    for (int i = 0; i < bus->insert_count; i++) {
+        effect_set_value(&bus->inserts[i], bus->inserts[i].value, sample_rate);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include "effects.h"
+
+// Insert slots per bus
+#define BUS_MAX_INSERTS 4
+
+// Mix bus: stereo block buffers plus an insert effect chain
+typedef struct {
+    float *left;                        // Block buffers (capacity frames, 64-byte aligned)
+    float *right;
+    int capacity;
+    
+    effect_t inserts[BUS_MAX_INSERTS];  // Processed in order, once per block
+    int insert_count;
+    
+    int active;                         // Received audio this block
+    int was_active;                     // Received audio last block
+} audio_bus_t;
+
+// Setup (not real-time safe)
+int bus_allocate(audio_bus_t *bus, int frames);
+void bus_free(audio_bus_t *bus);
+int bus_add_insert(audio_bus_t *bus, int type, int value, int sample_rate);
+effect_t* bus_find_insert(audio_bus_t *bus, int type);
+
+// Real-time functions
+void bus_begin_block(audio_bus_t *bus);
+void bus_activate(audio_bus_t *bus, int nframes);
+void bus_process_inserts(audio_bus_t *bus, int nframes);
+void bus_set_sample_rate(audio_bus_t *bus, int sample_rate);
+
+#endif // BUS_H
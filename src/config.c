@@ -0,0 +1,196 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <strings.h>
+#include "config.h"
+
+// Parsed key/value pair
+typedef struct {
+    char section[CONFIG_MAX_NAME];
+    char key[CONFIG_MAX_NAME];
+    char value[CONFIG_MAX_VALUE];
+} config_entry_t;
+
+// Internal state
+static config_entry_t entries[CONFIG_MAX_ENTRIES];
+static int entry_count = 0;
+static char config_path[512] = "";
+static int config_loaded = 0;
+
+// Strip leading and trailing whitespace in place
+static char* trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    
+    return text;
+}
+
+// Find an entry (section and key are case-insensitive)
+static const config_entry_t* find_entry(const char *section, const char *key) {
+    for (int i = 0; i < entry_count; i++) {
+        if (strcasecmp(entries[i].section, section) == 0 &&
+            strcasecmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Load configuration file
+int config_load(const char *path) {
+    char line[512];
+    char section[CONFIG_MAX_NAME] = "";
+    int line_number = 0;
+    
+    if (!path) {
+        path = CONFIG_DEFAULT_FILE;
+    }
+    
+    entry_count = 0;
+    config_loaded = 0;
+    snprintf(config_path, sizeof(config_path), "%s", path);
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("Config file not found: %s (using defaults)\n", path);
+        return -1;
+    }
+    
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        
+        // Everything after '#' is a comment, including inline comments
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        
+        char *text = trim(line);
+        if (*text == '\0') {
+            continue;
+        }
+        
+        // Section header
+        if (*text == '[') {
+            char *close = strchr(text, ']');
+            if (!close) {
+                printf("Config %s:%d: malformed section header\n", path, line_number);
+                continue;
+            }
+            *close = '\0';
+            snprintf(section, sizeof(section), "%s", trim(text + 1));
+            continue;
+        }
+        
+        // key = value
+        char *equals = strchr(text, '=');
+        if (!equals) {
+            printf("Config %s:%d: expected 'key = value'\n", path, line_number);
+            continue;
+        }
+        *equals = '\0';
+        
+        if (entry_count >= CONFIG_MAX_ENTRIES) {
+            printf("Config %s:%d: too many entries, ignoring the rest\n", path, line_number);
+            break;
+        }
+        
+        config_entry_t *entry = &entries[entry_count++];
+        snprintf(entry->section, sizeof(entry->section), "%s", section);
+        snprintf(entry->key, sizeof(entry->key), "%s", trim(text));
+        snprintf(entry->value, sizeof(entry->value), "%s", trim(equals + 1));
+    }
+    
+    fclose(file);
+    config_loaded = 1;
+    
+    printf("Loaded %d settings from %s\n", entry_count, path);
+    return 0;
+}
+
+// Cleanup configuration
+void config_cleanup(void) {
+    entry_count = 0;
+    config_loaded = 0;
+    config_path[0] = '\0';
+}
+
+// Get string value
+const char* config_get_string(const char *section, const char *key, const char *default_value) {
+    const config_entry_t *entry = find_entry(section, key);
+    return entry ? entry->value : default_value;
+}
+
+// Get integer value
+int config_get_int(const char *section, const char *key, int default_value) {
+    const config_entry_t *entry = find_entry(section, key);
+    if (!entry) {
+        return default_value;
+    }
+    
+    char *end;
+    long value = strtol(entry->value, &end, 0);
+    if (end == entry->value || *end != '\0') {
+        printf("Config: [%s] %s = '%s' is not a number, using %d\n",
+               section, key, entry->value, default_value);
+        return default_value;
+    }
+    return (int)value;
+}
+
+// Get float value
+float config_get_float(const char *section, const char *key, float default_value) {
+    const config_entry_t *entry = find_entry(section, key);
+    if (!entry) {
+        return default_value;
+    }
+    
+    char *end;
+    float value = strtof(entry->value, &end);
+    if (end == entry->value || *end != '\0') {
+        printf("Config: [%s] %s = '%s' is not a number, using %.2f\n",
+               section, key, entry->value, default_value);
+        return default_value;
+    }
+    return value;
+}
+
+// Get boolean value (true/false, yes/no, on/off, 1/0)
+int config_get_bool(const char *section, const char *key, int default_value) {
+    const config_entry_t *entry = find_entry(section, key);
+    if (!entry) {
+        return default_value;
+    }
+    
+    const char *v = entry->value;
+    if (strcasecmp(v, "true") == 0 || strcasecmp(v, "yes") == 0 ||
+        strcasecmp(v, "on") == 0 || strcmp(v, "1") == 0) {
+        return 1;
+    }
+    if (strcasecmp(v, "false") == 0 || strcasecmp(v, "no") == 0 ||
+        strcasecmp(v, "off") == 0 || strcmp(v, "0") == 0) {
+        return 0;
+    }
+    
+    printf("Config: [%s] %s = '%s' is not a boolean\n", section, key, v);
+    return default_value;
+}
+
+// Check if a file was loaded
+int config_is_loaded(void) {
+    return config_loaded;
+}
+
+// Get loaded file path
+const char* config_get_path(void) {
+    return config_path;
+}
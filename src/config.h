@@ -0,0 +1,26 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// Default configuration file (relative to the working directory)
+#define CONFIG_DEFAULT_FILE "sampler_config_file.txt"
+
+// Limits for the parsed configuration
+#define CONFIG_MAX_ENTRIES 256
+#define CONFIG_MAX_NAME 64
+#define CONFIG_MAX_VALUE 256
+
+// Configuration file functions ([SECTION] headers, key = value, '#' comments)
+int config_load(const char *path);
+void config_cleanup(void);
+
+// Value access (returns default_value if the key is missing or invalid)
+const char* config_get_string(const char *section, const char *key, const char *default_value);
+int config_get_int(const char *section, const char *key, int default_value);
+float config_get_float(const char *section, const char *key, float default_value);
+int config_get_bool(const char *section, const char *key, int default_value);
+
+// Utility functions
+int config_is_loaded(void);
+const char* config_get_path(void);
+
+#endif // CONFIG_H
@@ -0,0 +1,135 @@
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Portable 4-wide float vectors: GCC vector extensions compile to NEON on
+// ARM and SSE on x86, with no intrinsics or build flags needed
+typedef float v4sf __attribute__((vector_size(16)));
+typedef int32_t v4si __attribute__((vector_size(16)));
+
+// Alignment used for DSP buffers
+#define DSP_ALIGNMENT 64
+
+// Unaligned load/store (compile to single vector instructions)
+static inline v4sf v4sf_load(const float *p) {
+    v4sf v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void v4sf_store(float *p, v4sf v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline v4sf v4sf_set1(float x) {
+    return (v4sf){ x, x, x, x };
+}
+
+// Branchless helpers
+static inline v4sf v4sf_abs(v4sf x) {
+    return (v4sf)((v4si)x & 0x7FFFFFFF);
+}
+
+static inline v4sf v4sf_max(v4sf a, v4sf b) {
+    v4si mask = a > b;
+    return (v4sf)(((v4si)a & mask) | ((v4si)b & ~mask));
+}
+
+static inline v4sf v4sf_min(v4sf a, v4sf b) {
+    v4si mask = a < b;
+    return (v4sf)(((v4si)a & mask) | ((v4si)b & ~mask));
+}
+
+static inline float v4sf_hmax(v4sf v) {
+    float a = v[0] > v[1] ? v[0] : v[1];
+    float b = v[2] > v[3] ? v[2] : v[3];
+    return a > b ? a : b;
+}
+
+// Peak absolute value of a buffer
+static inline float dsp_peak(const float *buffer, int nframes) {
+    v4sf peak = v4sf_set1(0.0f);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        peak = v4sf_max(peak, v4sf_abs(v4sf_load(buffer + f)));
+    }
+    
+    float result = v4sf_hmax(peak);
+    for (; f < nframes; f++) {
+        float a = buffer[f] < 0.0f ? -buffer[f] : buffer[f];
+        result = a > result ? a : result;
+    }
+    return result;
+}
+
+// Sum of squares (for RMS metering)
+static inline float dsp_sum_squares(const float *buffer, int nframes) {
+    v4sf sum = v4sf_set1(0.0f);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        v4sf x = v4sf_load(buffer + f);
+        sum += x * x;
+    }
+    float result = sum[0] + sum[1] + sum[2] + sum[3];
+    for (; f < nframes; f++) {
+        result += buffer[f] * buffer[f];
+    }
+    return result;
+}
+
+// out[f] = in[f] * gain, with gain ramping linearly from 'from' to 'to'
+// (the last frame gets exactly 'to'); in and out may be the same buffer
+static inline void dsp_apply_ramp(const float *in, float *out, int nframes, float from, float to) {
+    float step = (to - from) / (float)nframes;
+    v4sf gain = { from + step, from + 2.0f * step, from + 3.0f * step, from + 4.0f * step };
+    v4sf step4 = v4sf_set1(4.0f * step);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        v4sf_store(out + f, v4sf_load(in + f) * gain);
+        gain += step4;
+    }
+    for (; f < nframes; f++) {
+        out[f] = in[f] * (from + step * (float)(f + 1));
+    }
+}
+
+// out[f] += in[f] * gain
+static inline void dsp_mix(const float *in, float *out, int nframes, float gain) {
+    v4sf g = v4sf_set1(gain);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        v4sf_store(out + f, v4sf_load(out + f) + v4sf_load(in + f) * g);
+    }
+    for (; f < nframes; f++) {
+        out[f] += in[f] * gain;
+    }
+}
+
+// out[f] += in[f] * gain, with gain ramping linearly from 'from' to 'to'
+static inline void dsp_mix_ramp(const float *in, float *out, int nframes, float from, float to) {
+    if (from == to) {
+        dsp_mix(in, out, nframes, to);
+        return;
+    }
+    
+    float step = (to - from) / (float)nframes;
+    v4sf gain = { from + step, from + 2.0f * step, from + 3.0f * step, from + 4.0f * step };
+    v4sf step4 = v4sf_set1(4.0f * step);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        v4sf_store(out + f, v4sf_load(out + f) + v4sf_load(in + f) * gain);
+        gain += step4;
+    }
+    for (; f < nframes; f++) {
+        out[f] += in[f] * (from + step * (float)(f + 1));
+    }
+}
+
+#endif // DSP_H
@@ -0,0 +1,103 @@
+#include <string.h>
+#include "effects.h"
+#include "dsp.h"
+
+// Initialize an effect slot
+void effect_init(effect_t *effect, int type, int value, int sample_rate) {
+    memset(effect, 0, sizeof(*effect));
+    effect->type = type;
+    effect_set_value(effect, value, sample_rate);
+    effect_reset(effect);
+}
+
+// Recompute coefficients for a new parameter value or sample rate
+void effect_set_value(effect_t *effect, int value, int sample_rate) {
+    (void)sample_rate;  // No rate-dependent effects yet
+    
+    if (value < 0) value = 0;
+    if (value > EFFECT_VALUE_MAX) value = EFFECT_VALUE_MAX;
+    
+    effect->value = value;
+    effect->bypassed = (effect->type == EFFECT_NONE || value == 0);
+    
+    switch (effect->type) {
+        case EFFECT_BITCRUSH: {
+            // 0 = clean, 127 = 4 bits at 1/8 of the sample rate
+            bitcrush_state_t *bc = &effect->state.bitcrush;
+            int bits = 16 - (value * 12) / EFFECT_VALUE_MAX;
+            bc->levels = (float)(1 << (bits - 1));
+            bc->inv_levels = 1.0f / bc->levels;
+            bc->hold_frames = 1 + (value * 7) / EFFECT_VALUE_MAX;
+            break;
+        }
+    }
+}
+
+// Clear held values
+void effect_reset(effect_t *effect) {
+    switch (effect->type) {
+        case EFFECT_BITCRUSH:
+            effect->state.bitcrush.counter = 0;
+            effect->state.bitcrush.hold[0] = 0.0f;
+            effect->state.bitcrush.hold[1] = 0.0f;
+            break;
+    }
+}
+
+// Quantize a buffer in place (vectorized)
+// Adding and removing 1.5 * 2^23 rounds to the nearest integer without a branch or conversion
+static void quantize(float *buffer, int nframes, float levels, float inv_levels) {
+    const float magic = 12582912.0f;
+    v4sf scale = v4sf_set1(levels);
+    v4sf inv_scale = v4sf_set1(inv_levels);
+    v4sf round = v4sf_set1(magic);
+    int f = 0;
+    
+    for (; f + 4 <= nframes; f += 4) {
+        v4sf x = v4sf_load(buffer + f) * scale + round;
+        v4sf_store(buffer + f, (x - round) * inv_scale);
+    }
+    for (; f < nframes; f++) {
+        float x = buffer[f] * levels + magic;
+        buffer[f] = (x - magic) * inv_levels;
+    }
+}
+
+static void process_bitcrush(bitcrush_state_t *bc, float *left, float *right, int nframes) {
+    // Sample and hold for the rate reduction
+    if (bc->hold_frames > 1) {
+        for (int f = 0; f < nframes; f++) {
+            if (bc->counter == 0) {
+                bc->hold[0] = left[f];
+                bc->hold[1] = right[f];
+                bc->counter = bc->hold_frames;
+            }
+            bc->counter--;
+            left[f] = bc->hold[0];
+            right[f] = bc->hold[1];
+        }
+    }
+    
+    quantize(left, nframes, bc->levels, bc->inv_levels);
+    quantize(right, nframes, bc->levels, bc->inv_levels);
+}
+
+// Process a stereo block in place
+void effect_process(effect_t *effect, float *left, float *right, int nframes) {
+    if (effect->bypassed) {
+        return;
+    }
+    
+    switch (effect->type) {
+        case EFFECT_BITCRUSH:
+            process_bitcrush(&effect->state.bitcrush, left, right, nframes);
+            break;
+    }
+}
+
+const char* effect_type_name(int type) {
+    switch (type) {
+        case EFFECT_BITCRUSH: return "bitcrush";
+        default: return "none";
+    }
+}
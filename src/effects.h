@@ -0,0 +1,39 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+// Insert effect types
+typedef enum {
+    EFFECT_NONE = 0,
+    EFFECT_BITCRUSH         // Bit depth and sample rate reduction
+} effect_type_t;
+
+// Effect parameters use the MIDI range so they map directly to CCs
+#define EFFECT_VALUE_MAX 127
+
+// Bit crusher state
+typedef struct {
+    float levels;           // Quantization steps per unit
+    float inv_levels;
+    int hold_frames;        // Sample rate reduction factor
+    int counter;            // Frames left on the held value
+    float hold[2];          // Held left/right values
+} bitcrush_state_t;
+
+// Insert effect slot
+typedef struct {
+    int type;               // effect_type_t
+    int value;              // Parameter (0-127)
+    int bypassed;           // Value is neutral; processing is skipped
+    union {
+        bitcrush_state_t bitcrush;
+    } state;
+} effect_t;
+
+// Effect functions (all real-time safe)
+void effect_init(effect_t *effect, int type, int value, int sample_rate);
+void effect_set_value(effect_t *effect, int value, int sample_rate);
+void effect_reset(effect_t *effect);
+void effect_process(effect_t *effect, float *left, float *right, int nframes);
+const char* effect_type_name(int type);
+
+#endif // EFFECTS_H
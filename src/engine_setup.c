@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include "engine_setup.h"
+#include "config.h"
+#include "effects.h"
+#include "voice_filter.h"
+#include "reverb.h"
+#include "params.h"
+#include "sample_loader.h"
+
+// Engine fields from the config file ([MIDI] pitch bend, [EFFECTS] controller depths,
+// [PERFORMANCE] render threads)
+void engine_setup_read_config(audio_engine_config_t *config) {
+    config->pitch_bend_range = config_get_float("MIDI", "pitch_bend_range", config->pitch_bend_range);
+    config->mod_wheel_cutoff = config_get_float("EFFECTS", "mod_wheel_cutoff", config->mod_wheel_cutoff);
+    config->aftertouch_volume = config_get_float("EFFECTS", "aftertouch_volume", config->aftertouch_volume);
+    config->render_threads = config_get_int("PERFORMANCE", "render_threads", config->render_threads);
+}
+
+// Apply [EFFECTS] defaults to the buses of the two sampler channels ([MIDI] channel_1/2)
+void engine_setup_apply_effects(void) {
+    for (int s = 1; s <= 2; s++) {
+        char key[32];
+        
+        snprintf(key, sizeof(key), "channel_%d", s);
+        int channel = config_get_int("MIDI", key, s) - 1;
+        if (channel < 0 || channel >= ENGINE_CHANNEL_BUSES) {
+            printf("Warning: Invalid MIDI %s, effects not applied\n", key);
+            continue;
+        }
+        
+        snprintf(key, sizeof(key), "ch%d_bitcrush", s);
+        audio_engine_set_bus_effect(channel, EFFECT_BITCRUSH, config_get_int("EFFECTS", key, 0));
+        
+        snprintf(key, sizeof(key), "ch%d_filter_type", s);
+        const char *type = config_get_string("EFFECTS", key, "lowpass");
+        int mode = FILTER_LOWPASS;
+        if (strcmp(type, "highpass") == 0) {
+            mode = FILTER_HIGHPASS;
+        } else if (strcmp(type, "bandpass") == 0) {
+            mode = FILTER_BANDPASS;
+        }
+        snprintf(key, sizeof(key), "ch%d_filter_cutoff", s);
+        int cutoff = config_get_int("EFFECTS", key, FILTER_VALUE_MAX);
+        snprintf(key, sizeof(key), "ch%d_filter_resonance", s);
+        int resonance = config_get_int("EFFECTS", key, 0);
+        audio_engine_set_channel_filter(channel, mode, cutoff, resonance);
+        
+        snprintf(key, sizeof(key), "ch%d_attack_ms", s);
+        int attack_ms = config_get_int("EFFECTS", key, 10);
+        snprintf(key, sizeof(key), "ch%d_release_ms", s);
+        int release_ms = config_get_int("EFFECTS", key, 500);
+        audio_engine_set_channel_envelope(channel, attack_ms, release_ms);
+        
+        snprintf(key, sizeof(key), "ch%d_sample_start", s);
+        int sample_start = config_get_int("EFFECTS", key, 0);
+        snprintf(key, sizeof(key), "ch%d_sample_end", s);
+        int sample_end = config_get_int("EFFECTS", key, 127);
+        audio_engine_set_channel_range(channel, sample_start, sample_end);
+        
+        snprintf(key, sizeof(key), "ch%d_reverb_send", s);
+        audio_engine_set_reverb_send(channel, config_get_int("EFFECTS", key, 0));
+    }
+    audio_engine_set_reverb_send(-1, config_get_int("EFFECTS", "reverb_return", 64));
+}
+
+// Load CC mappings ([CC_MAP] parameter = channel:cc) and arm MIDI learn ([CC_MAP] learn)
+void engine_setup_load_cc_map(void) {
+    for (int id = 0; id < ENGINE_PARAM_COUNT; id++) {
+        const char *mapping = config_get_string("CC_MAP", params_name(id), "");
+        if (mapping[0] == '\0') {
+            continue;
+        }
+        
+        int channel, controller;
+        if (sscanf(mapping, "%d:%d", &channel, &controller) != 2 ||
+            params_map_cc(channel - 1, controller, id) < 0) {
+            printf("Warning: Invalid CC mapping %s = %s (expected channel:cc)\n", params_name(id), mapping);
+        }
+    }
+    
+    const char *learn = config_get_string("CC_MAP", "learn", "");
+    if (learn[0] != '\0' && params_learn(params_find(learn)) < 0) {
+        printf("Warning: Unknown parameter for MIDI learn: %s\n", learn);
+    }
+    
+    printf("CC mappings:\n");
+    params_print_cc_map();
+}
+
+// Load the reverb impulse response ([EFFECTS] reverb_ir, relative to the samples folder's ir/)
+void engine_setup_load_reverb(const char *samples_dir) {
+    const char *ir_file = config_get_string("EFFECTS", "reverb_ir", "");
+    if (ir_file[0] == '\0') {
+        return;
+    }
+    
+    char path[768];
+    if (ir_file[0] == '/') {
+        snprintf(path, sizeof(path), "%s", ir_file);
+    } else {
+        snprintf(path, sizeof(path), "%s/" SAMPLE_LOADER_IR_FOLDER "/%s", samples_dir, ir_file);
+    }
+    
+    audio_sample_t *ir = sample_loader_load_file(path);
+    if (!ir) {
+        printf("Warning: Reverb disabled (cannot load impulse response %s)\n", path);
+        return;
+    }
+    
+    float max_seconds = config_get_float("EFFECTS", "reverb_max_seconds", REVERB_DEFAULT_MAX_SECONDS);
+    if (audio_engine_set_reverb_ir(ir, max_seconds) < 0) {
+        printf("Warning: Reverb disabled\n");
+    }
+    audio_sample_free(ir);
+}
+
+// Apply mapped CCs to their parameters and drop them from the batch
+int engine_setup_apply_cc_map(midi_event_t *events, int count) {
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        if (e->type == MIDI_EVENT_CC && params_handle_cc(e->channel, e->data1, e->data2)) {
+            continue;
+        }
+        events[kept++] = *e;
+    }
+    return kept;
+}
@@ -0,0 +1,21 @@
+#ifndef ENGINE_SETUP_H
+#define ENGINE_SETUP_H
+
+#include "audio_engine.h"
+
+// Engine setup from the config file, shared by the sampler and sampler-render
+
+// Before audio_engine_init
+void engine_setup_read_config(audio_engine_config_t *config);
+
+// After audio_engine_init ([EFFECTS] channel defaults, [CC_MAP])
+void engine_setup_apply_effects(void);
+void engine_setup_load_cc_map(void);
+
+// Before JACK activation / rendering ([EFFECTS] reverb_ir, relative to samples_dir/ir)
+void engine_setup_load_reverb(const char *samples_dir);
+
+// Apply mapped CCs to their parameters and drop them from the batch; returns the events left
+int engine_setup_apply_cc_map(midi_event_t *events, int count);
+
+#endif // ENGINE_SETUP_H
@@ -1,11 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
-#include <sys/wait.h>
-#include <signal.h>
 #include <jack/jack.h>
 #include "jack_client.h"
+#include "jack_launcher.h"
+#include "trace.h"
 
 // Global JACK state
 static jack_state_t jack_state = {0};
@@ -16,6 +15,17 @@ static jack_process_callback_t user_process_callback = NULL;
 static void *user_process_arg = NULL;
 static jack_shutdown_callback_t user_shutdown_callback = NULL;
 static void *user_shutdown_arg = NULL;
+static jack_buffer_size_callback_t user_buffer_size_callback = NULL;
+static void *user_buffer_size_arg = NULL;
+static jack_sample_rate_callback_t user_sample_rate_callback = NULL;
+static void *user_sample_rate_arg = NULL;
+static jack_xrun_callback_t user_xrun_callback = NULL;
+static void *user_xrun_arg = NULL;
+static jack_thread_init_callback_t user_thread_init_callback = NULL;
+static void *user_thread_init_arg = NULL;
+
+// Number of xruns reported by JACK since the client was opened
+static unsigned long xrun_count = 0;
 
 // Internal JACK callbacks
 static int internal_process_callback(jack_nframes_t nframes, void *arg) {
@@ -55,59 +65,53 @@ static void internal_shutdown_callback(void *arg) {
     }
 }
 
-// Check if JACK server is running
-static int is_jack_running(void) {
-    jack_client_t *test_client = jack_client_open("test_connection", JackNoStartServer, NULL);
-    if (test_client) {
-        jack_client_close(test_client);
-        return 1;
+// JACK stops the driver while the buffer size changes, so this never runs
+// concurrently with the process callback and may allocate
+static int internal_buffer_size_callback(jack_nframes_t nframes, void *arg) {
+    (void)arg;
+    
+    printf("JACK buffer size changed: %d -> %u frames\n", jack_state.buffer_size, nframes);
+    jack_state.buffer_size = nframes;
+    
+    if (user_buffer_size_callback) {
+        return user_buffer_size_callback(nframes, user_buffer_size_arg);
     }
     return 0;
 }
 
-
-// Start JACK daemon automatically
-static int start_jack_daemon(void) {
-    printf("Starting JACK daemon automatically...\n");
+static int internal_sample_rate_callback(jack_nframes_t sample_rate, void *arg) {
+    (void)arg;
     
-    // Use the auto-detection script
-    const char *start_script = "./start_jack.sh";
+    if (jack_state.sample_rate != (int)sample_rate) {
+        printf("JACK sample rate changed: %d -> %u Hz\n", jack_state.sample_rate, sample_rate);
+    }
+    jack_state.sample_rate = sample_rate;
     
-    // Check if script exists
-    if (access(start_script, F_OK) != 0) {
-        printf("Error: start_jack.sh not found\n");
-        return -1;
+    if (user_sample_rate_callback) {
+        return user_sample_rate_callback(sample_rate, user_sample_rate_arg);
     }
+    return 0;
+}
+
+static int internal_xrun_callback(void *arg) {
+    (void)arg;
     
-    // Execute the script and show output
-    printf("Executing: %s\n", start_script);
-    int result = system(start_script);
+    __atomic_add_fetch(&xrun_count, 1, __ATOMIC_RELAXED);
+    trace_record(TRACE_XRUN, (int)jack_get_xrun_delayed_usecs(jack_state.client), 0);
     
-    if (result != 0) {
-        printf("Failed to execute start_jack.sh (exit code: %d)\n", result);
-        printf("Try running manually: %s\n", start_script);
-        return -1;
+    if (user_xrun_callback) {
+        return user_xrun_callback(user_xrun_arg);
     }
+    return 0;
+}
+
+// Runs once in JACK's process thread before the first cycle
+static void internal_thread_init_callback(void *arg) {
+    (void)arg;
     
-    // Wait longer for JACK to start (JACK can be slow on Pi)
-    printf("Waiting for JACK to initialize");
-    for (int i = 0; i < 20; i++) {
-        sleep(1);
-        if (is_jack_running()) {
-            printf(" done!\n");
-            printf("JACK daemon started successfully\n");
-            return 0;
-        }
-        printf(".");
-        fflush(stdout);
+    if (user_thread_init_callback) {
+        user_thread_init_callback(user_thread_init_arg);
     }
-    
-    printf(" timeout!\n");
-    printf("JACK failed to start automatically. Try manual start:\n");
-    printf("  ./start_jack.sh\n");
-    printf("  OR\n");
-    printf("  jackd -dalsa -dhw:0 -r48000 -p1024 -n2 &\n");
-    return -1;
 }
 
 // Default configuration
@@ -115,7 +119,8 @@ jack_config_t jack_get_default_config(void) {
     jack_config_t config = {
         .client_name = "rpi-sampler",
         .auto_connect = 1,
-        .output_channels = 2
+        .output_channels = 2,
+        .input_channels = 0
     };
     return config;
 }
@@ -136,6 +141,9 @@ int jack_client_init(jack_config_t *config) {
     printf("Initializing JACK client...\n");
     printf("Client name: %s\n", jack_config.client_name);
     printf("Output channels: %d\n", jack_config.output_channels);
+    if (jack_config.input_channels > 0) {
+        printf("Input channels: %d\n", jack_config.input_channels);
+    }
     
     // Check if JACK is running, if not try to start it
     jack_status_t status;
@@ -144,7 +152,7 @@ int jack_client_init(jack_config_t *config) {
     if (!jack_state.client && (status & JackServerFailed)) {
         printf("JACK server not running, attempting to start...\n");
         
-        if (start_jack_daemon() < 0) {
+        if (jack_launcher_start() < 0) {
             printf("\n=== JACK AUTO-START FAILED ===\n");
             printf("The auto-detection couldn't find a working audio configuration.\n");
             printf("\nTry manually:\n");
@@ -205,8 +213,31 @@ int jack_client_init(jack_config_t *config) {
         }
     }
     
+    // Register input ports (live sampling)
+    const char *input_names[2] = {"in_left", "in_right"};
+    for (int i = 0; i < jack_config.input_channels && i < 2; i++) {
+        jack_port_t *port = jack_port_register(jack_state.client, input_names[i],
+                                               JACK_DEFAULT_AUDIO_TYPE,
+                                               JackPortIsInput, 0);
+        if (!port) {
+            printf("Error: Cannot register %s input port\n", input_names[i]);
+            jack_client_close(jack_state.client);
+            jack_state.client = NULL;
+            return -1;
+        }
+        if (i == 0) {
+            jack_state.input_left = port;
+        } else {
+            jack_state.input_right = port;
+        }
+    }
+    
     // Set internal callbacks
     jack_set_process_callback(jack_state.client, internal_process_callback, NULL);
+    jack_set_buffer_size_callback(jack_state.client, internal_buffer_size_callback, NULL);
+    jack_set_sample_rate_callback(jack_state.client, internal_sample_rate_callback, NULL);
+    jack_set_xrun_callback(jack_state.client, internal_xrun_callback, NULL);
+    jack_set_thread_init_callback(jack_state.client, internal_thread_init_callback, NULL);
     jack_on_shutdown(jack_state.client, internal_shutdown_callback, NULL);
     
     printf("JACK client initialized successfully\n");
@@ -245,6 +276,34 @@ int jack_client_set_shutdown_callback(jack_shutdown_callback_t callback, void *a
     return 0;
 }
 
+// Set buffer size change callback
+int jack_client_set_buffer_size_callback(jack_buffer_size_callback_t callback, void *arg) {
+    user_buffer_size_callback = callback;
+    user_buffer_size_arg = arg;
+    return 0;
+}
+
+// Set sample rate change callback
+int jack_client_set_sample_rate_callback(jack_sample_rate_callback_t callback, void *arg) {
+    user_sample_rate_callback = callback;
+    user_sample_rate_arg = arg;
+    return 0;
+}
+
+// Set xrun callback
+int jack_client_set_xrun_callback(jack_xrun_callback_t callback, void *arg) {
+    user_xrun_callback = callback;
+    user_xrun_arg = arg;
+    return 0;
+}
+
+// Set process thread init callback (must be set before activation)
+int jack_client_set_thread_init_callback(jack_thread_init_callback_t callback, void *arg) {
+    user_thread_init_callback = callback;
+    user_thread_init_arg = arg;
+    return 0;
+}
+
 // Activate client
 int jack_client_activate(void) {
     if (!jack_state.client) {
@@ -270,6 +329,9 @@ int jack_client_activate(void) {
     // Auto-connect if requested
     if (jack_config.auto_connect) {
         jack_client_connect_outputs();
+        if (jack_state.input_left) {
+            jack_client_connect_inputs();
+        }
     }
     
     return 0;
@@ -329,6 +391,39 @@ int jack_client_connect_outputs(void) {
     return 0;
 }
 
+// Connect the physical capture ports to the inputs
+int jack_client_connect_inputs(void) {
+    if (!jack_state.client || !jack_state.is_active) {
+        printf("Error: JACK client not active\n");
+        return -1;
+    }
+    
+    printf("Auto-connecting inputs...\n");
+    
+    const char **system_ports = jack_get_ports(jack_state.client, NULL, NULL,
+                                              JackPortIsPhysical | JackPortIsOutput);
+    
+    if (!system_ports) {
+        printf("Warning: No physical capture ports found\n");
+        return -1;
+    }
+    
+    // A mono source feeds both inputs
+    jack_port_t *inputs[2] = {jack_state.input_left, jack_state.input_right};
+    for (int i = 0; i < 2 && inputs[i]; i++) {
+        const char *source = system_ports[1] ? system_ports[i] : system_ports[0];
+        const char *input_port = jack_port_name(inputs[i]);
+        if (jack_connect(jack_state.client, source, input_port) == 0) {
+            printf("Connected %s -> %s\n", source, input_port);
+        } else {
+            printf("Warning: Could not connect %s\n", input_port);
+        }
+    }
+    
+    jack_free(system_ports);
+    return 0;
+}
+
 // Disconnect all connections
 int jack_client_disconnect_all(void) {
     if (!jack_state.client) {
@@ -341,6 +436,13 @@ int jack_client_disconnect_all(void) {
         jack_port_disconnect(jack_state.client, jack_state.output_right);
     }
     
+    if (jack_state.input_left) {
+        jack_port_disconnect(jack_state.client, jack_state.input_left);
+    }
+    if (jack_state.input_right) {
+        jack_port_disconnect(jack_state.client, jack_state.input_right);
+    }
+    
     return 0;
 }
 
@@ -357,6 +459,35 @@ int jack_client_get_buffer_size(void) {
     return jack_state.buffer_size;
 }
 
+unsigned long jack_client_get_xrun_count(void) {
+    return __atomic_load_n(&xrun_count, __ATOMIC_RELAXED);
+}
+
+// DSP load of the whole JACK graph in percent (JACK's own estimate)
+float jack_client_get_cpu_load(void) {
+    if (!jack_state.client) {
+        return 0.0f;
+    }
+    return jack_cpu_load(jack_state.client);
+}
+
+// RT priority of JACK's process thread (-1 if JACK is not running realtime)
+int jack_client_get_rt_priority(void) {
+    if (!jack_state.client || !jack_is_realtime(jack_state.client)) {
+        return -1;
+    }
+    return jack_client_real_time_priority(jack_state.client);
+}
+
+jack_port_t* jack_client_get_input_port(int channel) {
+    if (channel == 0) {
+        return jack_state.input_left;
+    } else if (channel == 1) {
+        return jack_state.input_right;
+    }
+    return NULL;
+}
+
 jack_port_t* jack_client_get_output_port(int channel) {
     if (channel == 0) {
         return jack_state.output_left;
@@ -405,4 +536,18 @@ void jack_client_print_connections(void) {
             printf("  %s: not connected\n", jack_port_name(jack_state.output_right));
         }
     }
+    
+    // Print input connections (live sampling)
+    jack_port_t *inputs[2] = {jack_state.input_left, jack_state.input_right};
+    for (int i = 0; i < 2 && inputs[i]; i++) {
+        connections = jack_port_get_connections(inputs[i]);
+        if (connections) {
+            for (int c = 0; connections[c]; c++) {
+                printf("  %s -> %s\n", connections[c], jack_port_name(inputs[i]));
+            }
+            jack_free(connections);
+        } else {
+            printf("  %s: not connected\n", jack_port_name(inputs[i]));
+        }
+    }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ typedef struct {
     const char *client_name;    // JACK client name
     int auto_connect;           // Auto-connect to system outputs
     int output_channels;        // Number of output channels (1=mono, 2=stereo)
+    int input_channels;         // Number of input channels (0=none, 1=mono, 2=stereo)
 } jack_config_t;
 
 // JACK client state
@@ -15,6 +16,8 @@ typedef struct {
     jack_client_t *client;      // JACK client handle
     jack_port_t *output_left;   // Left output port
     jack_port_t *output_right;  // Right output port (NULL for mono)
+    jack_port_t *input_left;    // Left input port (NULL without inputs)
+    jack_port_t *input_right;   // Right input port (NULL unless stereo inputs)
     int is_active;              // 1 if client is active
     int sample_rate;            // Current JACK sample rate
     int buffer_size;            // Current JACK buffer size
@@ -23,6 +26,10 @@ typedef struct {
 // Callback function types
 typedef int (*jack_process_callback_t)(jack_nframes_t nframes, void *arg);
 typedef void (*jack_shutdown_callback_t)(void *arg);
+typedef int (*jack_buffer_size_callback_t)(jack_nframes_t nframes, void *arg);
+typedef int (*jack_sample_rate_callback_t)(jack_nframes_t sample_rate, void *arg);
+typedef int (*jack_xrun_callback_t)(void *arg);
+typedef void (*jack_thread_init_callback_t)(void *arg);
 
 // JACK client functions
 int jack_client_init(jack_config_t *config);
@@ -31,6 +38,10 @@ void jack_client_cleanup(void);
 // Callback registration
 int jack_client_set_process_callback(jack_process_callback_t callback, void *arg);
 int jack_client_set_shutdown_callback(jack_shutdown_callback_t callback, void *arg);
+int jack_client_set_buffer_size_callback(jack_buffer_size_callback_t callback, void *arg);
+int jack_client_set_sample_rate_callback(jack_sample_rate_callback_t callback, void *arg);
+int jack_client_set_xrun_callback(jack_xrun_callback_t callback, void *arg);
+int jack_client_set_thread_init_callback(jack_thread_init_callback_t callback, void *arg);
 
 // Client control
 int jack_client_activate(void);
@@ -38,13 +49,18 @@ int jack_client_deactivate(void);
 
 // Port management
 int jack_client_connect_outputs(void);
+int jack_client_connect_inputs(void);
 int jack_client_disconnect_all(void);
 
 // State queries
 int jack_client_is_active(void);
 int jack_client_get_sample_rate(void);
 int jack_client_get_buffer_size(void);
+unsigned long jack_client_get_xrun_count(void);
+float jack_client_get_cpu_load(void);
+int jack_client_get_rt_priority(void);
 jack_port_t* jack_client_get_output_port(int channel);
+jack_port_t* jack_client_get_input_port(int channel);
 
 // Utility functions
 const char* jack_client_get_name(void);
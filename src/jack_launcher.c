@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <jack/jack.h>
+#include <alsa/asoundlib.h>
+#include "jack_launcher.h"
+#include "boot_timer.h"
+
+// Interval between checks while waiting for jackd
+#define POLL_INTERVAL_US 50000
+
+// Check if JACK server is running
+int jack_launcher_server_running(void) {
+    jack_client_t *test_client = jack_client_open("test_connection", JackNoStartServer, NULL);
+    if (test_client) {
+        jack_client_close(test_client);
+        return 1;
+    }
+    return 0;
+}
+
+// Build the cache file path; returns -1 if HOME is not set
+static int cache_path(char *path, size_t size, int directory_only) {
+    const char *home = getenv("HOME");
+    if (!home) {
+        return -1;
+    }
+    
+    if (directory_only) {
+        snprintf(path, size, "%s/%s", home, JACK_LAUNCHER_CACHE_DIR);
+    } else {
+        snprintf(path, size, "%s/%s/%s", home, JACK_LAUNCHER_CACHE_DIR, JACK_LAUNCHER_CACHE_FILE);
+    }
+    return 0;
+}
+
+// Load the last working configuration (key=value lines)
+int jack_launcher_load_cache(audio_device_config_t *config) {
+    char path[512];
+    char line[128];
+    
+    if (cache_path(path, sizeof(path), 0) < 0) {
+        return -1;
+    }
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    
+    memset(config, 0, sizeof(*config));
+    config->periods = 2;
+    
+    while (fgets(line, sizeof(line), file)) {
+        char value[64];
+        
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "device=%31s", config->device) == 1) continue;
+        if (sscanf(line, "sample_rate=%d", &config->sample_rate) == 1) continue;
+        if (sscanf(line, "period=%d", &config->period) == 1) continue;
+        if (sscanf(line, "periods=%d", &config->periods) == 1) continue;
+        if (sscanf(line, "card_name=%63[^\n]", value) == 1) {
+            snprintf(config->card_name, sizeof(config->card_name), "%s", value);
+        }
+    }
+    fclose(file);
+    
+    if (config->device[0] == '\0' || config->sample_rate <= 0 || config->period <= 0) {
+        printf("Ignoring incomplete JACK cache: %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Remember a working configuration for the next boot
+int jack_launcher_save_cache(const audio_device_config_t *config) {
+    char path[512];
+    
+    if (cache_path(path, sizeof(path), 1) < 0) {
+        return -1;
+    }
+    
+    // Create ~/.cache and ~/.cache/rpi-sampler if needed
+    char *slash = strrchr(path, '/');
+    if (slash) {
+        *slash = '\0';
+        mkdir(path, 0755);
+        *slash = '/';
+    }
+    mkdir(path, 0755);
+    
+    cache_path(path, sizeof(path), 0);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Warning: Cannot write JACK cache %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(file, "# Last working JACK configuration (written automatically)\n");
+    fprintf(file, "# Delete this file to probe the audio devices again\n");
+    fprintf(file, "device=%s\n", config->device);
+    fprintf(file, "card_name=%s\n", config->card_name);
+    fprintf(file, "sample_rate=%d\n", config->sample_rate);
+    fprintf(file, "period=%d\n", config->period);
+    fprintf(file, "periods=%d\n", config->periods);
+    fclose(file);
+    
+    printf("Saved JACK configuration to %s\n", path);
+    return 0;
+}
+
+// Start jackd directly with one configuration (no shell, no fixed sleeps)
+static pid_t launch_jackd(const audio_device_config_t *config) {
+    char device_arg[48];
+    char rate_arg[16];
+    char period_arg[16];
+    char periods_arg[16];
+    
+    snprintf(device_arg, sizeof(device_arg), "-d%s", config->device);
+    snprintf(rate_arg, sizeof(rate_arg), "-r%d", config->sample_rate);
+    snprintf(period_arg, sizeof(period_arg), "-p%d", config->period);
+    snprintf(periods_arg, sizeof(periods_arg), "-n%d", config->periods);
+    
+    printf("Starting: jackd -dalsa %s %s %s %s -s\n", device_arg, rate_arg, period_arg, periods_arg);
+    fflush(stdout);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("Error: fork failed: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    if (pid == 0) {
+        // Own session so jackd survives the sampler and ignores its Ctrl+C
+        setsid();
+        execlp("jackd", "jackd", "-dalsa", device_arg, rate_arg, period_arg, periods_arg, "-s",
+               (char*)NULL);
+        _exit(127);
+    }
+    
+    return pid;
+}
+
+// Wait until the server answers, the process dies or the timeout expires
+static int wait_for_jackd(pid_t pid, int timeout_ms) {
+    int status;
+    
+    for (int waited = 0; waited < timeout_ms * 1000; waited += POLL_INTERVAL_US) {
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+                printf("  jackd not found. Install with: sudo apt install jackd2\n");
+            } else {
+                printf("  jackd exited, configuration not usable\n");
+            }
+            return -1;
+        }
+        
+        if (jack_launcher_server_running()) {
+            printf("  JACK server ready after %d ms\n", waited / 1000);
+            return 0;
+        }
+        
+        usleep(POLL_INTERVAL_US);
+    }
+    
+    printf("  Timeout waiting for jackd, stopping it\n");
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+    return -1;
+}
+
+// Try one configuration: quick in-process check, then launch
+static int try_config(const audio_device_config_t *config) {
+    int err = audio_probe_config(config);
+    if (err < 0) {
+        printf("  %s (%d Hz, %d frames) rejected by ALSA: %s\n",
+               config->device, config->sample_rate, config->period, snd_strerror(err));
+        return -1;
+    }
+    
+    pid_t pid = launch_jackd(config);
+    if (pid < 0) {
+        return -1;
+    }
+    return wait_for_jackd(pid, JACK_LAUNCHER_TIMEOUT_MS);
+}
+
+// Last resort: the shell script with its trial launches
+static int run_start_script(void) {
+    const char *start_script = "./start_jack.sh";
+    
+    // Check if script exists
+    if (access(start_script, F_OK) != 0) {
+        printf("Error: start_jack.sh not found\n");
+        return -1;
+    }
+    
+    // Execute the script and show output
+    printf("Executing: %s\n", start_script);
+    int result = system(start_script);
+    
+    if (result != 0) {
+        printf("Failed to execute start_jack.sh (exit code: %d)\n", result);
+        printf("Try running manually: %s\n", start_script);
+        return -1;
+    }
+    
+    // The script returns once jackd is up; give it a moment to accept clients
+    printf("Waiting for JACK to initialize");
+    for (int waited = 0; waited < 20000000; waited += POLL_INTERVAL_US) {
+        if (jack_launcher_server_running()) {
+            printf(" done!\n");
+            return 0;
+        }
+        if (waited % 1000000 == 0) {
+            printf(".");
+            fflush(stdout);
+        }
+        usleep(POLL_INTERVAL_US);
+    }
+    
+    printf(" timeout!\n");
+    return -1;
+}
+
+// Start jackd: cached configuration first, then probed ones, then start_jack.sh
+int jack_launcher_start(void) {
+    audio_device_config_t cached;
+    audio_device_config_t configs[AUDIO_PROBE_MAX_CONFIGS];
+    int have_cache = 0;
+    
+    printf("Starting JACK daemon automatically...\n");
+    
+    // 1. Known-good configuration from the last successful start
+    if (jack_launcher_load_cache(&cached) == 0) {
+        have_cache = 1;
+        printf("Trying cached configuration: %s (%s)\n", cached.device, cached.card_name);
+        if (try_config(&cached) == 0) {
+            boot_timer_mark("jackd start (cached)");
+            printf("JACK daemon started successfully\n");
+            return 0;
+        }
+        boot_timer_mark("jackd cached attempt failed");
+    }
+    
+    // 2. Probe the hardware in-process and launch the best candidates
+    int count = audio_probe_devices(configs, AUDIO_PROBE_MAX_CONFIGS);
+    boot_timer_mark("ALSA device probe");
+    
+    for (int i = 0; i < count; i++) {
+        if (have_cache && strcmp(configs[i].device, cached.device) == 0 &&
+            configs[i].sample_rate == cached.sample_rate && configs[i].period == cached.period) {
+            continue; // Already failed above
+        }
+        
+        if (try_config(&configs[i]) == 0) {
+            boot_timer_mark("jackd start (probed)");
+            printf("JACK daemon started successfully\n");
+            jack_launcher_save_cache(&configs[i]);
+            return 0;
+        }
+    }
+    
+    // 3. Fall back to the trial-and-error script
+    if (count == 0) {
+        printf("No usable configuration found by probing, falling back to start_jack.sh\n");
+    }
+    int result = run_start_script();
+    boot_timer_mark("start_jack.sh");
+    
+    if (result < 0) {
+        printf("JACK failed to start automatically. Try manual start:\n");
+        printf("  ./start_jack.sh\n");
+        printf("  OR\n");
+        printf("  jackd -dalsa -dhw:0 -r48000 -p1024 -n2 &\n");
+        return -1;
+    }
+    
+    printf("JACK daemon started successfully\n");
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef JACK_LAUNCHER_H
+#define JACK_LAUNCHER_H
+
+#include "audio_probe.h"
+
+// Where the last working jackd configuration is remembered (under $HOME)
+#define JACK_LAUNCHER_CACHE_DIR ".cache/rpi-sampler"
+#define JACK_LAUNCHER_CACHE_FILE "jack.conf"
+
+// Time allowed for a single jackd launch to become reachable
+#define JACK_LAUNCHER_TIMEOUT_MS 5000
+
+// Start jackd: cached configuration first, then probed ones, then start_jack.sh
+// Returns 0 once a JACK server is reachable, -1 otherwise
+int jack_launcher_start(void);
+
+// Check if a JACK server is reachable
+int jack_launcher_server_running(void);
+
+// Cached configuration access
+int jack_launcher_load_cache(audio_device_config_t *config);
+int jack_launcher_save_cache(const audio_device_config_t *config);
+
+#endif // JACK_LAUNCHER_H
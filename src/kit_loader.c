@@ -0,0 +1,339 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "kit_loader.h"
+#include "sample_loader.h"
+#include "config.h"
+
+typedef struct {
+    int program;
+    int count;                          // Distinct samples loaded
+    audio_sample_t *samples[16];
+    audio_sample_t *channels[16];       // Handed to the engine; stays valid until the kit is freed
+    unsigned long mark;                 // Retired kits: engine frame count of the last check
+} kit_t;
+
+static kit_loader_config_t kit_config;
+static int kit_initialized = 0;
+
+static char kits_directory[512];
+static char kit_names[KIT_LOADER_MAX_KITS][256];
+static int kit_count = 0;
+
+static int requested_program = -1;      // Written by the MIDI thread
+static int current_program = -1;        // Written by the worker
+
+// Worker thread only
+static kit_t *current_kit = NULL;
+static kit_t *retired_kits[KIT_LOADER_MAX_RETIRED];
+static int retired_count = 0;
+
+static pthread_t worker_thread;
+static int worker_running = 0;
+
+kit_loader_config_t kit_loader_get_default_config(void) {
+    kit_loader_config_t config = {
+        .enabled = 0,
+        .channel = -1
+    };
+    return config;
+}
+
+// Load the [KITS] section
+void kit_loader_load_config(kit_loader_config_t *config) {
+    config->enabled = config_get_bool("KITS", "enabled", config->enabled);
+    config->channel = config_get_int("KITS", "channel", config->channel + 1) - 1;
+    if (config->channel > 15) {
+        config->channel = -1;
+    }
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp((const char*)a, (const char*)b);
+}
+
+// Sorted names of a folder's kit subdirectories or sample files (caller frees)
+// Every match is collected before sorting, so the caps keep the first names alphabetically
+static int list_folder(const char *folder, int want_dirs, char (**names)[256]) {
+    *names = NULL;
+    DIR *dir = opendir(folder);
+    if (!dir) {
+        return -1;
+    }
+    
+    char (*list)[256] = NULL;
+    int count = 0;
+    int capacity = 0;
+    struct dirent *entry;
+    struct stat st;
+    char path[1024];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if (want_dirs) {
+            if (strcmp(entry->d_name, SAMPLE_LOADER_IR_FOLDER) == 0) {
+                continue;   // Impulse responses, not a kit
+            }
+            snprintf(path, sizeof(path), "%s/%s", folder, entry->d_name);
+            if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+                continue;
+            }
+        } else if (!sample_loader_is_sample_file(entry->d_name)) {
+            continue;
+        }
+        
+        if (count == capacity) {
+            int grown = capacity ? capacity * 2 : 32;
+            char (*bigger)[256] = realloc(list, (size_t)grown * sizeof(list[0]));
+            if (!bigger) {
+                break;
+            }
+            list = bigger;
+            capacity = grown;
+        }
+        snprintf(list[count++], sizeof(list[0]), "%s", entry->d_name);
+    }
+    closedir(dir);
+    
+    if (count > 1) {
+        qsort(list, count, sizeof(list[0]), compare_names);
+    }
+    *names = list;
+    return count;
+}
+
+// Find the kit subdirectories, sorted so program numbers stay stable
+static void scan_kits(void) {
+    char (*names)[256];
+    int count = list_folder(kits_directory, 1, &names);
+    
+    kit_count = 0;
+    for (int i = 0; i < count && kit_count < KIT_LOADER_MAX_KITS; i++) {
+        snprintf(kit_names[kit_count++], sizeof(kit_names[0]), "%s", names[i]);
+    }
+    if (count > KIT_LOADER_MAX_KITS) {
+        printf("Warning: %d kit folders, only the first %d are used\n", count, KIT_LOADER_MAX_KITS);
+    }
+    free(names);
+}
+
+static void free_kit(kit_t *kit) {
+    for (int i = 0; i < kit->count; i++) {
+        audio_sample_free(kit->samples[i]);
+    }
+    free(kit);
+}
+
+// Load a kit's samples; NULL if it has none or another program was requested meanwhile
+static kit_t* load_kit(int program) {
+    char kit_path[1024];
+    snprintf(kit_path, sizeof(kit_path), "%s/%s", kits_directory, kit_names[program]);
+    
+    char (*files)[256];
+    int file_count = list_folder(kit_path, 0, &files);
+    if (file_count < 0) {
+        printf("Error: Cannot open kit folder %s\n", kit_path);
+        return NULL;
+    }
+    if (file_count > 16) {
+        printf("Warning: Kit '%s' has %d samples, only the first 16 are loaded\n", kit_names[program], file_count);
+        file_count = 16;
+    }
+    
+    kit_t *kit = calloc(1, sizeof(kit_t));
+    if (!kit) {
+        free(files);
+        return NULL;
+    }
+    kit->program = program;
+    
+    for (int i = 0; i < file_count; i++) {
+        if (__atomic_load_n(&requested_program, __ATOMIC_ACQUIRE) != program) {
+            printf("Kit '%s' abandoned for a newer program change\n", kit_names[program]);
+            free(files);
+            free_kit(kit);
+            return NULL;
+        }
+        
+        char path[1536];
+        snprintf(path, sizeof(path), "%s/%.255s", kit_path, files[i]);
+        audio_sample_t *sample = sample_loader_load_sample(path);
+        if (sample) {
+            kit->samples[kit->count++] = sample;
+        }
+    }
+    free(files);
+    
+    if (kit->count == 0) {
+        printf("Warning: Kit '%s' has no playable samples\n", kit_names[program]);
+        free_kit(kit);
+        return NULL;
+    }
+    
+    for (int ch = 0; ch < 16; ch++) {
+        kit->channels[ch] = kit->count == 1 ? kit->samples[0] : (ch < kit->count ? kit->samples[ch] : NULL);
+    }
+    return kit;
+}
+
+// Free retired kits once no voice has played any of their samples for a whole block
+static void reclaim_retired_kits(void) {
+    unsigned long now = audio_engine_get_frames_processed();
+    
+    for (int r = 0; r < retired_count; r++) {
+        kit_t *kit = retired_kits[r];
+        int playing = 0;
+        for (int i = 0; i < kit->count; i++) {
+            if (__atomic_load_n(&kit->samples[i]->last_used, __ATOMIC_RELAXED) >= kit->mark) {
+                playing = 1;
+            }
+        }
+        
+        if (playing) {
+            kit->mark = now;
+        } else if (now > kit->mark) {
+            printf("Kit '%s' released\n", kit_names[kit->program]);
+            free_kit(kit);
+            retired_kits[r--] = retired_kits[--retired_count];
+        }
+    }
+}
+
+// Load the wanted kit and swap it in at the next block
+static void switch_kit(int program) {
+    if (retired_count == KIT_LOADER_MAX_RETIRED) {
+        return;     // Old kits still ringing; try again once one is freed
+    }
+    
+    printf("Loading kit %d '%s'...\n", program + 1, kit_names[program]);
+    kit_t *kit = load_kit(program);
+    if (!kit) {
+        // Give up on this program unless a newer one is already waiting
+        __atomic_compare_exchange_n(&requested_program, &program, current_program, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        return;
+    }
+    
+    unsigned long applied = audio_engine_get_kits_applied();
+    if (audio_engine_set_kit(kit->channels) < 0) {
+        free_kit(kit);
+        return;     // Queue full; the next poll loads it again
+    }
+    while (audio_engine_get_kits_applied() == applied) {
+        if (!__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+            // Shutting down before the swap: the engine may still take the command
+            retired_kits[retired_count++] = kit;
+            kit->mark = (unsigned long)-1;
+            return;
+        }
+        usleep(1000);
+    }
+    
+    if (current_kit) {
+        current_kit->mark = audio_engine_get_frames_processed();
+        retired_kits[retired_count++] = current_kit;
+    }
+    current_kit = kit;
+    __atomic_store_n(&current_program, program, __ATOMIC_RELEASE);
+    printf("Kit %d '%s' playing (%d samples)\n", program + 1, kit_names[program], kit->count);
+}
+
+static void* worker_func(void *arg) {
+    (void)arg;
+    
+    while (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+        reclaim_retired_kits();
+        
+        int program = __atomic_load_n(&requested_program, __ATOMIC_ACQUIRE);
+        if (program >= 0 && program != __atomic_load_n(&current_program, __ATOMIC_RELAXED)) {
+            switch_kit(program);
+        }
+        usleep(KIT_LOADER_POLL_MS * 1000);
+    }
+    
+    return NULL;
+}
+
+// Find the kits and start the worker (does nothing unless [KITS] enabled)
+int kit_loader_init(const kit_loader_config_t *config, const char *samples_dir) {
+    if (kit_initialized) {
+        return 0;
+    }
+    
+    kit_config = *config;
+    if (!kit_config.enabled) {
+        return 0;
+    }
+    
+    snprintf(kits_directory, sizeof(kits_directory), "%s", samples_dir);
+    scan_kits();
+    if (kit_count == 0) {
+        printf("Warning: No kit folders in %s, program changes ignored\n", kits_directory);
+        return -1;
+    }
+    
+    requested_program = -1;
+    current_program = -1;
+    __atomic_store_n(&worker_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&worker_thread, NULL, worker_func, NULL) != 0) {
+        printf("Error: Cannot start kit loader thread\n");
+        worker_running = 0;
+        return -1;
+    }
+    
+    kit_initialized = 1;
+    if (kit_config.channel < 0) {
+        printf("Kits: %d folders, switched by program change on any channel\n", kit_count);
+    } else {
+        printf("Kits: %d folders, switched by program change on channel %d\n", kit_count, kit_config.channel + 1);
+    }
+    for (int i = 0; i < kit_count; i++) {
+        printf("  Program %d: %s\n", i + 1, kit_names[i]);
+    }
+    return 0;
+}
+
+// Stop the worker and free every kit (after JACK deactivation)
+void kit_loader_cleanup(void) {
+    if (!kit_initialized) {
+        return;
+    }
+    
+    __atomic_store_n(&worker_running, 0, __ATOMIC_RELEASE);
+    pthread_join(worker_thread, NULL);
+    
+    for (int r = 0; r < retired_count; r++) {
+        free_kit(retired_kits[r]);
+    }
+    retired_count = 0;
+    if (current_kit) {
+        free_kit(current_kit);
+        current_kit = NULL;
+    }
+    kit_initialized = 0;
+}
+
+// Record the latest program change; the worker does the rest
+void kit_loader_handle_events(const midi_event_t *events, int count) {
+    if (!kit_initialized) {
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        if (e->type == MIDI_EVENT_PROGRAM && e->data1 < kit_count &&
+            (kit_config.channel < 0 || e->channel == kit_config.channel)) {
+            __atomic_store_n(&requested_program, (int)e->data1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+int kit_loader_get_current(void) {
+    return __atomic_load_n(&current_program, __ATOMIC_ACQUIRE);
+}
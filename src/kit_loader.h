@@ -0,0 +1,48 @@
+#ifndef KIT_LOADER_H
+#define KIT_LOADER_H
+
+#include "audio_engine.h"
+#include "midi.h"
+
+// Kits are subdirectories of the samples folder, in alphabetical order (program 1 = first);
+// the impulse response folder (SAMPLE_LOADER_IR_FOLDER) is not a kit
+#define KIT_LOADER_MAX_KITS 128
+#define KIT_LOADER_MAX_RETIRED 4
+
+// Worker thread polling interval (the MIDI thread never signals it)
+#define KIT_LOADER_POLL_MS 20
+
+// Kit switching configuration ([KITS] section)
+typedef struct {
+    int enabled;
+    int channel;                // MIDI channel (0-15) whose program changes switch kits, -1 = any
+} kit_loader_config_t;
+
+// Program change kit switching
+//
+// A program change only records the wanted kit. A normal-priority worker
+// loads that kit's samples (through the pool and memory budget like any
+// other sample), then hands all 16 channel assignments to the audio thread
+// in one engine command, applied at the start of a block. Voices already
+// playing keep their old samples and ring out; the old kit is freed once
+// no voice has played any of its samples for a whole block. A newer
+// program change while a kit is loading abandons that load.
+//
+// Sample files of a kit go to MIDI channels 1-16 in alphabetical order; a
+// kit with a single file plays it on every channel.
+
+// Configuration
+kit_loader_config_t kit_loader_get_default_config(void);
+void kit_loader_load_config(kit_loader_config_t *config);
+
+// Setup (not real-time safe; after sample_loader_init)
+int kit_loader_init(const kit_loader_config_t *config, const char *samples_dir);
+void kit_loader_cleanup(void);
+
+// MIDI thread: program changes (never blocks)
+void kit_loader_handle_events(const midi_event_t *events, int count);
+
+// Status: program of the kit playing now (-1 = the samples folder itself)
+int kit_loader_get_current(void);
+
+#endif // KIT_LOADER_H
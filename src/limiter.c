@@ -0,0 +1,103 @@
+#include <math.h>
+#include <string.h>
+#include "limiter.h"
+#include "dsp.h"
+
+// Setup
+void limiter_init(limiter_t *limiter, float ceiling, float release_ms, float smoothing_ms) {
+    memset(limiter, 0, sizeof(*limiter));
+    limiter->ceiling = ceiling;
+    limiter->release_ms = release_ms;
+    limiter->smoothing_ms = smoothing_ms;
+    limiter->input_gain = 1.0f;
+    limiter->input_gain_target = 1.0f;
+    limiter_configure(limiter, 48000, 1024);
+}
+
+// Pick the sub-block length and per sub-block coefficients
+// The look-ahead must divide the buffer size so sub-blocks never straddle cycles
+void limiter_configure(limiter_t *limiter, int sample_rate, int buffer_size) {
+    int lookahead = LIMITER_MAX_LOOKAHEAD;
+    while (lookahead > 1 && buffer_size % lookahead != 0) {
+        lookahead /= 2;
+    }
+    
+    limiter->sample_rate = sample_rate;
+    limiter->lookahead = lookahead;
+    
+    float block_seconds = (float)lookahead / (float)sample_rate;
+    limiter->release_coeff = 1.0f - expf(-block_seconds * 1000.0f / limiter->release_ms);
+    limiter->smoothing_coeff = 1.0f - expf(-block_seconds * 1000.0f / limiter->smoothing_ms);
+    
+    limiter_reset(limiter);
+}
+
+// Clear delayed audio and gain state; the input gain jumps to its target
+void limiter_reset(limiter_t *limiter) {
+    limiter->input_gain = limiter->input_gain_target;
+    limiter->gain = 1.0f;
+    limiter->pending_peak = 0.0f;
+    memset(limiter->delay_left, 0, sizeof(limiter->delay_left));
+    memset(limiter->delay_right, 0, sizeof(limiter->delay_right));
+}
+
+// Set the gain applied before limiting (smoothed per sample)
+void limiter_set_input_gain(limiter_t *limiter, float gain) {
+    limiter->input_gain_target = gain;
+}
+
+// Process one buffer; input and output may be the same buffers
+// out_right may be NULL for mono (in_right is then ignored)
+void limiter_process(limiter_t *limiter, const float *in_left, const float *in_right,
+                     float *out_left, float *out_right, int nframes) {
+    const int lookahead = limiter->lookahead;
+    float incoming_left[LIMITER_MAX_LOOKAHEAD];
+    float incoming_right[LIMITER_MAX_LOOKAHEAD];
+    
+    // Only happens if called with a size limiter_configure wasn't told about
+    if (nframes % lookahead != 0) {
+        limiter_configure(limiter, limiter->sample_rate, nframes);
+    }
+    
+    for (int offset = 0; offset < nframes; offset += lookahead) {
+        // Smoothed input gain, ramped across the sub-block
+        float input_from = limiter->input_gain;
+        float input_to = input_from + (limiter->input_gain_target - input_from) * limiter->smoothing_coeff;
+        limiter->input_gain = input_to;
+        
+        dsp_apply_ramp(in_left + offset, incoming_left, lookahead, input_from, input_to);
+        float peak = dsp_peak(incoming_left, lookahead);
+        if (out_right) {
+            dsp_apply_ramp(in_right + offset, incoming_right, lookahead, input_from, input_to);
+            float peak_right = dsp_peak(incoming_right, lookahead);
+            peak = fmaxf(peak, peak_right);
+        }
+        
+        // Gain that keeps both the delayed and the incoming sub-block under the ceiling
+        float loudest = fmaxf(fmaxf(peak, limiter->pending_peak), limiter->ceiling);
+        float required = limiter->ceiling / loudest;
+        float released = limiter->gain + (1.0f - limiter->gain) * limiter->release_coeff;
+        float target = fminf(required, released);
+        
+        // Output the delayed sub-block with the gain ramping to the target
+        dsp_apply_ramp(limiter->delay_left, out_left + offset, lookahead, limiter->gain, target);
+        memcpy(limiter->delay_left, incoming_left, lookahead * sizeof(float));
+        if (out_right) {
+            dsp_apply_ramp(limiter->delay_right, out_right + offset, lookahead, limiter->gain, target);
+            memcpy(limiter->delay_right, incoming_right, lookahead * sizeof(float));
+        }
+        
+        limiter->gain = target;
+        limiter->pending_peak = peak;
+    }
+}
+
+// True when no audio is left in the delay line
+int limiter_is_idle(const limiter_t *limiter) {
+    return limiter->pending_peak == 0.0f;
+}
+
+// Current limiter gain (1.0 = no reduction); approximate when read from another thread
+float limiter_get_gain(const limiter_t *limiter) {
+    return limiter->gain;
+}
@@ -0,0 +1,48 @@
+#ifndef LIMITER_H
+#define LIMITER_H
+
+// Longest look-ahead (frames); the actual value divides the JACK buffer size
+#define LIMITER_MAX_LOOKAHEAD 32
+
+// Defaults
+#define LIMITER_DEFAULT_CEILING 0.95f       // Output ceiling (linear, about -0.45 dBFS)
+#define LIMITER_DEFAULT_RELEASE_MS 80.0f    // Gain recovery time constant
+#define LIMITER_DEFAULT_SMOOTHING_MS 20.0f  // Input gain smoothing time constant
+
+// Stereo-linked look-ahead peak limiter with a smoothed input gain
+//
+// The signal is delayed by one look-ahead sub-block. For each sub-block the
+// gain ramps linearly towards a target that already respects the peaks of
+// both the delayed and the incoming sub-block, so the output never exceeds
+// the ceiling and the gain never jumps.
+typedef struct {
+    float ceiling;              // Output ceiling (linear)
+    float release_ms;           // Release time constant
+    float smoothing_ms;         // Input gain smoothing time constant
+    int lookahead;              // Sub-block length in frames
+    int sample_rate;
+    
+    float release_coeff;        // Per sub-block release coefficient
+    float smoothing_coeff;      // Per sub-block input gain coefficient
+    
+    float input_gain;           // Current input gain
+    float input_gain_target;    // Requested input gain
+    float gain;                 // Limiter gain at the end of the last sub-block
+    float pending_peak;         // Peak of the delayed sub-block
+    float delay_left[LIMITER_MAX_LOOKAHEAD];
+    float delay_right[LIMITER_MAX_LOOKAHEAD];
+} limiter_t;
+
+// Setup (not real-time safe, no allocation though)
+void limiter_init(limiter_t *limiter, float ceiling, float release_ms, float smoothing_ms);
+void limiter_configure(limiter_t *limiter, int sample_rate, int buffer_size);
+void limiter_reset(limiter_t *limiter);
+
+// Real-time functions
+void limiter_set_input_gain(limiter_t *limiter, float gain);
+void limiter_process(limiter_t *limiter, const float *in_left, const float *in_right,
+                     float *out_left, float *out_right, int nframes);
+int limiter_is_idle(const limiter_t *limiter);
+float limiter_get_gain(const limiter_t *limiter);
+
+#endif // LIMITER_H
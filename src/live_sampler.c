@@ -0,0 +1,354 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <jack/jack.h>
+#include "live_sampler.h"
+#include "sample_loader.h"
+#include "jack_client.h"
+#include "config.h"
+
+// Capture states; each transition has a single owner
+typedef enum {
+    LIVE_IDLE,                  // Nothing to do (arming starts here)
+    LIVE_ARMING,                // Control thread is silencing the slot
+    LIVE_ARMED,                 // Audio thread waits for the trigger
+    LIVE_CAPTURING,             // Audio thread copies input into the slot
+    LIVE_CAPTURED               // Worker trims and publishes the slot, then goes idle
+} live_state_t;
+
+static live_sampler_config_t live_config;
+static int live_initialized = 0;
+static int live_sample_rate = 48000;
+static jack_port_t *input_ports[2] = {NULL, NULL};
+static int input_channels = 1;
+
+// Preallocated, locked capture slots (interleaved like loaded samples)
+static float *slot_buffers[LIVE_SAMPLER_SLOTS];
+static audio_sample_t slot_samples[LIVE_SAMPLER_SLOTS];
+static int slot_capacity = 0;               // Frames per slot
+static int capture_slot = 0;                // Slot being armed/recorded (set while arming)
+static int published_slot = -1;             // Slot the channel plays (-1 = none yet)
+
+static int capture_state = LIVE_IDLE;
+static int stop_requested = 0;
+static int note_triggered = 0;
+static int trigger_note = -1;               // Note that started a note-triggered capture (MIDI thread)
+
+// Audio thread only, handed to the worker with LIVE_CAPTURED
+static int capture_frames = 0;
+static int silent_frames = 0;
+static float threshold = 0.0f;              // Linear trigger level
+static int silence_limit = 0;               // Frames below the threshold that stop a capture
+
+// Worker thread
+static pthread_t worker_thread;
+static int worker_running = 0;
+
+live_sampler_config_t live_sampler_get_default_config(void) {
+    live_sampler_config_t config = {
+        .enabled = 0,
+        .inputs = 2,
+        .max_seconds = LIVE_SAMPLER_DEFAULT_SECONDS,
+        .channel = 0,
+        .note_trigger = 0,
+        .threshold_db = -40.0f,
+        .silence_ms = 1000,
+        .arm_cc = -1
+    };
+    return config;
+}
+
+// Load the [LIVE_SAMPLING] section
+void live_sampler_load_config(live_sampler_config_t *config) {
+    config->enabled = config_get_bool("LIVE_SAMPLING", "enabled", config->enabled);
+    config->inputs = config_get_int("LIVE_SAMPLING", "inputs", config->inputs) == 1 ? 1 : 2;
+    config->max_seconds = config_get_int("LIVE_SAMPLING", "max_seconds", config->max_seconds);
+    if (config->max_seconds < 1) {
+        config->max_seconds = 1;
+    }
+    config->channel = (config_get_int("LIVE_SAMPLING", "channel", config->channel + 1) - 1) & 0x0F;
+    config->note_trigger = strcmp(config_get_string("LIVE_SAMPLING", "trigger",
+                                                    config->note_trigger ? "note" : "threshold"), "note") == 0;
+    config->threshold_db = config_get_float("LIVE_SAMPLING", "threshold_db", config->threshold_db);
+    config->silence_ms = config_get_int("LIVE_SAMPLING", "silence_ms", config->silence_ms);
+    config->arm_cc = config_get_int("LIVE_SAMPLING", "arm_cc", config->arm_cc);
+}
+
+// Loudest input sample of the block (both channels)
+static float block_peak(const float *const *inputs, jack_nframes_t nframes) {
+    float peak = 0.0f;
+    for (int c = 0; c < input_channels; c++) {
+        for (jack_nframes_t f = 0; f < nframes; f++) {
+            float value = fabsf(inputs[c][f]);
+            if (value > peak) peak = value;
+        }
+    }
+    return peak;
+}
+
+// Trim the captured slot and make it the channel's sample (worker thread)
+static void publish_capture(void) {
+    int slot = capture_slot;
+    int frames = capture_frames;
+    const float *data = slot_buffers[slot];
+    float trim = powf(10.0f, config_get_float("SAMPLES", "trim_threshold_db", SAMPLE_TRIM_THRESHOLD_DB) / 20.0f);
+    
+    // Same trim as loaded samples, but by moving the start instead of reallocating
+    int first = -1;
+    int last = -1;
+    for (int f = 0; f < frames; f++) {
+        for (int c = 0; c < input_channels; c++) {
+            if (fabsf(data[f * input_channels + c]) > trim) {
+                if (first < 0) first = f;
+                last = f;
+                break;
+            }
+        }
+    }
+    if (first < 0) {
+        printf("Live sampling: nothing above the trim threshold, channel %d unchanged\n", live_config.channel + 1);
+        __atomic_store_n(&capture_state, LIVE_IDLE, __ATOMIC_RELEASE);
+        return;
+    }
+    
+    int start = first - SAMPLE_TRIM_PREROLL_MS * live_sample_rate / 1000;
+    int end = last + 1 + SAMPLE_TRIM_TAIL_MS * live_sample_rate / 1000;
+    if (start < 0) start = 0;
+    if (end > frames) end = frames;
+    
+    // Nothing plays this slot: its voices were stopped when it was armed
+    audio_sample_t *sample = &slot_samples[slot];
+    sample->data = slot_buffers[slot] + (size_t)start * input_channels;
+    sample->frames = end - start;
+    sample->channels = input_channels;
+    sample->sample_rate = live_sample_rate;
+    sample->loop_start = 0;
+    sample->loop_end = 0;
+    sample_loader_analyze(sample);
+    
+    audio_engine_set_channel_sample(live_config.channel, sample);
+    __atomic_store_n(&published_slot, slot, __ATOMIC_RELEASE);
+    __atomic_store_n(&capture_state, LIVE_IDLE, __ATOMIC_RELEASE);
+    
+    printf("Live sampling: %.2f s on channel %d (peak %.1f dBFS, %.1f ms trimmed)\n",
+           (float)sample->frames / live_sample_rate, live_config.channel + 1,
+           20.0f * log10f(sample->peak > 1e-9f ? sample->peak : 1e-9f),
+           (frames - sample->frames) * 1000.0f / live_sample_rate);
+}
+
+static void* worker_func(void *arg) {
+    (void)arg;
+    
+    while (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+        if (__atomic_load_n(&capture_state, __ATOMIC_ACQUIRE) == LIVE_CAPTURED) {
+            publish_capture();
+        }
+        usleep(LIVE_SAMPLER_POLL_MS * 1000);
+    }
+    
+    return NULL;
+}
+
+// Allocate and lock the slots and start the worker (does nothing unless [LIVE_SAMPLING] enabled)
+int live_sampler_init(const live_sampler_config_t *config, int sample_rate) {
+    if (live_initialized) {
+        return 0;
+    }
+    
+    live_config = *config;
+    if (!live_config.enabled) {
+        return 0;
+    }
+    
+    input_ports[0] = jack_client_get_input_port(0);
+    input_ports[1] = jack_client_get_input_port(1);
+    if (!input_ports[0]) {
+        printf("Error: Live sampling needs JACK input ports\n");
+        return -1;
+    }
+    input_channels = input_ports[1] ? 2 : 1;
+    live_sample_rate = sample_rate > 0 ? sample_rate : 48000;
+    slot_capacity = live_config.max_seconds * live_sample_rate;
+    
+    // Written once here so every page is resident before the audio thread touches it
+    size_t bytes = (size_t)slot_capacity * input_channels * sizeof(float);
+    for (int i = 0; i < LIVE_SAMPLER_SLOTS; i++) {
+        slot_buffers[i] = malloc(bytes);
+        if (!slot_buffers[i]) {
+            printf("Error: Cannot allocate %zu bytes for live sampling\n", bytes);
+            live_sampler_cleanup();
+            return -1;
+        }
+        memset(slot_buffers[i], 0, bytes);
+        if (mlock(slot_buffers[i], bytes) != 0) {
+            printf("Warning: Cannot lock live sampling slot %d in memory\n", i);
+        }
+        memset(&slot_samples[i], 0, sizeof(slot_samples[i]));
+    }
+    
+    threshold = powf(10.0f, live_config.threshold_db / 20.0f);
+    silence_limit = live_config.note_trigger ? 0 : (int)((long)live_config.silence_ms * live_sample_rate / 1000);
+    
+    __atomic_store_n(&worker_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&worker_thread, NULL, worker_func, NULL) != 0) {
+        printf("Error: Cannot start the live sampling thread\n");
+        worker_running = 0;
+        live_sampler_cleanup();
+        return -1;
+    }
+    
+    live_initialized = 1;
+    printf("Live sampling: %d s %s slots, channel %d, %s trigger\n", live_config.max_seconds,
+           input_channels == 2 ? "stereo" : "mono", live_config.channel + 1,
+           live_config.note_trigger ? "note-on" : "threshold");
+    return 0;
+}
+
+// Stop the worker and free the slots (the audio thread must have stopped)
+void live_sampler_cleanup(void) {
+    if (live_initialized) {
+        __atomic_store_n(&worker_running, 0, __ATOMIC_RELEASE);
+        pthread_join(worker_thread, NULL);
+        if (published_slot >= 0) {
+            audio_engine_set_channel_sample(live_config.channel, NULL);
+        }
+    }
+    
+    for (int i = 0; i < LIVE_SAMPLER_SLOTS; i++) {
+        free(slot_samples[i].zero_crossings);
+        memset(&slot_samples[i], 0, sizeof(slot_samples[i]));
+        free(slot_buffers[i]);
+        slot_buffers[i] = NULL;
+    }
+    
+    published_slot = -1;
+    capture_state = LIVE_IDLE;
+    live_initialized = 0;
+}
+
+// Wait for the next trigger, recording into the slot the channel isn't playing
+int live_sampler_arm(void) {
+    if (!live_initialized) {
+        return -1;
+    }
+    
+    int expected = LIVE_IDLE;
+    if (!__atomic_compare_exchange_n(&capture_state, &expected, LIVE_ARMING, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return expected == LIVE_CAPTURED ? -1 : 0;   // Already armed or capturing
+    }
+    
+    // Voices may still be playing the slot from the capture before last
+    int slot = __atomic_load_n(&published_slot, __ATOMIC_ACQUIRE) == 0 ? 1 : 0;
+    if (audio_engine_stop_sample(&slot_samples[slot]) < 0) {
+        printf("Warning: Engine command queue full, live sampling not armed\n");
+        __atomic_store_n(&capture_state, LIVE_IDLE, __ATOMIC_RELEASE);
+        return -1;
+    }
+    
+    capture_slot = slot;
+    __atomic_store_n(&stop_requested, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&note_triggered, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&capture_state, LIVE_ARMED, __ATOMIC_RELEASE);
+    printf("Live sampling: armed\n");
+    return 0;
+}
+
+// Disarm, or end the capture in progress
+void live_sampler_stop(void) {
+    __atomic_store_n(&stop_requested, 1, __ATOMIC_RELEASE);
+}
+
+// Arm/stop from the configured CC, note-on trigger and note-off stop (MIDI thread)
+void live_sampler_handle_events(const midi_event_t *events, int count) {
+    if (!live_initialized) {
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        
+        if (e->type == MIDI_EVENT_CC && e->data1 == live_config.arm_cc) {
+            if (e->data2 >= 64) {
+                live_sampler_arm();
+            } else {
+                live_sampler_stop();
+            }
+        } else if (live_config.note_trigger && e->channel == live_config.channel) {
+            int state = __atomic_load_n(&capture_state, __ATOMIC_ACQUIRE);
+            int triggered = __atomic_load_n(&note_triggered, __ATOMIC_ACQUIRE);
+            
+            if (e->type == MIDI_EVENT_NOTE_ON && state == LIVE_ARMED && !triggered) {
+                trigger_note = e->data1;
+                __atomic_store_n(&note_triggered, 1, __ATOMIC_RELEASE);
+            } else if (e->type == MIDI_EVENT_NOTE_OFF && e->data1 == trigger_note &&
+                       (triggered || state == LIVE_CAPTURING)) {
+                trigger_note = -1;
+                live_sampler_stop();
+            }
+        }
+    }
+}
+
+// Trigger detection and capture of one input block (after rendering, so a
+// slot silenced at this block's start is never read while being written)
+void live_sampler_capture(jack_nframes_t nframes) {
+    if (!live_initialized) {
+        return;
+    }
+    
+    int state = __atomic_load_n(&capture_state, __ATOMIC_ACQUIRE);
+    if (state != LIVE_ARMED && state != LIVE_CAPTURING) {
+        return;
+    }
+    
+    const float *inputs[2];
+    inputs[0] = (const float*)jack_port_get_buffer(input_ports[0], nframes);
+    inputs[1] = input_ports[1] ? (const float*)jack_port_get_buffer(input_ports[1], nframes) : NULL;
+    float peak = block_peak(inputs, nframes);
+    int stop = __atomic_exchange_n(&stop_requested, 0, __ATOMIC_ACQ_REL);
+    
+    if (state == LIVE_ARMED) {
+        // A trigger in the same block as the stop still records this block
+        int triggered = live_config.note_trigger ?
+            __atomic_exchange_n(&note_triggered, 0, __ATOMIC_ACQ_REL) : peak > threshold;
+        if (!triggered) {
+            if (stop) {
+                __atomic_store_n(&capture_state, LIVE_IDLE, __ATOMIC_RELEASE);
+            }
+            return;
+        }
+        capture_frames = 0;
+        silent_frames = 0;
+        __atomic_store_n(&capture_state, LIVE_CAPTURING, __ATOMIC_RELEASE);
+    }
+    
+    int frames = (int)nframes < slot_capacity - capture_frames ? (int)nframes : slot_capacity - capture_frames;
+    float *dst = slot_buffers[capture_slot] + (size_t)capture_frames * input_channels;
+    if (input_channels == 2) {
+        for (int f = 0; f < frames; f++) {
+            dst[f * 2] = inputs[0][f];
+            dst[f * 2 + 1] = inputs[1][f];
+        }
+    } else {
+        memcpy(dst, inputs[0], frames * sizeof(float));
+    }
+    capture_frames += frames;
+    
+    if (silence_limit > 0) {
+        silent_frames = peak > threshold ? 0 : silent_frames + (int)nframes;
+    }
+    
+    if (stop || capture_frames >= slot_capacity || (silence_limit > 0 && silent_frames >= silence_limit)) {
+        __atomic_store_n(&capture_state, LIVE_CAPTURED, __ATOMIC_RELEASE);
+    }
+}
+
+int live_sampler_is_capturing(void) {
+    return __atomic_load_n(&capture_state, __ATOMIC_RELAXED) == LIVE_CAPTURING;
+}
@@ -0,0 +1,56 @@
+#ifndef LIVE_SAMPLER_H
+#define LIVE_SAMPLER_H
+
+#include "audio_engine.h"
+#include "midi.h"
+
+// Capture slots: one holds the published sample while the other records
+#define LIVE_SAMPLER_SLOTS 2
+
+// Longest capture per slot ([LIVE_SAMPLING] max_seconds)
+#define LIVE_SAMPLER_DEFAULT_SECONDS 10
+
+// Worker thread polling interval (the audio thread never signals it)
+#define LIVE_SAMPLER_POLL_MS 20
+
+// Live sampling configuration ([LIVE_SAMPLING] section)
+typedef struct {
+    int enabled;                // Register JACK inputs and allocate the slots
+    int inputs;                 // Input ports (1 = mono, 2 = stereo)
+    int max_seconds;            // Slot length
+    int channel;                // MIDI channel (0-15) that plays each new recording
+    int note_trigger;           // Start on a note-on of that channel instead of the input level
+    float threshold_db;         // Input level that starts a capture (threshold trigger)
+    int silence_ms;             // Stop after this long below the threshold (threshold trigger, 0 = off)
+    int arm_cc;                 // Controller that arms (>= 64) / stops (< 64) a capture, -1 = none
+} live_sampler_config_t;
+
+// Live input sampling
+//
+// Arming stops any voice still playing the slot to be recorded, then the
+// audio thread waits for the trigger and copies input blocks straight into
+// that preallocated, locked slot. When the capture stops, a normal-priority
+// worker trims it, measures it and publishes it as the channel's sample,
+// so the audio thread never allocates or locks and the next note-on
+// plays the new recording.
+
+// Configuration
+live_sampler_config_t live_sampler_get_default_config(void);
+void live_sampler_load_config(live_sampler_config_t *config);
+
+// Setup (not real-time safe; after audio_engine_init and jack_client_init)
+int live_sampler_init(const live_sampler_config_t *config, int sample_rate);
+void live_sampler_cleanup(void);
+
+// Control (any thread, never blocks)
+int live_sampler_arm(void);
+void live_sampler_stop(void);
+void live_sampler_handle_events(const midi_event_t *events, int count);
+
+// Real-time safe (audio thread only)
+void live_sampler_capture(jack_nframes_t nframes);
+
+// Status
+int live_sampler_is_capturing(void);
+
+#endif // LIVE_SAMPLER_H
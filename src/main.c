@@ -3,12 +3,31 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include "midi.h"
 #include "jack_client.h"
 #include "audio_engine.h"
 #include "sample_loader.h"
+#include "boot_timer.h"
+#include "config.h"
+#include "rt_setup.h"
+#include "engine_setup.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "recorder.h"
+#include "live_sampler.h"
+#include "midi_clock.h"
+#include "sequencer.h"
+#include "kit_loader.h"
 
-static int running = 1;
+static volatile sig_atomic_t running = 1;
+static volatile sig_atomic_t dump_trace = 0;
+static int debug_midi = 0;
+
+// MIDI input thread
+static pthread_t midi_thread;
+static sem_t midi_thread_ready;
 
 void signal_handler(int sig) {
     (void)sig; // Suppress unused parameter warning
@@ -16,85 +35,135 @@ void signal_handler(int sig) {
     running = 0;
 }
 
-// MIDI event callback functions
-void on_midi_note(midi_note_event_t *event) {
-    if (event->is_note_on) {
-        printf("Note ON:  Channel=%d, Note=%d, Velocity=%d -> Playing sample\n",
-               event->channel, event->note, event->velocity);
+// SIGUSR1: dump the trace ring (written by the main loop, not the handler)
+static void trace_signal_handler(int sig) {
+    (void)sig;
+    dump_trace = 1;
+}
+
+// Print a batch of MIDI events (debug only, keeps stdout quiet otherwise)
+static void print_midi_events(const midi_event_t *events, int count) {
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
         
-        // Play the loaded sample
-        audio_sample_t *sample = sample_loader_get_first_sample();
-        if (sample) {
-            if (audio_engine_play_sample(sample) < 0) {
-                printf("Error playing sample\n");
-            }
-        } else {
-            printf("No sample loaded to play\n");
+        switch (e->type) {
+            case MIDI_EVENT_NOTE_ON:
+                printf("Note ON:  Channel=%d, Note=%d, Velocity=%d, Source=%d\n",
+                       e->channel, e->data1, e->data2, e->source);
+                break;
+            case MIDI_EVENT_NOTE_OFF:
+                printf("Note OFF: Channel=%d, Note=%d, Source=%d\n",
+                       e->channel, e->data1, e->source);
+                break;
+            case MIDI_EVENT_CC:
+                printf("CC:       Channel=%d, Controller=%d, Value=%d\n",
+                       e->channel, e->data1, e->data2);
+                break;
+            case MIDI_EVENT_PITCH:
+                printf("Pitch:    Channel=%d, Value=%d\n",
+                       e->channel, midi_event_pitch_value(e));
+                break;
+            case MIDI_EVENT_PROGRAM:
+                printf("Program:  Channel=%d, Program=%d\n", e->channel, e->data1);
+                break;
+            case MIDI_EVENT_PRESSURE:
+                printf("ChanPress: Channel=%d, Value=%d\n", e->channel, e->data1);
+                break;
+            case MIDI_EVENT_KEY_PRESSURE:
+                printf("KeyPress: Channel=%d, Note=%d, Value=%d\n",
+                       e->channel, e->data1, e->data2);
+                break;
+            case MIDI_EVENT_START:
+                printf("MIDI Start\n");
+                break;
+            case MIDI_EVENT_STOP:
+                printf("MIDI Stop\n");
+                break;
+            case MIDI_EVENT_CONTINUE:
+                printf("MIDI Continue\n");
+                break;
+            case MIDI_EVENT_CLOCK:
+                // 24 per beat; the tempo is reported when the clock locks
+                break;
         }
-    } else {
-        printf("Note OFF: Channel=%d, Note=%d\n",
-               event->channel, event->note);
     }
 }
 
-void on_midi_cc(midi_cc_event_t *event) {
-    printf("CC:       Channel=%d, Controller=%d, Value=%d\n",
-           event->channel, event->controller, event->value);
-}
-
-void on_midi_pitch(midi_pitch_event_t *event) {
-    printf("Pitch:    Channel=%d, Value=%d\n",
-           event->channel, event->value);
-}
-
-void on_midi_program(midi_program_event_t *event) {
-    printf("Program:  Channel=%d, Program=%d\n",
-           event->channel, event->program);
-}
-
-void on_midi_pressure(midi_pressure_event_t *event) {
-    printf("ChanPress: Channel=%d, Value=%d\n",
-           event->channel, event->pressure);
-}
-
-void on_midi_key_pressure(midi_key_pressure_event_t *event) {
-    printf("KeyPress: Channel=%d, Note=%d, Value=%d\n",
-           event->channel, event->note, event->pressure);
-}
-
-void on_midi_start(void) {
-    printf("MIDI Start\n");
-}
-
-void on_midi_stop(void) {
-    printf("MIDI Stop\n");
-}
-
-void on_midi_continue(void) {
-    printf("MIDI Continue\n");
+// MIDI thread: wait for input, decode it and hand whole batches to the engine
+static void* midi_thread_func(void *arg) {
+    (void)arg;
+    midi_event_t midi_batch[MIDI_BATCH_SIZE];
+    
+    rt_setup_thread(RT_THREAD_MIDI);
+    sem_post(&midi_thread_ready);
+    
+    while (running) {
+        // Wakes as soon as input arrives; the timeout only bounds shutdown time
+        if (midi_wait_events(100) <= 0) {
+            continue;
+        }
+        
+        int received = midi_read_events(midi_batch, MIDI_BATCH_SIZE);
+        if (received > 0) {
+            trace_record(TRACE_MIDI_RECEIVED, received, 0);
+        }
+        
+        // Transport and the record/arm CCs are seen before the CC map consumes them
+        recorder_handle_events(midi_batch, received);
+        live_sampler_handle_events(midi_batch, received);
+        midi_clock_handle_events(midi_batch, received);
+        kit_loader_handle_events(midi_batch, received);
+        
+        int count = engine_setup_apply_cc_map(midi_batch, received);
+        count = sequencer_filter_events(midi_batch, count);
+        if (count > 0) {
+            audio_engine_queue_events(midi_batch, count);
+            if (debug_midi) {
+                print_midi_events(midi_batch, count);
+            }
+        }
+    }
+    
+    return NULL;
 }
 
-
 int main(void) {
+    boot_timer_start();
+    
     printf("Raspberry Pi MIDI Sampler - JACK Audio System\n");
     printf("==============================================\n");
     
     // Set up signal handler for graceful shutdown
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, trace_signal_handler);
+    
+    // Load configuration and apply process-wide real-time settings
+    config_load(CONFIG_DEFAULT_FILE);
+    rt_config_t rt_config = rt_setup_get_default_config();
+    rt_setup_load_config(&rt_config);
+    rt_setup_init(&rt_config);
+    trace_init(config_get_bool("SYSTEM", "trace", 1));
+    boot_timer_mark("Config and RT setup");
     
     // Initialize JACK client
     printf("\nInitializing JACK client...\n");
     jack_config_t jack_config = jack_get_default_config();
+    live_sampler_config_t live_config = live_sampler_get_default_config();
+    live_sampler_load_config(&live_config);
+    jack_config.input_channels = live_config.enabled ? live_config.inputs : 0;
     if (jack_client_init(&jack_config) < 0) {
         printf("Failed to initialize JACK client\n");
         printf("Make sure JACK is running: jackd -dalsa -dhw:0 -r48000 -p1024 -n2\n");
         return 1;
     }
+    rt_setup_set_jack_priority(jack_client_get_rt_priority());
+    boot_timer_mark("JACK client");
     
     // Initialize audio engine
     printf("\nInitializing audio engine...\n");
     audio_engine_config_t engine_config = audio_engine_get_default_config();
+    engine_setup_read_config(&engine_config);
     if (audio_engine_init(&engine_config) < 0) {
         printf("Failed to initialize audio engine\n");
         jack_client_cleanup();
@@ -104,6 +173,26 @@ int main(void) {
     // Connect audio engine to JACK
     jack_client_set_process_callback(audio_engine_process, NULL);
     jack_client_set_shutdown_callback(audio_engine_shutdown, NULL);
+    jack_client_set_buffer_size_callback(audio_engine_buffer_size_changed, NULL);
+    jack_client_set_sample_rate_callback(audio_engine_sample_rate_changed, NULL);
+    jack_client_set_xrun_callback(audio_engine_xrun, NULL);
+    jack_client_set_thread_init_callback(rt_setup_audio_thread_init, NULL);
+    engine_setup_apply_effects();
+    engine_setup_load_cc_map();
+    
+    // Output recording ([RECORDER] enabled); the sampler runs without it on failure
+    recorder_config_t recorder_config = recorder_get_default_config();
+    recorder_load_config(&recorder_config);
+    if (recorder_init(&recorder_config, jack_client_get_sample_rate()) < 0) {
+        printf("Warning: Recorder disabled\n");
+    }
+    
+    // Live input sampling ([LIVE_SAMPLING] enabled) into preallocated slots
+    if (live_sampler_init(&live_config, jack_client_get_sample_rate()) < 0) {
+        printf("Warning: Live sampling disabled\n");
+    }
+    
+    boot_timer_mark("Audio engine");
     
     // Initialize sample loader
     printf("\nInitializing sample loader...\n");
@@ -120,6 +209,15 @@ int main(void) {
     // Show loaded sample information
     printf("\nSample information:\n");
     sample_loader_list_samples();
+    engine_setup_load_reverb(samples_path);
+    
+    // Program changes switch kits (subfolders of the samples folder, [KITS] enabled)
+    kit_loader_config_t kit_config = kit_loader_get_default_config();
+    kit_loader_load_config(&kit_config);
+    if (kit_loader_init(&kit_config, samples_path) < 0) {
+        printf("Warning: Kit switching disabled\n");
+    }
+    boot_timer_mark("Sample loading");
     
     // Initialize MIDI system
     printf("\nInitializing MIDI system...\n");
@@ -130,16 +228,20 @@ int main(void) {
         return 1;
     }
     
-    // Register MIDI event callbacks
-    midi_set_note_callback(on_midi_note);
-    midi_set_cc_callback(on_midi_cc);
-    midi_set_pitch_callback(on_midi_pitch);
-    midi_set_program_callback(on_midi_program);
-    midi_set_pressure_callback(on_midi_pressure);
-    midi_set_key_pressure_callback(on_midi_key_pressure);
-    midi_set_start_callback(on_midi_start);
-    midi_set_stop_callback(on_midi_stop);
-    midi_set_continue_callback(on_midi_continue);
+    midi_clock_init(config_get_float("MIDI", "clock_bandwidth_hz", MIDI_CLOCK_DEFAULT_BANDWIDTH));
+    
+    boot_timer_mark("MIDI init");
+    
+    // Step sequencer and arpeggiator ([SEQUENCER] enabled), played by the audio thread
+    sequencer_config_t sequencer_config = sequencer_get_default_config();
+    sequencer_load_config(&sequencer_config);
+    sequencer_init(&sequencer_config);
+    
+    // Every channel plays the loaded sample
+    audio_engine_set_channel_sample(-1, sample_loader_get_first_sample());
+    
+    // debug_mode (or SAMPLER_DEBUG_MIDI=1) prints incoming MIDI events
+    debug_midi = config_get_bool("SYSTEM", "debug_mode", 0) || getenv("SAMPLER_DEBUG_MIDI") != NULL;
     
     // Activate JACK client (start audio processing)
     printf("\nActivating JACK client...\n");
@@ -152,32 +254,72 @@ int main(void) {
         return 1;
     }
     
+    boot_timer_mark("JACK activation");
+    
+    // Start the MIDI thread
+    sem_init(&midi_thread_ready, 0, 0);
+    if (pthread_create(&midi_thread, NULL, midi_thread_func, NULL) != 0) {
+        printf("Failed to start MIDI thread\n");
+        jack_client_deactivate();
+        midi_cleanup();
+        sample_loader_cleanup();
+        audio_engine_cleanup();
+        jack_client_cleanup();
+        return 1;
+    }
+    sem_wait(&midi_thread_ready);
+    
+    // Meters and counters for local dashboards ([SYSTEM] telemetry_socket, empty = off)
+    const char *telemetry_socket = config_get_string("SYSTEM", "telemetry_socket", TELEMETRY_DEFAULT_SOCKET);
+    if (telemetry_socket[0] != '\0' && telemetry_start(telemetry_socket) < 0) {
+        printf("Warning: Telemetry disabled\n");
+    }
+    
     printf("\nSystem ready!\n");
-    printf("Connected to MIDI: %s\n", midi_get_connected_device_name());
+    if (midi_get_device_count() > 0) {
+        printf("Connected to MIDI: %s", midi_get_connected_device_name());
+        if (midi_get_device_count() > 1) {
+            printf(" (+%d more)", midi_get_device_count() - 1);
+        }
+        printf("\n");
+    } else {
+        printf("Connected to MIDI: none (waiting for a device to be plugged in)\n");
+    }
     printf("Loaded sample: %s\n", sample_loader_get_first_sample_name());
     printf("JACK client: %s (%d Hz, %d frames)\n", 
            jack_client_get_name(), jack_client_get_sample_rate(), jack_client_get_buffer_size());
     printf("\nJACK connections:\n");
     jack_client_print_connections();
+    printf("\n");
+    rt_setup_report();
+    boot_timer_report();
     printf("\nPress keys on MIDI device to trigger samples (Ctrl+C to stop)...\n");
     printf("================================================================\n");
     
-    // Main real-time loop
+    // MIDI and audio run on their own threads; wait for a shutdown signal
     while (running) {
-        // Process MIDI events (non-blocking)
-        midi_process_events();
+        usleep(100000);
         
-        // Sleep for 1ms to maintain ~1000Hz polling rate
-        // This gives us sub-5ms latency while keeping CPU usage reasonable
-        usleep(1000);
+        if (dump_trace) {
+            dump_trace = 0;
+            trace_dump(config_get_string("SYSTEM", "trace_file", TRACE_DEFAULT_FILE));
+        }
     }
     
-    // Cleanup
+    // Cleanup (stop audio processing first so no voice still reads sample data)
     printf("\nShutting down systems...\n");
+    telemetry_stop();
+    pthread_join(midi_thread, NULL);
+    sem_destroy(&midi_thread_ready);
+    jack_client_deactivate();
+    recorder_cleanup();
+    live_sampler_cleanup();
     midi_cleanup();
+    kit_loader_cleanup();
     sample_loader_cleanup();
     audio_engine_cleanup();
     jack_client_cleanup();
+    config_cleanup();
     printf("Sampler stopped.\n");
     
     return 0;
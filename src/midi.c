@@ -2,14 +2,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <poll.h>
+#include <errno.h>
 #include <alsa/asoundlib.h>
 #include "midi.h"
 
+// Connected source port (one slot per device port)
+typedef struct {
+    int client;
+    int port;
+    int connected;      // 1 if slot is in use
+    char name[256];
+} midi_device_t;
+
 // Internal state
 static snd_seq_t *seq_handle = NULL;
 static int midi_port = -1;
-static char connected_device_name[256] = "";
-static int connected_device_client = -1;
+static int own_client = -1;
+static midi_device_t devices[MIDI_MAX_DEVICES];
+static int device_count = 0;
+
+// Timestamping queue (-1 if unavailable, then events are stamped on read)
+static int seq_queue = -1;
+static uint32_t queue_start_us = 0;
 
 // Callback pointers
 static midi_note_callback_t note_callback = NULL;
@@ -21,10 +38,11 @@ static midi_key_pressure_callback_t key_pressure_callback = NULL;
 static midi_transport_callback_t start_callback = NULL;
 static midi_transport_callback_t stop_callback = NULL;
 static midi_transport_callback_t continue_callback = NULL;
+static midi_clock_callback_t clock_callback = NULL;
 
 // Internal function prototypes
 static void verify_connections(void);
-static int find_first_midi_device(void);
+static int connect_all_midi_devices(void);
 
 // Callback registration functions
 void midi_set_note_callback(midi_note_callback_t callback) {
@@ -63,13 +81,107 @@ void midi_set_continue_callback(midi_transport_callback_t callback) {
     continue_callback = callback;
 }
 
-// Utility functions
+void midi_set_clock_callback(midi_clock_callback_t callback) {
+    clock_callback = callback;
+}
+
+// Device queries
+int midi_get_device_count(void) {
+    return device_count;
+}
+
+const char* midi_get_device_name(int source) {
+    if (source < 0 || source >= MIDI_MAX_DEVICES || !devices[source].connected) {
+        return "";
+    }
+    return devices[source].name;
+}
+
+// Utility functions (first connected device)
 const char* midi_get_connected_device_name(void) {
-    return connected_device_name;
+    for (int i = 0; i < MIDI_MAX_DEVICES; i++) {
+        if (devices[i].connected) {
+            return devices[i].name;
+        }
+    }
+    return "";
 }
 
 int midi_get_connected_device_id(void) {
-    return connected_device_client;
+    for (int i = 0; i < MIDI_MAX_DEVICES; i++) {
+        if (devices[i].connected) {
+            return devices[i].client;
+        }
+    }
+    return -1;
+}
+
+// Find the device slot for a source address (-1 if not tracked)
+static int find_device_slot(int client, int port) {
+    for (int i = 0; i < MIDI_MAX_DEVICES; i++) {
+        if (devices[i].connected && devices[i].client == client && devices[i].port == port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Check whether a port is a MIDI source we should listen to
+static int is_suitable_port(int client, unsigned int capability) {
+    // Skip system, MIDI Through and OSS clients, and ourselves
+    if (client == SND_SEQ_CLIENT_SYSTEM || client == 14 || client == 15 || client == own_client) {
+        return 0;
+    }
+    
+    // We receive from the device, so it must be readable and allow subscriptions
+    return (capability & SND_SEQ_PORT_CAP_READ) &&
+           (capability & SND_SEQ_PORT_CAP_SUBS_READ) &&
+           !(capability & SND_SEQ_PORT_CAP_NO_EXPORT);
+}
+
+// Subscribe to a device port and store it in a free slot
+static int connect_device(int client, int port, const char *client_name, const char *port_name) {
+    if (find_device_slot(client, port) >= 0) {
+        return 0; // Already connected
+    }
+    
+    int slot = -1;
+    for (int i = 0; i < MIDI_MAX_DEVICES; i++) {
+        if (!devices[i].connected) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        printf("Warning: MIDI device limit reached (%d), ignoring %s - %s\n",
+               MIDI_MAX_DEVICES, client_name, port_name);
+        return -1;
+    }
+    
+    int err = snd_seq_connect_from(seq_handle, midi_port, client, port);
+    if (err < 0) {
+        printf("Failed to connect to %s - %s (%d:%d): %s\n",
+               client_name, port_name, client, port, snd_strerror(err));
+        return -1;
+    }
+    
+    devices[slot].client = client;
+    devices[slot].port = port;
+    devices[slot].connected = 1;
+    snprintf(devices[slot].name, sizeof(devices[slot].name), "%s - %s", client_name, port_name);
+    device_count++;
+    
+    printf("Connected to: %s (Client: %d, Port: %d, Source: %d)\n",
+           devices[slot].name, client, port, slot);
+    return 0;
+}
+
+// Release a device slot (the subscription is already gone on unplug)
+static void release_device_slot(int slot) {
+    printf("MIDI device disconnected: %s (Source: %d)\n", devices[slot].name, slot);
+    devices[slot].connected = 0;
+    devices[slot].name[0] = '\0';
+    device_count--;
 }
 
 // Connection verification
@@ -102,12 +214,11 @@ static void verify_connections(void) {
     }
 }
 
-// Find and connect to first MIDI device
-static int find_first_midi_device(void) {
+// Find and connect to all MIDI devices present at startup
+static int connect_all_midi_devices(void) {
     snd_seq_client_info_t *cinfo;
     snd_seq_port_info_t *pinfo;
     int client;
-    int devices_found = 0;
 
     snd_seq_client_info_malloc(&cinfo);
     snd_seq_port_info_malloc(&pinfo);
@@ -115,7 +226,7 @@ static int find_first_midi_device(void) {
     printf("\nScanning for MIDI devices...\n");
     printf("============================\n");
 
-    // Iterate through all clients to find first MIDI device
+    // Iterate through all clients and connect every suitable port
     snd_seq_client_info_set_client(cinfo, -1);
     while (snd_seq_query_next_client(seq_handle, cinfo) >= 0) {
         client = snd_seq_client_info_get_client(cinfo);
@@ -124,7 +235,7 @@ static int find_first_midi_device(void) {
         printf("Client %d: %s", client, client_name);
         
         // Skip system clients but show them for debugging
-        if (client == 0 || client == 14 || client == 15) {
+        if (client == 0 || client == 14 || client == 15 || client == own_client) {
             printf(" [SYSTEM - SKIPPED]\n");
             continue;
         }
@@ -149,43 +260,12 @@ static int find_first_midi_device(void) {
             if (capability & SND_SEQ_PORT_CAP_SUBS_READ) printf("SUBS_READ ");
             if (capability & SND_SEQ_PORT_CAP_SUBS_WRITE) printf("SUBS_WRITE ");
             if (capability & SND_SEQ_PORT_CAP_NO_EXPORT) printf("NO_EXPORT ");
-            printf("]");
+            printf("]\n");
             
-            // Look for writable ports (MIDI input from our perspective)
-            if ((capability & SND_SEQ_PORT_CAP_WRITE) && 
-                !(capability & SND_SEQ_PORT_CAP_NO_EXPORT)) {
-                
-                printf(" <- SUITABLE FOR CONNECTION");
-                
-                if (devices_found == 0) {
-                    printf("\n  -> Attempting connection to this device...");
-                    
-                    // Connect to this port
-                    int connect_result = snd_seq_connect_from(seq_handle, midi_port, client, port);
-                    if (connect_result >= 0) {
-                        printf(" SUCCESS!\n");
-                        printf("\nConnected to: %s - %s (Client: %d, Port: %d)\n", 
-                               client_name, port_name, client, port);
-                        
-                        // Store connection info
-                        snprintf(connected_device_name, sizeof(connected_device_name), 
-                                "%s - %s", client_name, port_name);
-                        connected_device_client = client;
-                        
-                        // Verify connection
-                        printf("\nVerifying connection...\n");
-                        verify_connections();
-                        
-                        snd_seq_client_info_free(cinfo);
-                        snd_seq_port_info_free(pinfo);
-                        return 0;
-                    } else {
-                        printf(" FAILED: %s\n", snd_strerror(connect_result));
-                    }
-                    devices_found++;
-                }
+            if (is_suitable_port(client, capability)) {
+                printf("  -> ");
+                connect_device(client, port, client_name, port_name);
             }
-            printf("\n");
             port_count++;
         }
         
@@ -198,21 +278,121 @@ static int find_first_midi_device(void) {
     snd_seq_client_info_free(cinfo);
     snd_seq_port_info_free(pinfo);
     
-    if (devices_found == 0) {
-        printf("No suitable MIDI devices found!\n");
-        printf("Make sure your USB MIDI device is connected and recognized by the system.\n");
+    if (device_count == 0) {
+        printf("No suitable MIDI devices found yet.\n");
+        printf("Devices will be connected automatically when plugged in.\n");
         printf("Try running './list_midi' to see available devices.\n");
+    } else {
+        printf("Verifying connections...\n");
+        verify_connections();
+    }
+    
+    return device_count;
+}
+
+// Hotplug: a new port appeared (announced by the system client)
+static void handle_port_start(int client, int port) {
+    snd_seq_client_info_t *cinfo;
+    snd_seq_port_info_t *pinfo;
+    
+    snd_seq_client_info_malloc(&cinfo);
+    snd_seq_port_info_malloc(&pinfo);
+    
+    if (snd_seq_get_any_port_info(seq_handle, client, port, pinfo) >= 0 &&
+        is_suitable_port(client, snd_seq_port_info_get_capability(pinfo))) {
+        const char *client_name = "Unknown";
+        if (snd_seq_get_any_client_info(seq_handle, client, cinfo) >= 0) {
+            client_name = snd_seq_client_info_get_name(cinfo);
+        }
+        printf("MIDI device plugged in: ");
+        connect_device(client, port, client_name, snd_seq_port_info_get_name(pinfo));
+    }
+    
+    snd_seq_client_info_free(cinfo);
+    snd_seq_port_info_free(pinfo);
+}
+
+// Hotplug: a port went away
+static void handle_port_exit(int client, int port) {
+    int slot = find_device_slot(client, port);
+    if (slot >= 0) {
+        release_device_slot(slot);
+    }
+}
+
+// Hotplug: a whole client went away (e.g. USB device unplugged)
+static void handle_client_exit(int client) {
+    for (int i = 0; i < MIDI_MAX_DEVICES; i++) {
+        if (devices[i].connected && devices[i].client == client) {
+            release_device_slot(i);
+        }
+    }
+}
+
+// Someone removed our subscription to a device (e.g. 'aconnect -d')
+static void handle_unsubscribed(const snd_seq_connect_t *connect) {
+    if (connect->dest.client != own_client || connect->dest.port != midi_port) {
+        return;
+    }
+    int slot = find_device_slot(connect->sender.client, connect->sender.port);
+    if (slot >= 0) {
+        release_device_slot(slot);
+    }
+}
+
+// Current CLOCK_MONOTONIC time in microseconds (wraps every ~71 minutes)
+static uint32_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+// Create our input port, timestamped by the kernel on arrival if possible
+static int create_input_port(void) {
+    snd_seq_port_info_t *pinfo;
+    int port;
+    
+    seq_queue = snd_seq_alloc_named_queue(seq_handle, "RPi Sampler");
+    
+    snd_seq_port_info_malloc(&pinfo);
+    snd_seq_port_info_set_name(pinfo, "Input");
+    snd_seq_port_info_set_capability(pinfo, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE);
+    snd_seq_port_info_set_type(pinfo, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (seq_queue >= 0) {
+        snd_seq_port_info_set_timestamping(pinfo, 1);
+        snd_seq_port_info_set_timestamp_real(pinfo, 1);
+        snd_seq_port_info_set_timestamp_queue(pinfo, seq_queue);
+    }
+    
+    if (snd_seq_create_port(seq_handle, pinfo) < 0) {
+        snd_seq_port_info_free(pinfo);
+        return -1;
+    }
+    port = snd_seq_port_info_get_port(pinfo);
+    snd_seq_port_info_free(pinfo);
+    
+    // Start the queue; event times are then relative to queue_start_us
+    if (seq_queue >= 0) {
+        queue_start_us = monotonic_us();
+        if (snd_seq_start_queue(seq_handle, seq_queue, NULL) < 0 ||
+            snd_seq_drain_output(seq_handle) < 0) {
+            printf("Warning: Cannot start MIDI timestamp queue, using read time\n");
+            snd_seq_free_queue(seq_handle, seq_queue);
+            seq_queue = -1;
+        }
+    } else {
+        printf("Warning: Cannot allocate MIDI timestamp queue, using read time\n");
     }
     
-    return -1; // No MIDI device found
+    return port;
 }
 
 // Initialize MIDI system
 int midi_init(void) {
     int err;
     
-    // Open ALSA sequencer
-    err = snd_seq_open(&seq_handle, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK);
+    // Open ALSA sequencer (output is needed to start the timestamp queue)
+    err = snd_seq_open(&seq_handle, "default", SND_SEQ_OPEN_DUPLEX, SND_SEQ_NONBLOCK);
     if (err < 0) {
         printf("Error opening ALSA sequencer: %s\n", snd_strerror(err));
         return -1;
@@ -222,157 +402,326 @@ int midi_init(void) {
     snd_seq_set_client_name(seq_handle, "RPi Sampler");
 
     // Create input port
-    midi_port = snd_seq_create_simple_port(seq_handle, "Input",
-                                          SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
-                                          SND_SEQ_PORT_TYPE_MIDI_GENERIC);
+    midi_port = create_input_port();
     if (midi_port < 0) {
         printf("Error creating MIDI port: %s\n", snd_strerror(midi_port));
         snd_seq_close(seq_handle);
+        seq_handle = NULL;
         return -1;
     }
 
+    own_client = snd_seq_client_id(seq_handle);
+    memset(devices, 0, sizeof(devices));
+    device_count = 0;
+    
     printf("MIDI system initialized. Port ID: %d\n", midi_port);
     
-    // Try to connect to first available MIDI device
-    if (find_first_midi_device() < 0) {
-        printf("No MIDI devices found. Connect a USB MIDI device and restart.\n");
-        return -1;
+    // Subscribe to the system announce port so we hear about hotplug events
+    err = snd_seq_connect_from(seq_handle, midi_port,
+                               SND_SEQ_CLIENT_SYSTEM, SND_SEQ_PORT_SYSTEM_ANNOUNCE);
+    if (err < 0) {
+        printf("Warning: Cannot subscribe to ALSA announce port: %s\n", snd_strerror(err));
+        printf("MIDI hotplug disabled, devices are only detected at startup\n");
     }
+    
+    // Connect to all MIDI devices present now; more may arrive later
+    connect_all_midi_devices();
 
     return 0;
 }
 
-// Process MIDI events
-int midi_process_events(void) {
+// Arrival time of an event in monotonic microseconds
+static uint32_t event_timestamp(const snd_seq_event_t *ev, uint32_t read_time) {
+    if (seq_queue >= 0 && (ev->flags & SND_SEQ_TIME_STAMP_MASK) == SND_SEQ_TIME_STAMP_REAL) {
+        return queue_start_us + ev->time.time.tv_sec * 1000000U + ev->time.time.tv_nsec / 1000U;
+    }
+    return read_time;
+}
+
+// Decode one ALSA event into a compact event
+// Returns 1 if an event was produced, 0 if it was consumed internally or ignored
+static int decode_event(const snd_seq_event_t *ev, midi_event_t *out, uint32_t read_time) {
+    switch (ev->type) {
+        case SND_SEQ_EVENT_NOTEON:
+            // Note on with velocity 0 is a note off
+            out->type = ev->data.note.velocity > 0 ? MIDI_EVENT_NOTE_ON : MIDI_EVENT_NOTE_OFF;
+            out->channel = ev->data.note.channel;
+            out->data1 = ev->data.note.note;
+            out->data2 = ev->data.note.velocity;
+            break;
+            
+        case SND_SEQ_EVENT_NOTEOFF:
+            out->type = MIDI_EVENT_NOTE_OFF;
+            out->channel = ev->data.note.channel;
+            out->data1 = ev->data.note.note;
+            out->data2 = 0;
+            break;
+            
+        case SND_SEQ_EVENT_KEYPRESS:
+            out->type = MIDI_EVENT_KEY_PRESSURE;
+            out->channel = ev->data.note.channel;
+            out->data1 = ev->data.note.note;
+            out->data2 = ev->data.note.velocity;
+            break;
+            
+        case SND_SEQ_EVENT_CONTROLLER:
+            out->type = MIDI_EVENT_CC;
+            out->channel = ev->data.control.channel;
+            out->data1 = ev->data.control.param & 0x7F;
+            out->data2 = ev->data.control.value & 0x7F;
+            break;
+            
+        case SND_SEQ_EVENT_PITCHBEND: {
+            // ALSA gives -8192..8191, store as raw 14-bit LSB/MSB
+            int raw = ev->data.control.value + 8192;
+            out->type = MIDI_EVENT_PITCH;
+            out->channel = ev->data.control.channel;
+            out->data1 = raw & 0x7F;
+            out->data2 = (raw >> 7) & 0x7F;
+            break;
+        }
+            
+        case SND_SEQ_EVENT_PGMCHANGE:
+            out->type = MIDI_EVENT_PROGRAM;
+            out->channel = ev->data.control.channel;
+            out->data1 = ev->data.control.value & 0x7F;
+            out->data2 = 0;
+            break;
+            
+        case SND_SEQ_EVENT_CHANPRESS:
+            out->type = MIDI_EVENT_PRESSURE;
+            out->channel = ev->data.control.channel;
+            out->data1 = ev->data.control.value & 0x7F;
+            out->data2 = 0;
+            break;
+            
+        case SND_SEQ_EVENT_START:
+        case SND_SEQ_EVENT_STOP:
+        case SND_SEQ_EVENT_CONTINUE:
+            out->type = ev->type == SND_SEQ_EVENT_START ? MIDI_EVENT_START :
+                        ev->type == SND_SEQ_EVENT_STOP ? MIDI_EVENT_STOP : MIDI_EVENT_CONTINUE;
+            out->channel = 0;
+            out->data1 = 0;
+            out->data2 = 0;
+            break;
+            
+        case SND_SEQ_EVENT_CLOCK:
+            out->type = MIDI_EVENT_CLOCK;
+            out->channel = 0;
+            out->data1 = 0;
+            out->data2 = 0;
+            break;
+            
+        // Hotplug notifications from the system announce port
+        case SND_SEQ_EVENT_PORT_START:
+            handle_port_start(ev->data.addr.client, ev->data.addr.port);
+            return 0;
+            
+        case SND_SEQ_EVENT_PORT_EXIT:
+            handle_port_exit(ev->data.addr.client, ev->data.addr.port);
+            return 0;
+            
+        case SND_SEQ_EVENT_CLIENT_EXIT:
+            handle_client_exit(ev->data.addr.client);
+            return 0;
+            
+        case SND_SEQ_EVENT_PORT_UNSUBSCRIBED:
+            handle_unsubscribed(&ev->data.connect);
+            return 0;
+            
+        // Ignore active sensing and unknown events
+        default:
+            return 0;
+    }
+    
+    out->source = (int8_t)find_device_slot(ev->source.client, ev->source.port);
+    out->timestamp = event_timestamp(ev, read_time);
+    return 1;
+}
+
+// Decode all pending MIDI events into the caller's array (non-blocking)
+int midi_read_events(midi_event_t *events, int max_events) {
     snd_seq_event_t *ev;
-    int err;
-    int events_processed = 0;
+    int count = 0;
+    int err = 0;
     
-    // Process MIDI events (non-blocking)
-    while ((err = snd_seq_event_input(seq_handle, &ev)) >= 0) {
-        events_processed++;
-        
-        switch (ev->type) {
-            case SND_SEQ_EVENT_NOTEON:
-                if (note_callback) {
-                    midi_note_event_t event;
-                    event.note = ev->data.note.note;
-                    event.velocity = ev->data.note.velocity;
-                    event.channel = ev->data.note.channel;
-                    event.is_note_on = (ev->data.note.velocity > 0) ? 1 : 0;
-                    note_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_NOTEOFF:
-                if (note_callback) {
-                    midi_note_event_t event;
-                    event.note = ev->data.note.note;
-                    event.velocity = 0;
-                    event.channel = ev->data.note.channel;
-                    event.is_note_on = 0;
-                    note_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_CONTROLLER:
-                if (cc_callback) {
-                    midi_cc_event_t event;
-                    event.controller = ev->data.control.param;
-                    event.value = ev->data.control.value;
-                    event.channel = ev->data.control.channel;
-                    cc_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_PITCHBEND:
-                if (pitch_callback) {
-                    midi_pitch_event_t event;
-                    event.value = ev->data.control.value;
-                    event.channel = ev->data.control.channel;
-                    pitch_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_PGMCHANGE:
-                if (program_callback) {
-                    midi_program_event_t event;
-                    event.program = ev->data.control.value;
-                    event.channel = ev->data.control.channel;
-                    program_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_CHANPRESS:
-                if (pressure_callback) {
-                    midi_pressure_event_t event;
-                    event.pressure = ev->data.control.value;
-                    event.channel = ev->data.control.channel;
-                    pressure_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_KEYPRESS:
-                if (key_pressure_callback) {
-                    midi_key_pressure_event_t event;
-                    event.note = ev->data.note.note;
-                    event.pressure = ev->data.note.velocity;
-                    event.channel = ev->data.note.channel;
-                    key_pressure_callback(&event);
-                }
-                break;
-                
-            case SND_SEQ_EVENT_START:
-                if (start_callback) {
-                    start_callback();
-                }
-                break;
-                
-            case SND_SEQ_EVENT_STOP:
-                if (stop_callback) {
-                    stop_callback();
-                }
-                break;
-                
-            case SND_SEQ_EVENT_CONTINUE:
-                if (continue_callback) {
-                    continue_callback();
-                }
-                break;
-                
-            // Ignore clock and active sensing to keep output clean
-            case SND_SEQ_EVENT_CLOCK:
-            case SND_SEQ_EVENT_SENSING:
-                break;
-                
-            default:
-                // Ignore unknown events
-                break;
-        }
-        
+    if (!seq_handle) {
+        return -1;
+    }
+    
+    uint32_t read_time = monotonic_us();
+    
+    // Stop when the array is full; remaining events stay queued in ALSA
+    while (count < max_events && (err = snd_seq_event_input(seq_handle, &ev)) >= 0) {
+        count += decode_event(ev, &events[count], read_time);
         snd_seq_free_event(ev);
     }
     
     // Handle error cases (but -EAGAIN is normal for non-blocking)
     if (err < 0 && err != -EAGAIN) {
         printf("MIDI input error: %s\n", snd_strerror(err));
+        if (count == 0) {
+            return -1;
+        }
+    }
+    
+    return count;
+}
+
+// Block until MIDI input is pending (no fixed polling interval)
+int midi_wait_events(int timeout_ms) {
+    struct pollfd fds[4];
+    
+    if (!seq_handle) {
         return -1;
     }
     
-    return events_processed;
+    // Events may already be buffered in user space
+    if (snd_seq_event_input_pending(seq_handle, 0) > 0) {
+        return 1;
+    }
+    
+    int count = snd_seq_poll_descriptors(seq_handle, fds, 4, POLLIN);
+    int result = poll(fds, count, timeout_ms);
+    if (result < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    
+    return result > 0 ? 1 : 0;
+}
+
+// Process MIDI events through the per-type callbacks
+int midi_process_events(void) {
+    midi_event_t events[MIDI_BATCH_SIZE];
+    int total = 0;
+    int count;
+    
+    do {
+        count = midi_read_events(events, MIDI_BATCH_SIZE);
+        if (count < 0) {
+            return -1;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            const midi_event_t *e = &events[i];
+            
+            switch (e->type) {
+                case MIDI_EVENT_NOTE_ON:
+                case MIDI_EVENT_NOTE_OFF:
+                    if (note_callback) {
+                        midi_note_event_t event;
+                        event.note = e->data1;
+                        event.velocity = e->data2;
+                        event.channel = e->channel;
+                        event.is_note_on = (e->type == MIDI_EVENT_NOTE_ON);
+                        event.source = e->source;
+                        note_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_CC:
+                    if (cc_callback) {
+                        midi_cc_event_t event;
+                        event.controller = e->data1;
+                        event.value = e->data2;
+                        event.channel = e->channel;
+                        event.source = e->source;
+                        cc_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_PITCH:
+                    if (pitch_callback) {
+                        midi_pitch_event_t event;
+                        event.value = midi_event_pitch_value(e);
+                        event.channel = e->channel;
+                        event.source = e->source;
+                        pitch_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_PROGRAM:
+                    if (program_callback) {
+                        midi_program_event_t event;
+                        event.program = e->data1;
+                        event.channel = e->channel;
+                        event.source = e->source;
+                        program_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_PRESSURE:
+                    if (pressure_callback) {
+                        midi_pressure_event_t event;
+                        event.pressure = e->data1;
+                        event.channel = e->channel;
+                        event.source = e->source;
+                        pressure_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_KEY_PRESSURE:
+                    if (key_pressure_callback) {
+                        midi_key_pressure_event_t event;
+                        event.note = e->data1;
+                        event.pressure = e->data2;
+                        event.channel = e->channel;
+                        event.source = e->source;
+                        key_pressure_callback(&event);
+                    }
+                    break;
+                    
+                case MIDI_EVENT_START:
+                    if (start_callback) {
+                        start_callback();
+                    }
+                    break;
+                    
+                case MIDI_EVENT_STOP:
+                    if (stop_callback) {
+                        stop_callback();
+                    }
+                    break;
+                    
+                case MIDI_EVENT_CONTINUE:
+                    if (continue_callback) {
+                        continue_callback();
+                    }
+                    break;
+                    
+                case MIDI_EVENT_CLOCK:
+                    if (clock_callback) {
+                        clock_callback(e->timestamp);
+                    }
+                    break;
+                    
+                default:
+                    break;
+            }
+        }
+        
+        total += count;
+    } while (count == MIDI_BATCH_SIZE);
+    
+    return total;
 }
 
 // Cleanup MIDI system
 void midi_cleanup(void) {
     if (seq_handle) {
+        if (seq_queue >= 0) {
+            snd_seq_free_queue(seq_handle, seq_queue);
+        }
         snd_seq_close(seq_handle);
         seq_handle = NULL;
     }
     
     // Clear connection info
-    connected_device_name[0] = '\0';
-    connected_device_client = -1;
+    memset(devices, 0, sizeof(devices));
+    device_count = 0;
+    own_client = -1;
     midi_port = -1;
+    seq_queue = -1;
     
     // Clear callbacks
     note_callback = NULL;
@@ -384,4 +733,5 @@ void midi_cleanup(void) {
     start_callback = NULL;
     stop_callback = NULL;
     continue_callback = NULL;
-}
\ No newline at end of file
+    clock_callback = NULL;
+}
@@ -1,41 +1,85 @@
 #ifndef MIDI_H
 #define MIDI_H
 
+#include <stdint.h>
+
+// Maximum number of MIDI source ports connected at the same time
+#define MIDI_MAX_DEVICES 16
+
 // MIDI event structures
+// 'source' is the device slot the event came from (-1 if not a tracked device)
 typedef struct {
     int note;
     int velocity;
     int channel;
     int is_note_on;  // 1 for note on, 0 for note off
+    int source;
 } midi_note_event_t;
 
 typedef struct {
     int controller;
     int value;
     int channel;
+    int source;
 } midi_cc_event_t;
 
 typedef struct {
     int value;
     int channel;
+    int source;
 } midi_pitch_event_t;
 
 typedef struct {
     int program;
     int channel;
+    int source;
 } midi_program_event_t;
 
 typedef struct {
     int pressure;
     int channel;
+    int source;
 } midi_pressure_event_t;
 
 typedef struct {
     int note;
     int pressure;
     int channel;
+    int source;
 } midi_key_pressure_event_t;
 
+// Compact tagged event for batched dispatch
+typedef enum {
+    MIDI_EVENT_NOTE_ON = 1,
+    MIDI_EVENT_NOTE_OFF,
+    MIDI_EVENT_CC,
+    MIDI_EVENT_PITCH,
+    MIDI_EVENT_PROGRAM,
+    MIDI_EVENT_PRESSURE,
+    MIDI_EVENT_KEY_PRESSURE,
+    MIDI_EVENT_START,
+    MIDI_EVENT_STOP,
+    MIDI_EVENT_CONTINUE,
+    MIDI_EVENT_CLOCK            // 24 per quarter note; only the timestamp matters
+} midi_event_type_t;
+
+typedef struct {
+    uint32_t timestamp;     // Arrival time in microseconds (CLOCK_MONOTONIC, wraps)
+    uint8_t type;           // midi_event_type_t
+    uint8_t channel;        // 0-15
+    uint8_t data1;          // Note, controller, program, pressure or pitch LSB
+    uint8_t data2;          // Velocity, value, key pressure or pitch MSB
+    int8_t source;          // Device slot (-1 if unknown)
+} midi_event_t;
+
+// Suggested batch array size for midi_read_events
+#define MIDI_BATCH_SIZE 256
+
+// Pitch bend value (-8192..8191) of a MIDI_EVENT_PITCH event
+static inline int midi_event_pitch_value(const midi_event_t *event) {
+    return ((event->data2 << 7) | event->data1) - 8192;
+}
+
 // Callback function types
 typedef void (*midi_note_callback_t)(midi_note_event_t *event);
 typedef void (*midi_cc_callback_t)(midi_cc_event_t *event);
@@ -44,12 +88,21 @@ typedef void (*midi_program_callback_t)(midi_program_event_t *event);
 typedef void (*midi_pressure_callback_t)(midi_pressure_event_t *event);
 typedef void (*midi_key_pressure_callback_t)(midi_key_pressure_event_t *event);
 typedef void (*midi_transport_callback_t)(void);
+typedef void (*midi_clock_callback_t)(uint32_t timestamp);
 
 // MIDI system functions
 int midi_init(void);
 void midi_cleanup(void);
 int midi_process_events(void);
 
+// Batched dispatch: decode everything pending into 'events' (up to max_events)
+// Returns number of events decoded, 0 if none pending, -1 on error
+int midi_read_events(midi_event_t *events, int max_events);
+
+// Block until MIDI input is pending or timeout_ms expires
+// Returns 1 if input is pending, 0 on timeout, -1 on error
+int midi_wait_events(int timeout_ms);
+
 // Callback registration functions
 void midi_set_note_callback(midi_note_callback_t callback);
 void midi_set_cc_callback(midi_cc_callback_t callback);
@@ -60,6 +113,11 @@ void midi_set_key_pressure_callback(midi_key_pressure_callback_t callback);
 void midi_set_start_callback(midi_transport_callback_t callback);
 void midi_set_stop_callback(midi_transport_callback_t callback);
 void midi_set_continue_callback(midi_transport_callback_t callback);
+void midi_set_clock_callback(midi_clock_callback_t callback);
+
+// Device queries (devices are connected/disconnected automatically on hotplug)
+int midi_get_device_count(void);
+const char* midi_get_device_name(int source);
 
 // Utility functions
 const char* midi_get_connected_device_name(void);
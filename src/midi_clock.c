@@ -0,0 +1,191 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "midi_clock.h"
+
+// Loop state (MIDI thread only); times are unwrapped microseconds since the loop started
+typedef struct {
+    int ticks;                  // Ticks since the loop (re)started
+    uint32_t last_arrival;      // Timestamp of the last tick as received
+    double arrival;             // Arrival time of the last tick
+    double tick_time;           // Filtered time of the last tick
+    double next_time;           // Predicted time of the next tick
+    double period;              // Filtered tick period
+} clock_loop_t;
+
+static clock_loop_t loop;
+static float loop_bandwidth = MIDI_CLOCK_DEFAULT_BANDWIDTH;
+static int transport_running = 0;
+static long song_tick = -1;     // Ticks since Start (-1 = the next tick is the first beat)
+static int reported_lock = 0;
+
+// Snapshot for readers; they give up while published_seq is odd or changes
+typedef struct {
+    int running;
+    int locked;
+    uint32_t tick_time;         // Filtered time of the last tick (monotonic microseconds, wraps)
+    long song_tick;
+    double period;              // Microseconds per tick (0 = no clock yet)
+} clock_snapshot_t;
+
+static clock_snapshot_t published;
+static unsigned int published_seq = 0;
+
+// Same clock as the MIDI event timestamps
+static uint32_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+// Restart the loop from a single tick
+static void loop_reset(uint32_t timestamp) {
+    memset(&loop, 0, sizeof(loop));
+    loop.ticks = 1;
+    loop.last_arrival = timestamp;
+}
+
+// Seed the loop from the interval that ended with this tick
+static void loop_seed(double interval) {
+    loop.period = interval;
+    loop.tick_time = loop.arrival;
+    loop.next_time = loop.arrival + interval;
+    loop.ticks = 2;
+}
+
+// Advance the loop by one clock tick
+static void clock_tick(uint32_t timestamp) {
+    uint32_t gap = timestamp - loop.last_arrival;
+    if (loop.ticks == 0 || gap > MIDI_CLOCK_TIMEOUT_MS * 1000U) {
+        loop_reset(timestamp);
+        return;
+    }
+    loop.last_arrival = timestamp;
+    loop.arrival += gap;
+    
+    if (loop.ticks == 1) {
+        loop_seed(gap);
+        return;
+    }
+    
+    // A whole period off the prediction is a tempo jump, not jitter
+    double error = loop.arrival - loop.next_time;
+    if (fabs(error) > loop.period) {
+        loop_seed(gap);
+        return;
+    }
+    
+    // Second-order loop (damping 0.707); coefficients follow the tick rate
+    double omega = 2.0 * M_PI * loop_bandwidth * loop.period * 1e-6;
+    loop.tick_time = loop.next_time;
+    loop.next_time += M_SQRT2 * omega * error + loop.period;
+    loop.period += omega * omega * error;
+    loop.ticks++;
+}
+
+static void publish(void) {
+    unsigned int seq = published_seq;
+    __atomic_store_n(&published_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    published.running = transport_running;
+    published.locked = loop.ticks >= MIDI_CLOCK_PPQN;
+    published.tick_time = loop.last_arrival + (uint32_t)(int32_t)lround(loop.tick_time - loop.arrival);
+    published.song_tick = song_tick;
+    published.period = loop.ticks >= 2 ? loop.period : 0.0;
+    
+    __atomic_store_n(&published_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Set the loop bandwidth and forget any previous clock
+void midi_clock_init(float bandwidth_hz) {
+    loop_bandwidth = bandwidth_hz > 0.0f ? bandwidth_hz : MIDI_CLOCK_DEFAULT_BANDWIDTH;
+    memset(&loop, 0, sizeof(loop));
+    transport_running = 0;
+    song_tick = -1;
+    reported_lock = 0;
+    publish();
+}
+
+// Feed a batch of events to the follower, publishing once if anything changed
+void midi_clock_handle_events(const midi_event_t *events, int count) {
+    int changed = 0;
+    
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        
+        switch (e->type) {
+            case MIDI_EVENT_CLOCK:
+                clock_tick(e->timestamp);
+                if (transport_running) {
+                    song_tick++;
+                }
+                changed = 1;
+                break;
+            
+            // The first tick after Start is the downbeat; Continue resumes where Stop left off
+            case MIDI_EVENT_START:
+                transport_running = 1;
+                song_tick = -1;
+                changed = 1;
+                break;
+            
+            case MIDI_EVENT_CONTINUE:
+                transport_running = 1;
+                changed = 1;
+                break;
+            
+            case MIDI_EVENT_STOP:
+                transport_running = 0;
+                changed = 1;
+                break;
+            
+            default:
+                break;
+        }
+    }
+    
+    if (!changed) {
+        return;
+    }
+    publish();
+    
+    int locked = loop.ticks >= MIDI_CLOCK_PPQN;
+    if (locked && !reported_lock) {
+        printf("MIDI clock: locked at %.1f BPM\n", 60e6 / (loop.period * MIDI_CLOCK_PPQN));
+    }
+    reported_lock = locked;
+}
+
+// Interpolate the beat position from the last filtered tick
+int midi_clock_read(midi_clock_state_t *state, int sample_rate) {
+    unsigned int seq = __atomic_load_n(&published_seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+        return -1;
+    }
+    clock_snapshot_t snapshot = published;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&published_seq, __ATOMIC_RELAXED) != seq) {
+        return -1;
+    }
+    
+    double since = (double)(int32_t)(monotonic_us() - snapshot.tick_time);
+    int alive = snapshot.period > 0.0 && since < MIDI_CLOCK_TIMEOUT_MS * 1000.0;
+    
+    state->running = snapshot.running;
+    state->locked = snapshot.locked && alive;
+    state->bpm = state->locked ? (float)(60e6 / (snapshot.period * MIDI_CLOCK_PPQN)) : 0.0f;
+    
+    // Never run past the next tick: if it is late, the position waits for it
+    double position = snapshot.song_tick >= 0 ? (double)snapshot.song_tick : 0.0;
+    if (snapshot.running && snapshot.song_tick >= 0 && alive) {
+        double phase = since / snapshot.period;
+        position += phase < 0.0 ? 0.0 : (phase > 1.0 ? 1.0 : phase);
+    }
+    state->beat = position / MIDI_CLOCK_PPQN;
+    state->beats_per_frame = state->running && state->locked && sample_rate > 0 ?
+        1e6 / (snapshot.period * MIDI_CLOCK_PPQN * sample_rate) : 0.0;
+    return 0;
+}
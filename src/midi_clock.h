@@ -0,0 +1,44 @@
+#ifndef MIDI_CLOCK_H
+#define MIDI_CLOCK_H
+
+#include <stdint.h>
+#include "midi.h"
+
+// MIDI clock resolution (ticks per quarter note)
+#define MIDI_CLOCK_PPQN 24
+
+// Loop bandwidth of the clock follower ([MIDI] clock_bandwidth_hz): lower is
+// smoother, higher follows tempo changes faster
+#define MIDI_CLOCK_DEFAULT_BANDWIDTH 1.0f
+
+// No tick for this long means the clock source has gone
+#define MIDI_CLOCK_TIMEOUT_MS 500
+
+// Tempo and transport as seen by the audio thread at the start of a block
+typedef struct {
+    int running;                // Start/Continue received and no Stop since
+    int locked;                 // Following a live clock (at least one beat of ticks)
+    float bpm;                  // Filtered tempo (0 until locked)
+    double beat;                // Song position in quarter notes since Start
+    double beats_per_frame;     // Advance of 'beat' per frame while running
+} midi_clock_state_t;
+
+// MIDI clock follower
+//
+// Clock ticks are timestamped on arrival by the sequencer and fed through a
+// second-order phase-locked loop, which turns jittery USB arrival times into
+// a steady tick period and tick phase. The MIDI thread publishes the loop
+// state after every tick; the audio thread reads it once per block and
+// interpolates the beat position from the filtered phase.
+
+// Setup (before the MIDI thread starts)
+void midi_clock_init(float bandwidth_hz);
+
+// MIDI thread: Clock, Start, Stop and Continue (other events are ignored)
+void midi_clock_handle_events(const midi_event_t *events, int count);
+
+// Real-time safe, any thread: state at the current time for a sample rate
+// Returns -1 without touching 'state' if the MIDI thread was publishing
+int midi_clock_read(midi_clock_state_t *state, int sample_rate);
+
+#endif // MIDI_CLOCK_H
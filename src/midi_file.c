@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "midi_file.h"
+
+// Tempo until the first tempo event (microseconds per quarter note, 120 BPM)
+#define MIDI_FILE_DEFAULT_TEMPO 500000
+
+// Event before the tempo map is applied
+typedef struct {
+    uint64_t tick;
+    int order;              // File order, keeps simultaneous events stable when sorting
+    int tempo;              // Tempo change (microseconds per quarter note), 0 for channel events
+    int track;
+    midi_event_t event;
+} raw_event_t;
+
+typedef struct {
+    raw_event_t *events;
+    int count;
+    int capacity;
+    uint64_t last_tick;     // Latest tick of any event, including meta events
+} raw_list_t;
+
+static uint32_t read_be(const uint8_t *p, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// Variable-length quantity; returns the bytes used, -1 if truncated
+static int read_varlen(const uint8_t *p, const uint8_t *end, uint32_t *value) {
+    *value = 0;
+    for (int i = 0; i < 4 && p + i < end; i++) {
+        *value = (*value << 7) | (p[i] & 0x7F);
+        if (!(p[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+static int push_event(raw_list_t *list, const raw_event_t *event) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 1024;
+        raw_event_t *events = realloc(list->events, capacity * sizeof(raw_event_t));
+        if (!events) {
+            return -1;
+        }
+        list->events = events;
+        list->capacity = capacity;
+    }
+    
+    list->events[list->count] = *event;
+    list->events[list->count].order = list->count;
+    list->count++;
+    return 0;
+}
+
+// Decode one MTrk chunk into the list (ticks are absolute)
+static int parse_track(const uint8_t *p, const uint8_t *end, int track, raw_list_t *list) {
+    uint64_t tick = 0;
+    uint8_t status = 0;
+    
+    while (p < end) {
+        uint32_t delta, length;
+        int n = read_varlen(p, end, &delta);
+        if (n < 0 || p + n >= end) {
+            return -1;
+        }
+        p += n;
+        tick += delta;
+        if (tick > list->last_tick) {
+            list->last_tick = tick;
+        }
+        
+        // Meta event: only tempo and end of track matter
+        if (*p == 0xFF) {
+            if (end - p < 3) {
+                return -1;
+            }
+            uint8_t type = p[1];
+            p += 2;
+            n = read_varlen(p, end, &length);
+            if (n < 0 || length > (uint32_t)(end - p - n)) {
+                return -1;
+            }
+            p += n;
+            
+            if (type == 0x51 && length == 3) {
+                raw_event_t tempo = { .tick = tick, .tempo = (int)read_be(p, 3), .track = track };
+                if (tempo.tempo > 0 && push_event(list, &tempo) < 0) {
+                    return -1;
+                }
+            } else if (type == 0x2F) {
+                return 0;
+            }
+            p += length;
+            continue;
+        }
+        
+        // SysEx is skipped and cancels running status
+        if (*p == 0xF0 || *p == 0xF7) {
+            n = read_varlen(p + 1, end, &length);
+            if (n < 0 || length > (uint32_t)(end - p - 1 - n)) {
+                return -1;
+            }
+            p += 1 + n + length;
+            status = 0;
+            continue;
+        }
+        
+        if (*p & 0x80) {
+            status = *p++;
+        }
+        if (status < 0x80 || status >= 0xF0) {
+            return -1;
+        }
+        
+        int kind = status & 0xF0;
+        int data_bytes = (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+        if (end - p < data_bytes) {
+            return -1;
+        }
+        
+        raw_event_t e = { .tick = tick, .track = track };
+        e.event.channel = status & 0x0F;
+        e.event.data1 = p[0] & 0x7F;
+        e.event.data2 = data_bytes == 2 ? (p[1] & 0x7F) : 0;
+        e.event.source = -1;
+        p += data_bytes;
+        
+        switch (kind) {
+            case 0x80: e.event.type = MIDI_EVENT_NOTE_OFF; break;
+            case 0x90: e.event.type = e.event.data2 > 0 ? MIDI_EVENT_NOTE_ON : MIDI_EVENT_NOTE_OFF; break;
+            case 0xA0: e.event.type = MIDI_EVENT_KEY_PRESSURE; break;
+            case 0xB0: e.event.type = MIDI_EVENT_CC; break;
+            case 0xC0: e.event.type = MIDI_EVENT_PROGRAM; break;
+            case 0xD0: e.event.type = MIDI_EVENT_PRESSURE; break;
+            case 0xE0: e.event.type = MIDI_EVENT_PITCH; break;
+        }
+        if (push_event(list, &e) < 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+static int compare_raw_events(const void *a, const void *b) {
+    const raw_event_t *x = a;
+    const raw_event_t *y = b;
+    if (x->tick != y->tick) {
+        return x->tick < y->tick ? -1 : 1;
+    }
+    return x->order - y->order;
+}
+
+// Load a Standard MIDI File and apply its tempo map
+int midi_file_load(const char *path, midi_file_t *file) {
+    memset(file, 0, sizeof(*file));
+    
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("Error: Cannot open MIDI file %s\n", path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    
+    uint8_t *data = size > 0 ? malloc(size) : NULL;
+    if (!data || fread(data, 1, size, f) != (size_t)size) {
+        printf("Error: Cannot read MIDI file %s\n", path);
+        free(data);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    
+    const uint8_t *end = data + size;
+    if (size < 14 || memcmp(data, "MThd", 4) != 0 || read_be(data + 4, 4) < 6) {
+        printf("Error: %s is not a Standard MIDI File\n", path);
+        free(data);
+        return -1;
+    }
+    
+    int format = read_be(data + 8, 2);
+    int division = read_be(data + 12, 2);
+    if (format > 1 || division == 0) {
+        printf("Error: MIDI file format %d is not supported (only 0 and 1)\n", format);
+        free(data);
+        return -1;
+    }
+    
+    // Parse every MTrk chunk (unknown chunks are skipped)
+    raw_list_t list = {0};
+    const uint8_t *p = data + 8 + read_be(data + 4, 4);
+    while (end - p >= 8) {
+        uint32_t length = read_be(p + 4, 4);
+        if (length > (uint32_t)(end - p - 8)) {
+            break;
+        }
+        if (memcmp(p, "MTrk", 4) == 0) {
+            if (parse_track(p + 8, p + 8 + length, file->tracks, &list) < 0) {
+                printf("Warning: Track %d of %s is malformed, using the events before the error\n",
+                       file->tracks, path);
+            }
+            file->tracks++;
+        }
+        p += 8 + length;
+    }
+    free(data);
+    
+    qsort(list.events, list.count, sizeof(raw_event_t), compare_raw_events);
+    
+    file->events = malloc((list.count ? list.count : 1) * sizeof(midi_file_event_t));
+    if (!file->events) {
+        free(list.events);
+        return -1;
+    }
+    
+    // Ticks to seconds: SMPTE divisions have a fixed tick length, PPQ follows the tempo map
+    double seconds_per_tick;
+    int smpte = division & 0x8000;
+    if (smpte) {
+        int fps = -(int8_t)(division >> 8);
+        seconds_per_tick = 1.0 / (fps * (division & 0xFF));
+    } else {
+        seconds_per_tick = MIDI_FILE_DEFAULT_TEMPO / (1e6 * division);
+    }
+    
+    uint64_t segment_tick = 0;
+    double segment_seconds = 0.0;
+    for (int i = 0; i < list.count; i++) {
+        const raw_event_t *e = &list.events[i];
+        double seconds = segment_seconds + (e->tick - segment_tick) * seconds_per_tick;
+        
+        if (e->tempo) {
+            if (!smpte) {
+                segment_tick = e->tick;
+                segment_seconds = seconds;
+                seconds_per_tick = e->tempo / (1e6 * division);
+            }
+            continue;
+        }
+        
+        midi_file_event_t *out = &file->events[file->count++];
+        out->seconds = seconds;
+        out->track = e->track;
+        out->event = e->event;
+    }
+    file->duration = segment_seconds + (list.last_tick - segment_tick) * seconds_per_tick;
+    
+    free(list.events);
+    return 0;
+}
+
+void midi_file_free(midi_file_t *file) {
+    free(file->events);
+    memset(file, 0, sizeof(*file));
+}
@@ -0,0 +1,24 @@
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include "midi.h"
+
+// Channel event from a Standard MIDI File with its time
+typedef struct {
+    double seconds;         // Time from the start of the file (tempo map applied)
+    int track;              // Track the event came from
+    midi_event_t event;     // Decoded like live input (note on with velocity 0 = note off)
+} midi_file_event_t;
+
+// Standard MIDI File (format 0 or 1) flattened to one time-ordered event list
+typedef struct {
+    midi_file_event_t *events;
+    int count;
+    int tracks;
+    double duration;        // Time of the last event, including meta events
+} midi_file_t;
+
+int midi_file_load(const char *path, midi_file_t *file);
+void midi_file_free(midi_file_t *file);
+
+#endif // MIDI_FILE_H
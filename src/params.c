@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "params.h"
+
+// Values snap to their target once within this fraction of the range
+#define PARAMS_SNAP_FRACTION 1e-4f
+
+typedef struct {
+    char name[PARAMS_MAX_NAME];
+    float min;
+    float max;
+    float smoothing_ms;
+    int registered;
+} param_info_t;
+
+static param_info_t infos[PARAMS_MAX];
+static int param_count = 0;                 // Highest registered id + 1
+
+// Targets, written by control threads under write_mutex and published by write_seq
+static float targets[PARAMS_MAX];
+static unsigned int write_seq = 0;          // Odd while a write is in progress
+static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Smoothed values (audio thread only)
+static float snapshot[PARAMS_MAX];
+static unsigned int snapshot_seq = 0;
+static float values[PARAMS_MAX];
+static float previous[PARAMS_MAX];
+static unsigned char changed[PARAMS_MAX];
+static float coeffs[PARAMS_MAX];            // Per-block smoothing coefficients
+static int coeff_sample_rate = 0;
+static int coeff_frames = 0;
+static int first_update = 1;                // Start at the targets instead of gliding to them
+
+// CC mapping: parameter id + 1 (0 = unmapped), read on the MIDI thread
+static short cc_map[PARAMS_MIDI_CHANNELS][PARAMS_MIDI_CONTROLLERS];
+static int learn_id = -1;
+
+static int valid_id(int id) {
+    return id >= 0 && id < PARAMS_MAX && infos[id].registered;
+}
+
+static float clamp_value(int id, float value) {
+    if (value < infos[id].min) return infos[id].min;
+    if (value > infos[id].max) return infos[id].max;
+    return value;
+}
+
+// Clear the registry and the CC map (before the audio thread runs)
+void params_init(void) {
+    memset(infos, 0, sizeof(infos));
+    memset(cc_map, 0, sizeof(cc_map));
+    param_count = 0;
+    write_seq = 0;
+    snapshot_seq = 0;
+    coeff_sample_rate = 0;
+    coeff_frames = 0;
+    first_update = 1;
+    learn_id = -1;
+}
+
+// Register a parameter (before the audio thread runs)
+int params_register(int id, const char *name, float min, float max,
+                    float default_value, float smoothing_ms) {
+    if (id < 0 || id >= PARAMS_MAX || !name || max <= min) {
+        printf("Error: Invalid parameter %d (%s)\n", id, name ? name : "unnamed");
+        return -1;
+    }
+    
+    param_info_t *info = &infos[id];
+    snprintf(info->name, sizeof(info->name), "%s", name);
+    info->min = min;
+    info->max = max;
+    info->smoothing_ms = smoothing_ms > 0.0f ? smoothing_ms : 0.0f;
+    info->registered = 1;
+    
+    float value = clamp_value(id, default_value);
+    targets[id] = value;
+    snapshot[id] = value;
+    values[id] = value;
+    previous[id] = value;
+    changed[id] = 0;
+    
+    if (id >= param_count) {
+        param_count = id + 1;
+    }
+    return 0;
+}
+
+// Look up a parameter by name (-1 if unknown)
+int params_find(const char *name) {
+    for (int id = 0; id < param_count; id++) {
+        if (infos[id].registered && strcmp(infos[id].name, name) == 0) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+const char* params_name(int id) {
+    return valid_id(id) ? infos[id].name : "unknown";
+}
+
+// Set a parameter target (any control thread, never the audio thread)
+int params_set(int id, float value) {
+    if (!valid_id(id)) {
+        return -1;
+    }
+    
+    value = clamp_value(id, value);
+    
+    pthread_mutex_lock(&write_mutex);
+    unsigned int seq = write_seq;
+    __atomic_store_n(&write_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store(&targets[id], &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&write_seq, seq + 2, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&write_mutex);
+    
+    return 0;
+}
+
+// Set a parameter from a position in its range (0.0 = min, 1.0 = max)
+int params_set_normalized(int id, float amount) {
+    if (!valid_id(id)) {
+        return -1;
+    }
+    return params_set(id, infos[id].min + amount * (infos[id].max - infos[id].min));
+}
+
+// Get the last target written (not the smoothed value)
+float params_get(int id) {
+    if (!valid_id(id)) {
+        return 0.0f;
+    }
+    
+    float value;
+    __atomic_load(&targets[id], &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+// Map a CC on a MIDI channel to a parameter (replaces any previous mapping)
+int params_map_cc(int channel, int controller, int id) {
+    if (channel < 0 || channel >= PARAMS_MIDI_CHANNELS ||
+        controller < 0 || controller >= PARAMS_MIDI_CONTROLLERS || !valid_id(id)) {
+        return -1;
+    }
+    
+    __atomic_store_n(&cc_map[channel][controller], (short)(id + 1), __ATOMIC_RELAXED);
+    return 0;
+}
+
+void params_unmap_cc(int channel, int controller) {
+    if (channel >= 0 && channel < PARAMS_MIDI_CHANNELS &&
+        controller >= 0 && controller < PARAMS_MIDI_CONTROLLERS) {
+        __atomic_store_n(&cc_map[channel][controller], 0, __ATOMIC_RELAXED);
+    }
+}
+
+// Map the next CC received to a parameter
+int params_learn(int id) {
+    if (!valid_id(id)) {
+        return -1;
+    }
+    
+    __atomic_store_n(&learn_id, id, __ATOMIC_RELEASE);
+    printf("MIDI learn: move a control to map it to %s\n", infos[id].name);
+    return 0;
+}
+
+// Apply a CC to its mapped parameter (MIDI thread)
+// Returns 1 if the CC drives a parameter, 0 if it is unmapped
+int params_handle_cc(int channel, int controller, int value) {
+    if (channel < 0 || channel >= PARAMS_MIDI_CHANNELS ||
+        controller < 0 || controller >= PARAMS_MIDI_CONTROLLERS) {
+        return 0;
+    }
+    
+    int pending = __atomic_load_n(&learn_id, __ATOMIC_ACQUIRE);
+    if (pending >= 0 &&
+        __atomic_compare_exchange_n(&learn_id, &pending, -1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        params_map_cc(channel, controller, pending);
+        printf("MIDI learn: channel %d CC %d -> %s\n", channel + 1, controller, infos[pending].name);
+    }
+    
+    int id = __atomic_load_n(&cc_map[channel][controller], __ATOMIC_RELAXED) - 1;
+    if (id < 0) {
+        return 0;
+    }
+    
+    params_set_normalized(id, value / 127.0f);
+    return 1;
+}
+
+void params_print_cc_map(void) {
+    int mapped = 0;
+    for (int ch = 0; ch < PARAMS_MIDI_CHANNELS; ch++) {
+        for (int cc = 0; cc < PARAMS_MIDI_CONTROLLERS; cc++) {
+            int id = __atomic_load_n(&cc_map[ch][cc], __ATOMIC_RELAXED) - 1;
+            if (id >= 0) {
+                printf("  Channel %d CC %d -> %s\n", ch + 1, cc, infos[id].name);
+                mapped++;
+            }
+        }
+    }
+    if (mapped == 0) {
+        printf("  No CC mappings\n");
+    }
+}
+
+// Take a consistent snapshot of the targets if any changed; a write in
+// progress keeps the last snapshot until the next block
+static void take_snapshot(void) {
+    unsigned int seq = __atomic_load_n(&write_seq, __ATOMIC_ACQUIRE);
+    if (seq == snapshot_seq || (seq & 1)) {
+        return;
+    }
+    
+    float copy[PARAMS_MAX];
+    for (int id = 0; id < param_count; id++) {
+        __atomic_load(&targets[id], &copy[id], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&write_seq, __ATOMIC_RELAXED) != seq) {
+        return;
+    }
+    
+    memcpy(snapshot, copy, param_count * sizeof(float));
+    snapshot_seq = seq;
+}
+
+// Smooth every parameter towards its target by one block (audio thread only)
+void params_update(int sample_rate, int nframes) {
+    if (sample_rate <= 0 || nframes <= 0) {
+        return;
+    }
+    
+    if (sample_rate != coeff_sample_rate || nframes != coeff_frames) {
+        float block_ms = 1000.0f * nframes / sample_rate;
+        for (int id = 0; id < param_count; id++) {
+            coeffs[id] = infos[id].smoothing_ms > 0.0f ?
+                1.0f - expf(-block_ms / infos[id].smoothing_ms) : 1.0f;
+        }
+        coeff_sample_rate = sample_rate;
+        coeff_frames = nframes;
+    }
+    
+    take_snapshot();
+    
+    for (int id = 0; id < param_count; id++) {
+        previous[id] = values[id];
+        
+        float diff = snapshot[id] - values[id];
+        if (diff != 0.0f) {
+            if (first_update || fabsf(diff) <= PARAMS_SNAP_FRACTION * (infos[id].max - infos[id].min)) {
+                values[id] = snapshot[id];
+            } else {
+                values[id] += diff * coeffs[id];
+            }
+        }
+        changed[id] = values[id] != previous[id];
+    }
+    first_update = 0;
+}
+
+float params_value(int id) {
+    return (id >= 0 && id < PARAMS_MAX) ? values[id] : 0.0f;
+}
+
+float params_previous(int id) {
+    return (id >= 0 && id < PARAMS_MAX) ? previous[id] : 0.0f;
+}
+
+int params_changed(int id) {
+    return (id >= 0 && id < PARAMS_MAX) ? changed[id] : 0;
+}
@@ -0,0 +1,48 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+// Registry size and limits
+#define PARAMS_MAX 128
+#define PARAMS_MAX_NAME 32
+#define PARAMS_MIDI_CHANNELS 16
+#define PARAMS_MIDI_CONTROLLERS 128
+
+// Parameter store shared between control threads and the audio thread
+//
+// Control threads (main, MIDI) write targets through a seqlock; writers are
+// serialized by a mutex the audio thread never touches. Once per block the
+// audio thread copies all targets if they changed and the copy is consistent
+// (otherwise it keeps the last snapshot and retries next block), then moves
+// each value towards its target with a one-pole smoother of the parameter's
+// smoothing time. Consumers ramp from params_previous() to params_value()
+// across the block.
+//
+// MIDI CCs can be mapped to any parameter; the mapping table is looked up on
+// the MIDI thread, so mapped CCs cost the audio thread nothing.
+
+// Setup (not real-time safe)
+void params_init(void);
+int params_register(int id, const char *name, float min, float max,
+                    float default_value, float smoothing_ms);
+int params_find(const char *name);
+const char* params_name(int id);
+
+// Control thread functions
+int params_set(int id, float value);
+int params_set_normalized(int id, float amount);   // 0.0 - 1.0 of the range
+float params_get(int id);                          // Last written target
+
+// CC mapping (MIDI channel 0-15, controller 0-127)
+int params_map_cc(int channel, int controller, int id);
+void params_unmap_cc(int channel, int controller);
+int params_learn(int id);                           // Next CC moved gets mapped to id
+int params_handle_cc(int channel, int controller, int value);  // 1 if the CC was mapped
+void params_print_cc_map(void);
+
+// Real-time functions (audio thread only)
+void params_update(int sample_rate, int nframes);
+float params_value(int id);                         // Value at the end of this block
+float params_previous(int id);                      // Value at the end of the last block
+int params_changed(int id);                         // Value moved this block
+
+#endif // PARAMS_H
@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sndfile.h>
+#include <jack/ringbuffer.h>
+#include "recorder.h"
+#include "config.h"
+
+// Interleaved stereo frames
+#define RECORDER_FRAME_BYTES (2 * sizeof(float))
+
+static recorder_config_t recorder_config;
+static int recorder_initialized = 0;
+static int recorder_sample_rate = 48000;
+static jack_ringbuffer_t *ring = NULL;
+
+// Writer thread
+static pthread_t writer_thread;
+static int writer_running = 0;
+static SNDFILE *file = NULL;
+static char file_path[512];
+static unsigned long frames_written = 0;
+
+// Requested state (control threads), state the audio thread acts on (writer),
+// and what the audio thread last did (audio thread)
+static int record_wanted = 0;
+static int record_enabled = 0;
+static int record_acknowledged = 0;
+static unsigned long overruns = 0;
+
+recorder_config_t recorder_get_default_config(void) {
+    recorder_config_t config = {
+        .enabled = 0,
+        .flac = 0,
+        .transport = 1,
+        .cc = -1
+    };
+    const char *home = getenv("HOME");
+    snprintf(config.directory, sizeof(config.directory), "%s/%s", home ? home : ".", RECORDER_DEFAULT_DIRECTORY);
+    return config;
+}
+
+// Load the [RECORDER] section
+void recorder_load_config(recorder_config_t *config) {
+    config->enabled = config_get_bool("RECORDER", "enabled", config->enabled);
+    const char *directory = config_get_string("RECORDER", "directory", "");
+    if (directory[0] != '\0') {
+        snprintf(config->directory, sizeof(config->directory), "%s", directory);
+    }
+    config->flac = strcmp(config_get_string("RECORDER", "format", config->flac ? "flac" : "wav"), "flac") == 0;
+    config->transport = config_get_bool("RECORDER", "transport", config->transport);
+    config->cc = config_get_int("RECORDER", "cc", config->cc);
+}
+
+// Write everything in the ring to the open file (writer thread)
+static void drain_ring(void) {
+    jack_ringbuffer_data_t segments[2];
+    jack_ringbuffer_get_read_vector(ring, segments);
+    
+    size_t consumed = 0;
+    for (int i = 0; i < 2; i++) {
+        sf_count_t frames = segments[i].len / RECORDER_FRAME_BYTES;
+        if (frames == 0) {
+            continue;
+        }
+        if (file && sf_writef_float(file, (const float*)segments[i].buf, frames) != frames) {
+            printf("Warning: Recorder write to %s failed: %s\n", file_path, sf_strerror(file));
+        }
+        frames_written += frames;
+        consumed += frames * RECORDER_FRAME_BYTES;
+    }
+    jack_ringbuffer_read_advance(ring, consumed);
+}
+
+// Create the recording file (writer thread)
+static int open_file(void) {
+    if (mkdir(recorder_config.directory, 0755) != 0 && errno != EEXIST) {
+        printf("Error: Cannot create recording folder %s: %s\n", recorder_config.directory, strerror(errno));
+        return -1;
+    }
+    
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(file_path, sizeof(file_path), "%s/rec-%s.%s", recorder_config.directory, stamp,
+             recorder_config.flac ? "flac" : "wav");
+    
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.samplerate = recorder_sample_rate;
+    info.channels = 2;
+    info.format = (recorder_config.flac ? SF_FORMAT_FLAC : SF_FORMAT_WAV) | SF_FORMAT_PCM_24;
+    
+    file = sf_open(file_path, SFM_WRITE, &info);
+    if (!file) {
+        printf("Error: Cannot create recording %s: %s\n", file_path, sf_strerror(NULL));
+        return -1;
+    }
+    frames_written = 0;
+    return 0;
+}
+
+// Stop the audio thread feeding the ring, write what is left and close the file (writer thread)
+static void finish_recording(void) {
+    __atomic_store_n(&record_enabled, 0, __ATOMIC_RELEASE);
+    
+    // The audio thread may be writing its last block; without JACK running nobody answers
+    for (int i = 0; i < 500 && __atomic_load_n(&record_acknowledged, __ATOMIC_ACQUIRE); i++) {
+        usleep(1000);
+    }
+    drain_ring();
+    
+    if (file) {
+        sf_close(file);
+        file = NULL;
+        printf("Recorder: %.1f s written to %s (%lu overruns)\n",
+               (double)frames_written / recorder_sample_rate, file_path,
+               __atomic_load_n(&overruns, __ATOMIC_RELAXED));
+    }
+}
+
+static void* writer_func(void *arg) {
+    (void)arg;
+    
+    while (__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        int wanted = __atomic_load_n(&record_wanted, __ATOMIC_ACQUIRE);
+        int enabled = __atomic_load_n(&record_enabled, __ATOMIC_RELAXED);
+        
+        if (wanted && !enabled) {
+            // Leftovers from an unacknowledged stop belong to no file
+            drain_ring();
+            if (open_file() == 0) {
+                __atomic_store_n(&overruns, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&record_enabled, 1, __ATOMIC_RELEASE);
+                printf("Recorder: recording to %s\n", file_path);
+            } else {
+                __atomic_store_n(&record_wanted, 0, __ATOMIC_RELEASE);
+            }
+        } else if (!wanted && enabled) {
+            finish_recording();
+        } else if (enabled) {
+            drain_ring();
+        }
+        
+        usleep(RECORDER_POLL_MS * 1000);
+    }
+    
+    if (__atomic_load_n(&record_enabled, __ATOMIC_RELAXED)) {
+        finish_recording();
+    }
+    return NULL;
+}
+
+// Allocate the ring and start the writer thread (does nothing unless [RECORDER] enabled)
+int recorder_init(const recorder_config_t *config, int sample_rate) {
+    if (recorder_initialized) {
+        return 0;
+    }
+    
+    recorder_config = *config;
+    if (!recorder_config.enabled) {
+        return 0;
+    }
+    recorder_sample_rate = sample_rate > 0 ? sample_rate : 48000;
+    
+    ring = jack_ringbuffer_create((size_t)recorder_sample_rate * RECORDER_RING_SECONDS * RECORDER_FRAME_BYTES);
+    if (!ring) {
+        printf("Error: Cannot allocate the recorder ring\n");
+        return -1;
+    }
+    jack_ringbuffer_mlock(ring);
+    
+    __atomic_store_n(&writer_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&writer_thread, NULL, writer_func, NULL) != 0) {
+        printf("Error: Cannot start the recorder thread\n");
+        writer_running = 0;
+        jack_ringbuffer_free(ring);
+        ring = NULL;
+        return -1;
+    }
+    
+    recorder_initialized = 1;
+    printf("Recorder: %s files in %s (%s%s)\n", recorder_config.flac ? "FLAC" : "WAV", recorder_config.directory,
+           recorder_config.transport ? "MIDI transport" : "no transport",
+           recorder_config.cc >= 0 ? ", CC toggle" : "");
+    return 0;
+}
+
+// Stop the writer thread, closing any recording (the audio thread must have stopped)
+void recorder_cleanup(void) {
+    if (!recorder_initialized) {
+        return;
+    }
+    
+    __atomic_store_n(&record_wanted, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&writer_running, 0, __ATOMIC_RELEASE);
+    pthread_join(writer_thread, NULL);
+    
+    jack_ringbuffer_free(ring);
+    ring = NULL;
+    recorder_initialized = 0;
+}
+
+void recorder_start(void) {
+    if (recorder_initialized) {
+        __atomic_store_n(&record_wanted, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void recorder_stop(void) {
+    __atomic_store_n(&record_wanted, 0, __ATOMIC_RELEASE);
+}
+
+// Start/stop from MIDI transport and the configured CC (MIDI thread)
+void recorder_handle_events(const midi_event_t *events, int count) {
+    if (!recorder_initialized) {
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        
+        if (recorder_config.transport && (e->type == MIDI_EVENT_START || e->type == MIDI_EVENT_CONTINUE)) {
+            recorder_start();
+        } else if (recorder_config.transport && e->type == MIDI_EVENT_STOP) {
+            recorder_stop();
+        } else if (e->type == MIDI_EVENT_CC && e->data1 == recorder_config.cc) {
+            if (e->data2 >= 64) {
+                recorder_start();
+            } else {
+                recorder_stop();
+            }
+        }
+    }
+}
+
+// Copy one output block into the ring, interleaved; a block that doesn't fit is dropped whole
+void recorder_write(const float *left, const float *right, int nframes) {
+    int enabled = __atomic_load_n(&record_enabled, __ATOMIC_ACQUIRE);
+    if (!enabled) {
+        if (__atomic_load_n(&record_acknowledged, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&record_acknowledged, 0, __ATOMIC_RELEASE);
+        }
+        return;
+    }
+    __atomic_store_n(&record_acknowledged, 1, __ATOMIC_RELAXED);
+    
+    if (jack_ringbuffer_write_space(ring) < (size_t)nframes * RECORDER_FRAME_BYTES) {
+        __atomic_add_fetch(&overruns, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    // Frames never straddle the wrap point (the ring size and every write are whole frames)
+    jack_ringbuffer_data_t segments[2];
+    jack_ringbuffer_get_write_vector(ring, segments);
+    if (!right) {
+        right = left;
+    }
+    
+    int f = 0;
+    for (int i = 0; i < 2 && f < nframes; i++) {
+        float *out = (float*)segments[i].buf;
+        int frames = segments[i].len / RECORDER_FRAME_BYTES;
+        for (int n = 0; n < frames && f < nframes; n++, f++) {
+            out[n * 2] = left[f];
+            out[n * 2 + 1] = right[f];
+        }
+    }
+    jack_ringbuffer_write_advance(ring, (size_t)nframes * RECORDER_FRAME_BYTES);
+}
+
+int recorder_is_recording(void) {
+    return __atomic_load_n(&record_enabled, __ATOMIC_RELAXED);
+}
+
+unsigned long recorder_get_overruns(void) {
+    return __atomic_load_n(&overruns, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,51 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "midi.h"
+
+// Output kept in the ring before the writer must have drained it
+#define RECORDER_RING_SECONDS 4
+
+// Writer thread polling interval (the audio thread never signals it)
+#define RECORDER_POLL_MS 20
+
+// Default folder for recordings, relative to $HOME ([RECORDER] directory)
+#define RECORDER_DEFAULT_DIRECTORY "recordings"
+
+// Recorder configuration ([RECORDER] section)
+typedef struct {
+    int enabled;                // Start the writer thread at all
+    char directory[256];        // Where rec-YYYYmmdd-HHMMSS.wav/.flac files go
+    int flac;                   // FLAC instead of WAV (both 24-bit)
+    int transport;              // MIDI Start/Continue start recording, Stop stops it
+    int cc;                     // Controller that starts (>= 64) / stops (< 64) recording, -1 = none
+} recorder_config_t;
+
+// Output recorder
+//
+// The audio thread copies each finished output block into a preallocated
+// lock-free ring (or counts an overrun if it is full). A normal-priority
+// writer thread opens and closes files and drains the ring through
+// libsndfile, so the audio thread never waits on I/O.
+
+// Configuration
+recorder_config_t recorder_get_default_config(void);
+void recorder_load_config(recorder_config_t *config);
+
+// Setup (not real-time safe)
+int recorder_init(const recorder_config_t *config, int sample_rate);
+void recorder_cleanup(void);
+
+// Control (any thread, never blocks; the writer acts within RECORDER_POLL_MS)
+void recorder_start(void);
+void recorder_stop(void);
+void recorder_handle_events(const midi_event_t *events, int count);
+
+// Real-time safe (audio thread only; right NULL = mono)
+void recorder_write(const float *left, const float *right, int nframes);
+
+// Status
+int recorder_is_recording(void);
+unsigned long recorder_get_overruns(void);
+
+#endif // RECORDER_H
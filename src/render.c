@@ -0,0 +1,310 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sndfile.h>
+#include "midi_file.h"
+#include "audio_engine.h"
+#include "sample_loader.h"
+#include "engine_setup.h"
+#include "reverb.h"
+#include "limiter.h"
+#include "config.h"
+
+// Offline renderer: plays a Standard MIDI File through the sampler engine
+// without JACK and writes the mix to a WAV file.
+//
+// The engine is a process-wide singleton, so each MIDI channel renders in its
+// own forked process (samples are loaded once and shared copy-on-write) into
+// a shared stem buffer. The parent sums the stems and runs the output limiter.
+
+#define RENDER_DEFAULT_RATE 48000
+#define RENDER_DEFAULT_BLOCK 128
+#define RENDER_DEFAULT_TAIL 2.0
+#define RENDER_DEFAULT_OUTPUT "render.wav"
+#define RENDER_MIX_BLOCK 1024
+
+typedef struct {
+    const char *midi_path;
+    const char *output_path;
+    const char *config_path;
+    const char *samples_dir;
+    int sample_rate;
+    int block_size;
+    double tail_seconds;
+    int jobs;
+    int verbose;
+} render_options_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [options] song.mid\n", program);
+    printf("  -o file    Output WAV file (default %s)\n", RENDER_DEFAULT_OUTPUT);
+    printf("  -c file    Configuration file (default %s)\n", CONFIG_DEFAULT_FILE);
+    printf("  -s dir     Samples folder (default ~/samples)\n");
+    printf("  -r rate    Sample rate (default %d)\n", RENDER_DEFAULT_RATE);
+    printf("  -b frames  Engine block size; MIDI events are applied at block starts (default %d)\n",
+           RENDER_DEFAULT_BLOCK);
+    printf("  -t sec     Release/reverb tail after the last event (default %.1f)\n", RENDER_DEFAULT_TAIL);
+    printf("  -j jobs    Channels rendered in parallel (default: CPU count)\n");
+    printf("  -v         Show engine output of the channel renders\n");
+}
+
+// Render one MIDI channel into its stem (child process, never returns)
+static void render_channel(const render_options_t *options, const midi_file_t *song, int channel,
+                           float *left, float *right, long total_frames) {
+    if (!options->verbose && !freopen("/dev/null", "w", stdout)) {
+        _exit(1);
+    }
+    
+    // Stems are summed and limited by the parent; AGC would make them depend on each other
+    // Channels already render in parallel processes, so each one renders its voices alone
+    audio_engine_config_t engine_config = audio_engine_get_default_config();
+    engine_setup_read_config(&engine_config);
+    engine_config.auto_gain_control = 0;
+    engine_config.limit_output = 0;
+    engine_config.render_threads = 1;
+    if (audio_engine_init(&engine_config) < 0) {
+        _exit(1);
+    }
+    audio_engine_sample_rate_changed(options->sample_rate, NULL);
+    audio_engine_buffer_size_changed(options->block_size, NULL);
+    engine_setup_apply_effects();
+    engine_setup_load_cc_map();
+    reverb_set_offline(1);
+    engine_setup_load_reverb(options->samples_dir);
+    audio_engine_set_channel_sample(-1, sample_loader_get_first_sample());
+    
+    midi_event_t batch[MIDI_BATCH_SIZE];
+    int next = 0;
+    for (long frame = 0; frame < total_frames; frame += options->block_size) {
+        // Events of every channel go through the CC map (a mapped CC may target this
+        // channel's parameters); only this channel's events reach the engine
+        long block_end = frame + options->block_size;
+        while (next < song->count && (long)(song->events[next].seconds * options->sample_rate) < block_end) {
+            int count = 0;
+            while (next < song->count && count < MIDI_BATCH_SIZE &&
+                   (long)(song->events[next].seconds * options->sample_rate) < block_end) {
+                batch[count++] = song->events[next++].event;
+            }
+            
+            count = engine_setup_apply_cc_map(batch, count);
+            int kept = 0;
+            for (int i = 0; i < count; i++) {
+                if (batch[i].channel == channel) {
+                    batch[kept++] = batch[i];
+                }
+            }
+            if (kept > 0) {
+                audio_engine_queue_events(batch, kept);
+            }
+        }
+        
+        audio_engine_render(left + frame, right + frame, options->block_size);
+    }
+    
+    audio_engine_cleanup();
+    fflush(stdout);
+    _exit(0);
+}
+
+// Sum the stems, limit and write the WAV file (24-bit PCM)
+static int write_mix(const render_options_t *options, float *stems, const int *channels, int stem_count,
+                     long total_frames) {
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.samplerate = options->sample_rate;
+    info.channels = 2;
+    info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+    
+    SNDFILE *file = sf_open(options->output_path, SFM_WRITE, &info);
+    if (!file) {
+        printf("Error: Cannot write %s: %s\n", options->output_path, sf_strerror(NULL));
+        return -1;
+    }
+    
+    limiter_t limiter;
+    limiter_init(&limiter, LIMITER_DEFAULT_CEILING, LIMITER_DEFAULT_RELEASE_MS, LIMITER_DEFAULT_SMOOTHING_MS);
+    limiter_configure(&limiter, options->sample_rate, RENDER_MIX_BLOCK);
+    limiter_set_input_gain(&limiter, 1.0f);
+    
+    static float mix_left[RENDER_MIX_BLOCK], mix_right[RENDER_MIX_BLOCK];
+    static float interleaved[RENDER_MIX_BLOCK * 2];
+    for (long frame = 0; frame < total_frames; frame += RENDER_MIX_BLOCK) {
+        int n = total_frames - frame < RENDER_MIX_BLOCK ? (int)(total_frames - frame) : RENDER_MIX_BLOCK;
+        
+        memset(mix_left, 0, sizeof(mix_left));
+        memset(mix_right, 0, sizeof(mix_right));
+        for (int s = 0; s < stem_count; s++) {
+            const float *left = stems + (size_t)channels[s] * 2 * total_frames + frame;
+            const float *right = left + total_frames;
+            for (int i = 0; i < n; i++) {
+                mix_left[i] += left[i];
+                mix_right[i] += right[i];
+            }
+        }
+        
+        // The limiter always runs on whole blocks (the last one is zero-padded)
+        limiter_process(&limiter, mix_left, mix_right, mix_left, mix_right, RENDER_MIX_BLOCK);
+        for (int i = 0; i < n; i++) {
+            interleaved[i * 2] = mix_left[i];
+            interleaved[i * 2 + 1] = mix_right[i];
+        }
+        if (sf_writef_float(file, interleaved, n) != n) {
+            printf("Error: Write to %s failed: %s\n", options->output_path, sf_strerror(file));
+            sf_close(file);
+            return -1;
+        }
+    }
+    
+    sf_close(file);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    render_options_t options = {
+        .output_path = RENDER_DEFAULT_OUTPUT,
+        .config_path = CONFIG_DEFAULT_FILE,
+        .sample_rate = RENDER_DEFAULT_RATE,
+        .block_size = RENDER_DEFAULT_BLOCK,
+        .tail_seconds = RENDER_DEFAULT_TAIL,
+        .jobs = (int)sysconf(_SC_NPROCESSORS_ONLN),
+    };
+    
+    char default_samples[256];
+    snprintf(default_samples, sizeof(default_samples), "%s/samples", getenv("HOME") ? getenv("HOME") : ".");
+    options.samples_dir = default_samples;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "o:c:s:r:b:t:j:vh")) != -1) {
+        switch (opt) {
+            case 'o': options.output_path = optarg; break;
+            case 'c': options.config_path = optarg; break;
+            case 's': options.samples_dir = optarg; break;
+            case 'r': options.sample_rate = atoi(optarg); break;
+            case 'b': options.block_size = atoi(optarg); break;
+            case 't': options.tail_seconds = atof(optarg); break;
+            case 'j': options.jobs = atoi(optarg); break;
+            case 'v': options.verbose = 1; break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1 || options.sample_rate < 8000 || options.block_size < 16 ||
+        options.block_size > 4096 || options.tail_seconds < 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    options.midi_path = argv[optind];
+    if (options.jobs < 1) {
+        options.jobs = 1;
+    }
+    
+    config_load(options.config_path);
+    
+    midi_file_t song;
+    if (midi_file_load(options.midi_path, &song) < 0) {
+        return 1;
+    }
+    
+    // Only channels that play something get a stem
+    int channels[ENGINE_CHANNEL_BUSES];
+    int stem_count = 0;
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        for (int i = 0; i < song.count; i++) {
+            if (song.events[i].event.channel == ch && song.events[i].event.type == MIDI_EVENT_NOTE_ON) {
+                channels[stem_count++] = ch;
+                break;
+            }
+        }
+    }
+    printf("%s: %d tracks, %d events, %.1f s, %d channel(s) with notes\n",
+           options.midi_path, song.tracks, song.count, song.duration, stem_count);
+    
+    // Samples (and their mip levels) are ready before forking so every render shares them
+    if (sample_loader_init(options.samples_dir) < 0) {
+        printf("Failed to initialize sample loader\n");
+        midi_file_free(&song);
+        return 1;
+    }
+    sample_loader_wait_for_mips();
+    
+    long total_frames = (long)((song.duration + options.tail_seconds) * options.sample_rate) + 1;
+    total_frames = (total_frames + options.block_size - 1) / options.block_size * options.block_size;
+    
+    // Planar stems [channel][left/right][frame], shared with the channel renders
+    size_t stems_bytes = (size_t)ENGINE_CHANNEL_BUSES * 2 * total_frames * sizeof(float);
+    float *stems = stem_count > 0 ? mmap(NULL, stems_bytes, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0) : NULL;
+    if (stems == MAP_FAILED) {
+        printf("Error: Cannot allocate %zu MB of stem buffers\n", stems_bytes >> 20);
+        sample_loader_cleanup();
+        midi_file_free(&song);
+        return 1;
+    }
+    
+    double start = now_seconds();
+    int running = 0;
+    int failed = 0;
+    fflush(stdout);
+    for (int s = 0; s < stem_count || running > 0; ) {
+        if (s < stem_count && running < options.jobs) {
+            float *left = stems + (size_t)channels[s] * 2 * total_frames;
+            pid_t pid = fork();
+            if (pid == 0) {
+                render_channel(&options, &song, channels[s], left, left + total_frames, total_frames);
+            }
+            if (pid < 0) {
+                printf("Error: Cannot start render of channel %d\n", channels[s] + 1);
+                failed++;
+            } else {
+                running++;
+            }
+            s++;
+            continue;
+        }
+        
+        int status;
+        if (wait(&status) > 0) {
+            running--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed++;
+            }
+        } else {
+            break;
+        }
+    }
+    double render_time = now_seconds() - start;
+    
+    int result = 0;
+    if (failed > 0) {
+        printf("Error: %d channel render(s) failed\n", failed);
+        result = 1;
+    } else if (write_mix(&options, stems, channels, stem_count, total_frames) < 0) {
+        result = 1;
+    } else {
+        double seconds = (double)total_frames / options.sample_rate;
+        double wall = now_seconds() - start;
+        printf("Rendered %.1f s to %s in %.2f s (channels %.2f s, %d jobs): %.1fx realtime\n",
+               seconds, options.output_path, wall, render_time, options.jobs,
+               wall > 0.0 ? seconds / wall : 0.0);
+    }
+    
+    if (stems) {
+        munmap(stems, stems_bytes);
+    }
+    sample_loader_cleanup();
+    midi_file_free(&song);
+    config_cleanup();
+    return result;
+}
@@ -0,0 +1,391 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <fftw3.h>
+#include "reverb.h"
+#include "rt_setup.h"
+#include "dsp.h"
+
+// Impulse response (at the engine sample rate, normalized)
+static float *ir_data[REVERB_MAX_CHANNELS] = {NULL, NULL};
+static int ir_channels = 0;
+static int ir_length = 0;
+static int reverb_enabled = 0;
+
+// Partitioning for the current block size
+static int block_size = 0;          // Partition length B (one JACK period)
+static int fft_size = 0;            // 2B
+static int bin_stride = 0;          // B + 1 bins, padded so every spectrum stays vector aligned
+static int partitions = 0;          // IR partitions P
+static int fdl_slots = 0;           // Input spectra kept (P plus slack for a late worker)
+
+static fftwf_plan forward_plan = NULL;
+static fftwf_plan inverse_plan = NULL;
+static fftwf_complex *ir_spectra = NULL;        // [channel][partition][bin]
+static fftwf_complex *fdl = NULL;               // Frequency-domain delay line [slot][bin]
+static fftwf_complex *tail[2] = {NULL, NULL};   // Worker output by block parity [channel][bin]
+static fftwf_complex *accum = NULL;             // Audio thread scratch spectrum
+static float *input_time = NULL;                // Previous and current input block (2B)
+static float *output_time = NULL;               // Inverse transform output (2B)
+
+// Audio thread -> worker handoff (block numbers start at 1, 0 = none)
+static unsigned long block_index = 0;   // Audio thread only
+static unsigned long input_seq = 0;     // Newest block whose spectrum is in the FDL
+static unsigned long tail_seq = 0;      // Block the finished tail belongs to
+static unsigned long worker_done = 0;   // Newest input block the worker has used
+static int silent_blocks = 0;           // Blocks since the send last carried audio
+static unsigned long late_tails = 0;
+static int offline = 0;                 // Tail computed inline by the caller (offline rendering)
+
+// DSP worker thread
+static pthread_t worker_thread;
+static int worker_running = 0;
+static sem_t worker_sem;
+static pthread_mutex_t worker_mutex = PTHREAD_MUTEX_INITIALIZER;  // Never taken by the audio thread
+
+// acc += x * h over 'count' complex bins (count even), two bins per vector
+static void spectrum_mac(fftwf_complex *acc, const fftwf_complex *x, const fftwf_complex *h, int count) {
+    const v4sf sign = { -1.0f, 1.0f, -1.0f, 1.0f };
+    float *a = (float*)acc;
+    const float *xp = (const float*)x;
+    const float *hp = (const float*)h;
+    
+    for (int i = 0; i < count * 2; i += 4) {
+        v4sf xv = v4sf_load(xp + i);
+        v4sf hv = v4sf_load(hp + i);
+        v4sf h_re = __builtin_shuffle(hv, (v4si){ 0, 0, 2, 2 });
+        v4sf h_im = __builtin_shuffle(hv, (v4si){ 1, 1, 3, 3 });
+        v4sf x_swap = __builtin_shuffle(xv, (v4si){ 1, 0, 3, 2 });
+        v4sf_store(a + i, v4sf_load(a + i) + xv * h_re + x_swap * h_im * sign);
+    }
+}
+
+// Sum of partitions 1..P-1 for block 'block' (worker thread with worker_mutex held, or offline)
+static void compute_tail(unsigned long block) {
+    for (int c = 0; c < ir_channels; c++) {
+        fftwf_complex *acc = tail[block % 2] + c * bin_stride;
+        memset(acc, 0, bin_stride * sizeof(fftwf_complex));
+        
+        // Blocks before the first one are silence
+        for (int p = 1; p < partitions && (unsigned long)p < block; p++) {
+            const fftwf_complex *x = fdl + ((block - p) % fdl_slots) * bin_stride;
+            const fftwf_complex *h = ir_spectra + (c * partitions + p) * bin_stride;
+            spectrum_mac(acc, x, h, bin_stride);
+        }
+    }
+}
+
+// DSP worker: computes the next block's tail as soon as an input block is published
+static void* worker_func(void *arg) {
+    (void)arg;
+    rt_setup_thread(RT_THREAD_DSP);
+    
+    while (1) {
+        sem_wait(&worker_sem);
+        
+        // If we fell behind, only the newest block is still worth computing
+        while (sem_trywait(&worker_sem) == 0) {
+        }
+        if (!__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        
+        pthread_mutex_lock(&worker_mutex);
+        unsigned long block = __atomic_load_n(&input_seq, __ATOMIC_ACQUIRE);
+        if (block != 0 && block != worker_done) {
+            compute_tail(block + 1);
+            __atomic_store_n(&tail_seq, block + 1, __ATOMIC_RELEASE);
+            worker_done = block;
+        }
+        pthread_mutex_unlock(&worker_mutex);
+    }
+    
+    return NULL;
+}
+
+// Free everything that depends on the block size
+static void free_partitions(void) {
+    if (forward_plan) fftwf_destroy_plan(forward_plan);
+    if (inverse_plan) fftwf_destroy_plan(inverse_plan);
+    forward_plan = NULL;
+    inverse_plan = NULL;
+    
+    fftwf_free(ir_spectra);
+    fftwf_free(fdl);
+    fftwf_free(tail[0]);
+    fftwf_free(tail[1]);
+    fftwf_free(accum);
+    fftwf_free(input_time);
+    fftwf_free(output_time);
+    ir_spectra = NULL;
+    fdl = NULL;
+    tail[0] = tail[1] = NULL;
+    accum = NULL;
+    input_time = NULL;
+    output_time = NULL;
+    
+    block_size = 0;
+    partitions = 0;
+}
+
+// Allocate, zero and pre-touch an FFTW buffer
+static void* alloc_zeroed(size_t bytes) {
+    void *p = fftwf_malloc(bytes);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+// Split the IR into partitions of 'size' frames and transform them
+static int build_partitions(int size) {
+    block_size = size;
+    fft_size = 2 * size;
+    bin_stride = (size + 1 + 3) & ~3;
+    partitions = (ir_length + size - 1) / size;
+    fdl_slots = partitions + 2;
+    
+    ir_spectra = alloc_zeroed((size_t)ir_channels * partitions * bin_stride * sizeof(fftwf_complex));
+    fdl = alloc_zeroed((size_t)fdl_slots * bin_stride * sizeof(fftwf_complex));
+    tail[0] = alloc_zeroed((size_t)ir_channels * bin_stride * sizeof(fftwf_complex));
+    tail[1] = alloc_zeroed((size_t)ir_channels * bin_stride * sizeof(fftwf_complex));
+    accum = alloc_zeroed(bin_stride * sizeof(fftwf_complex));
+    input_time = alloc_zeroed(fft_size * sizeof(float));
+    output_time = alloc_zeroed(fft_size * sizeof(float));
+    
+    if (!ir_spectra || !fdl || !tail[0] || !tail[1] || !accum || !input_time || !output_time) {
+        printf("Error: Cannot allocate reverb buffers (%d partitions)\n", partitions);
+        free_partitions();
+        return -1;
+    }
+    
+    forward_plan = fftwf_plan_dft_r2c_1d(fft_size, input_time, fdl, FFTW_ESTIMATE);
+    inverse_plan = fftwf_plan_dft_c2r_1d(fft_size, accum, output_time, FFTW_ESTIMATE);
+    if (!forward_plan || !inverse_plan) {
+        printf("Error: Cannot create reverb FFT plans\n");
+        free_partitions();
+        return -1;
+    }
+    
+    // Overlap-save: each partition zero-padded to 2B
+    for (int c = 0; c < ir_channels; c++) {
+        for (int p = 0; p < partitions; p++) {
+            int start = p * size;
+            int count = ir_length - start < size ? ir_length - start : size;
+            
+            memset(input_time, 0, fft_size * sizeof(float));
+            memcpy(input_time, ir_data[c] + start, count * sizeof(float));
+            fftwf_execute_dft_r2c(forward_plan, input_time, ir_spectra + (c * partitions + p) * bin_stride);
+        }
+    }
+    memset(input_time, 0, fft_size * sizeof(float));
+    
+    block_index = 0;
+    __atomic_store_n(&input_seq, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&tail_seq, 0, __ATOMIC_RELEASE);
+    worker_done = 0;
+    silent_blocks = partitions + 2;
+    
+    return 0;
+}
+
+// Copy the IR at the engine rate (linear interpolation), truncated and normalized
+static int load_ir(const audio_sample_t *ir, int sample_rate, float max_seconds) {
+    double ratio = (double)ir->sample_rate / sample_rate;
+    int length = (int)(ir->frames / ratio);
+    int max_length = (int)(max_seconds * sample_rate);
+    if (length > max_length) length = max_length;
+    if (length < 1) {
+        printf("Error: Impulse response is empty\n");
+        return -1;
+    }
+    
+    ir_channels = ir->channels > REVERB_MAX_CHANNELS ? REVERB_MAX_CHANNELS : ir->channels;
+    ir_length = length;
+    
+    double energy = 0.0;
+    for (int c = 0; c < ir_channels; c++) {
+        ir_data[c] = malloc(length * sizeof(float));
+        if (!ir_data[c]) {
+            printf("Error: Cannot allocate impulse response\n");
+            return -1;
+        }
+        
+        for (int f = 0; f < length; f++) {
+            double position = f * ratio;
+            int index = (int)position;
+            float frac = (float)(position - index);
+            float a = ir->data[index * ir->channels + c];
+            float b = index + 1 < ir->frames ? ir->data[(index + 1) * ir->channels + c] : 0.0f;
+            ir_data[c][f] = a + (b - a) * frac;
+            energy += (double)ir_data[c][f] * ir_data[c][f];
+        }
+    }
+    
+    // Unit energy per channel, so the return level doesn't depend on the IR's loudness
+    if (energy > 0.0) {
+        float scale = (float)(1.0 / sqrt(energy / ir_channels));
+        for (int c = 0; c < ir_channels; c++) {
+            for (int f = 0; f < length; f++) {
+                ir_data[c][f] *= scale;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+// Load an impulse response and start the worker
+int reverb_init(const audio_sample_t *ir, int sample_rate, int block_size_frames, float max_seconds) {
+    if (reverb_enabled) {
+        reverb_cleanup();
+    }
+    if (!ir || !ir->data || ir->frames <= 0 || sample_rate <= 0 || block_size_frames <= 0) {
+        return -1;
+    }
+    
+    if (load_ir(ir, sample_rate, max_seconds) < 0 || build_partitions(block_size_frames) < 0) {
+        reverb_cleanup();
+        return -1;
+    }
+    
+    sem_init(&worker_sem, 0, 0);
+    __atomic_store_n(&worker_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&worker_thread, NULL, worker_func, NULL) != 0) {
+        printf("Error: Cannot start reverb worker thread\n");
+        worker_running = 0;
+        sem_destroy(&worker_sem);
+        reverb_cleanup();
+        return -1;
+    }
+    
+    reverb_enabled = 1;
+    printf("Reverb: %.2f s impulse response, %d channel(s), %d partitions of %d frames\n",
+           (float)ir_length / sample_rate, ir_channels, partitions, block_size);
+    return 0;
+}
+
+// Repartition for a new JACK period (buffer size callback, audio not running)
+int reverb_set_block_size(int size) {
+    if (!reverb_enabled || size == block_size) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&worker_mutex);
+    free_partitions();
+    int result = build_partitions(size);
+    pthread_mutex_unlock(&worker_mutex);
+    
+    if (result < 0) {
+        reverb_enabled = 0;
+        return -1;
+    }
+    printf("Reverb: repartitioned to %d partitions of %d frames\n", partitions, block_size);
+    return 0;
+}
+
+// Stop the worker and free everything (audio must not be running)
+void reverb_cleanup(void) {
+    if (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&worker_running, 0, __ATOMIC_RELEASE);
+        sem_post(&worker_sem);
+        pthread_join(worker_thread, NULL);
+        sem_destroy(&worker_sem);
+    }
+    
+    reverb_enabled = 0;
+    free_partitions();
+    for (int c = 0; c < REVERB_MAX_CHANNELS; c++) {
+        free(ir_data[c]);
+        ir_data[c] = NULL;
+    }
+    ir_channels = 0;
+    ir_length = 0;
+}
+
+int reverb_is_enabled(void) {
+    return reverb_enabled;
+}
+
+// Offline rendering has no deadline, so every block waits for its full tail
+void reverb_set_offline(int enabled) {
+    offline = enabled;
+}
+
+// Process one block (audio thread)
+void reverb_process(const float *in_left, const float *in_right,
+                    float *out_left, float *out_right, int nframes, float gain) {
+    if (!reverb_enabled || nframes != block_size) {
+        return;
+    }
+    
+    const int size = block_size;
+    unsigned long block = ++block_index;
+    
+    // Mono send: slide the previous block down and append the new one
+    memcpy(input_time, input_time + size, size * sizeof(float));
+    if (in_left && in_right) {
+        for (int f = 0; f < size; f++) {
+            input_time[size + f] = (in_left[f] + in_right[f]) * 0.5f;
+        }
+        silent_blocks = 0;
+    } else {
+        memset(input_time + size, 0, size * sizeof(float));
+        if (silent_blocks <= partitions) {
+            silent_blocks++;
+        }
+    }
+    
+    fftwf_complex *spectrum = fdl + (block % fdl_slots) * bin_stride;
+    fftwf_execute_dft_r2c(forward_plan, input_time, spectrum);
+    
+    // The worker computed this block's tail during the previous period
+    int have_tail = 0;
+    if (partitions > 1 && offline) {
+        compute_tail(block);
+        have_tail = 1;
+    } else if (partitions > 1) {
+        have_tail = __atomic_load_n(&tail_seq, __ATOMIC_ACQUIRE) == block;
+        if (!have_tail && block > 1) {
+            __atomic_add_fetch(&late_tails, 1, __ATOMIC_RELAXED);
+        }
+        
+        // Hand this block to the worker for the next tail (writes the other parity)
+        __atomic_store_n(&input_seq, block, __ATOMIC_RELEASE);
+        sem_post(&worker_sem);
+    }
+    
+    const float scale = gain / (float)fft_size;
+    for (int c = 0; c < ir_channels; c++) {
+        if (have_tail) {
+            memcpy(accum, tail[block % 2] + c * bin_stride, bin_stride * sizeof(fftwf_complex));
+        } else {
+            memset(accum, 0, bin_stride * sizeof(fftwf_complex));
+        }
+        spectrum_mac(accum, spectrum, ir_spectra + c * partitions * bin_stride, bin_stride);
+        
+        // Overlap-save: the second half is the valid output
+        fftwf_execute_dft_c2r(inverse_plan, accum, output_time);
+        dsp_mix(output_time + size, c == 0 ? out_left : out_right, size, scale);
+        if (ir_channels == 1) {
+            dsp_mix(output_time + size, out_right, size, scale);
+        }
+    }
+}
+
+// True once the tail of the last input has fully played out
+int reverb_is_idle(void) {
+    return !reverb_enabled || silent_blocks > partitions;
+}
+
+void reverb_print_stats(void) {
+    if (!reverb_enabled) {
+        return;
+    }
+    printf("  Reverb: %d partitions of %d frames, late worker blocks: %lu\n",
+           partitions, block_size, __atomic_load_n(&late_tails, __ATOMIC_RELAXED));
+}
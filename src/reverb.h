@@ -0,0 +1,36 @@
+#ifndef REVERB_H
+#define REVERB_H
+
+#include "audio_engine.h"
+
+// Impulse responses longer than this are truncated (worker cost grows linearly)
+#define REVERB_DEFAULT_MAX_SECONDS 3.0f
+
+// Output channels of the wet signal (mono IRs feed both)
+#define REVERB_MAX_CHANNELS 2
+
+// Convolution reverb with uniformly partitioned overlap-save FFT convolution
+//
+// The IR is split into partitions of one JACK period. The audio thread
+// transforms each input block, multiplies it with the first partition and
+// adds the tail: the sum over all later partitions, which only depends on
+// earlier blocks and is computed ahead of time by a DSP worker thread.
+// A late worker costs the tail of one block, never an xrun.
+
+// Setup (not real-time safe, JACK must not be processing)
+int reverb_init(const audio_sample_t *ir, int sample_rate, int block_size, float max_seconds);
+int reverb_set_block_size(int block_size);
+void reverb_cleanup(void);
+int reverb_is_enabled(void);
+void reverb_set_offline(int offline);     // Compute the tail inline (deterministic, no worker)
+
+// Real-time functions
+// Adds the wet signal * gain to out_left/out_right; in_left/in_right may be NULL for silence
+void reverb_process(const float *in_left, const float *in_right,
+                    float *out_left, float *out_right, int nframes, float gain);
+int reverb_is_idle(void);
+
+// Statistics
+void reverb_print_stats(void);
+
+#endif // REVERB_H
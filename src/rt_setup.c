@@ -0,0 +1,283 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#include "rt_setup.h"
+#include "config.h"
+
+// One line of the setup report
+typedef struct {
+    char item[40];
+    int applied;
+    char detail[128];
+} rt_report_entry_t;
+
+#define MAX_REPORT_ENTRIES 24
+
+// Internal state
+static rt_config_t rt_config;
+static int base_priority = 0;
+static rt_report_entry_t report[MAX_REPORT_ENTRIES];
+static int report_count = 0;
+static pthread_mutex_t report_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *role_names[RT_THREAD_COUNT] = { "audio", "MIDI", "loader", "DSP", "render" };
+
+// Record the outcome of one setup step (called from several threads)
+static void report_result(const char *item, int applied, const char *detail) {
+    pthread_mutex_lock(&report_mutex);
+    
+    // Replace an earlier result for the same item (e.g. JACK restarting its thread)
+    int index = report_count;
+    for (int i = 0; i < report_count; i++) {
+        if (strcmp(report[i].item, item) == 0) {
+            index = i;
+            break;
+        }
+    }
+    
+    if (index < MAX_REPORT_ENTRIES) {
+        snprintf(report[index].item, sizeof(report[index].item), "%s", item);
+        snprintf(report[index].detail, sizeof(report[index].detail), "%s", detail);
+        report[index].applied = applied;
+        if (index == report_count) {
+            report_count++;
+        }
+    }
+    
+    pthread_mutex_unlock(&report_mutex);
+}
+
+// Default configuration
+rt_config_t rt_setup_get_default_config(void) {
+    rt_config_t config = {
+        .process_priority = 70,
+        .lock_memory = 1,
+        .disable_swap = 0,
+        .cpu_governor = "",
+        .cpu = { -1, -1, -1, -1, -1 }
+    };
+    return config;
+}
+
+// Load the [PERFORMANCE] section
+void rt_setup_load_config(rt_config_t *config) {
+    config->process_priority = config_get_int("PERFORMANCE", "process_priority", config->process_priority);
+    config->lock_memory = config_get_bool("PERFORMANCE", "lock_memory", config->lock_memory);
+    config->disable_swap = config_get_bool("PERFORMANCE", "disable_swap", config->disable_swap);
+    snprintf(config->cpu_governor, sizeof(config->cpu_governor), "%s",
+             config_get_string("PERFORMANCE", "cpu_governor", config->cpu_governor));
+    config->cpu[RT_THREAD_AUDIO] = config_get_int("PERFORMANCE", "audio_cpu", config->cpu[RT_THREAD_AUDIO]);
+    config->cpu[RT_THREAD_MIDI] = config_get_int("PERFORMANCE", "midi_cpu", config->cpu[RT_THREAD_MIDI]);
+    config->cpu[RT_THREAD_LOADER] = config_get_int("PERFORMANCE", "loader_cpu", config->cpu[RT_THREAD_LOADER]);
+    config->cpu[RT_THREAD_DSP] = config_get_int("PERFORMANCE", "dsp_cpu", config->cpu[RT_THREAD_DSP]);
+}
+
+// Write the CPU frequency governor for every core (needs root or udev rules)
+static void apply_cpu_governor(const char *governor) {
+    char path[128];
+    char detail[128];
+    int cpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+    int failed = 0;
+    int first_errno = 0;
+    
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+        FILE *file = fopen(path, "w");
+        int ok = file != NULL;
+        if (file) {
+            ok = fprintf(file, "%s\n", governor) > 0;
+            ok = (fclose(file) == 0) && ok;
+        }
+        
+        if (!ok) {
+            if (!failed) {
+                first_errno = errno;
+            }
+            failed++;
+        }
+    }
+    
+    if (failed) {
+        snprintf(detail, sizeof(detail), "'%s' on %d/%d cores failed: %s", governor,
+                 failed, cpus, strerror(first_errno));
+        report_result("CPU governor", 0, detail);
+    } else {
+        snprintf(detail, sizeof(detail), "'%s' on %d cores", governor, cpus);
+        report_result("CPU governor", 1, detail);
+    }
+}
+
+// Process-wide setup
+int rt_setup_init(const rt_config_t *config) {
+    char detail[128];
+    
+    rt_config = config ? *config : rt_setup_get_default_config();
+    base_priority = rt_config.process_priority;
+    
+    if (rt_config.lock_memory) {
+        // Keep freed memory in the heap so later allocations never fault pages in
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+        
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            report_result("Memory lock", 1, "mlockall current and future pages");
+        } else {
+            snprintf(detail, sizeof(detail), "mlockall failed: %s (check LimitMEMLOCK)", strerror(errno));
+            report_result("Memory lock", 0, detail);
+        }
+    } else {
+        report_result("Memory lock", 0, "disabled in config");
+    }
+    
+    if (rt_config.cpu_governor[0]) {
+        apply_cpu_governor(rt_config.cpu_governor);
+    }
+    
+    if (rt_config.disable_swap) {
+        report_result("Disable swap", 0, "system setting, run 'sudo dphys-swapfile swapoff'");
+    }
+    
+    return 0;
+}
+
+// Base priority from JACK's process thread
+void rt_setup_set_jack_priority(int jack_priority) {
+    char detail[128];
+    
+    if (jack_priority > 0) {
+        base_priority = jack_priority;
+        snprintf(detail, sizeof(detail), "JACK process thread at SCHED_FIFO %d", jack_priority);
+        report_result("Base priority", 1, detail);
+    } else {
+        base_priority = rt_config.process_priority;
+        snprintf(detail, sizeof(detail), "JACK not realtime, using process_priority %d", base_priority);
+        report_result("Base priority", 0, detail);
+    }
+}
+
+// Enable flush-to-zero / denormals-are-zero for the calling thread
+static int enable_flush_to_zero(void) {
+#if defined(__SSE__)
+    _mm_setcsr(_mm_getcsr() | 0x8040);  // FTZ | DAZ
+    return 0;
+#elif defined(__aarch64__)
+    unsigned long fpcr;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= (1UL << 24);                 // FZ
+    __asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+    return 0;
+#elif defined(__arm__) && defined(__ARM_FP)
+    unsigned int fpscr;
+    __asm__ volatile("vmrs %0, fpscr" : "=r"(fpscr));
+    fpscr |= (1U << 24);                 // FZ (also makes NEON flush denormals)
+    __asm__ volatile("vmsr fpscr, %0" : : "r"(fpscr));
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+// Touch the stack so its pages are resident (and locked with mlockall)
+static void __attribute__((noinline)) prefault_stack(void) {
+    volatile unsigned char stack[RT_STACK_PREFAULT_BYTES];
+    for (size_t i = 0; i < sizeof(stack); i += 1024) {
+        stack[i] = 0;
+    }
+}
+
+// Per-thread setup for the calling thread
+int rt_setup_thread(rt_thread_role_t role) {
+    char item[40];
+    char detail[128];
+    int failures = 0;
+    const char *name = role_names[role];
+    
+    // Priority (JACK owns the audio thread's priority)
+    if (role != RT_THREAD_AUDIO) {
+        int offset = role == RT_THREAD_RENDER ? RT_RENDER_PRIORITY_OFFSET :
+                     role == RT_THREAD_MIDI ? RT_MIDI_PRIORITY_OFFSET :
+                     role == RT_THREAD_DSP ? RT_DSP_PRIORITY_OFFSET : RT_LOADER_PRIORITY_OFFSET;
+        int priority = base_priority - offset;
+        if (priority < 1) priority = 1;
+        if (priority > 99) priority = 99;
+        
+        struct sched_param param = { .sched_priority = priority };
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        snprintf(item, sizeof(item), "%s thread priority", name);
+        if (err == 0) {
+            snprintf(detail, sizeof(detail), "SCHED_FIFO %d", priority);
+            report_result(item, 1, detail);
+        } else {
+            snprintf(detail, sizeof(detail), "SCHED_FIFO %d failed: %s (check LimitRTPRIO)",
+                     priority, strerror(err));
+            report_result(item, 0, detail);
+            failures++;
+        }
+    }
+    
+    // CPU affinity
+    int cpu = rt_config.cpu[role];
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        snprintf(item, sizeof(item), "%s thread affinity", name);
+        if (err == 0) {
+            snprintf(detail, sizeof(detail), "pinned to CPU %d", cpu);
+            report_result(item, 1, detail);
+        } else {
+            snprintf(detail, sizeof(detail), "CPU %d failed: %s", cpu, strerror(err));
+            report_result(item, 0, detail);
+            failures++;
+        }
+    }
+    
+    // Denormals are only a concern where DSP runs
+    if (role != RT_THREAD_MIDI) {
+        snprintf(item, sizeof(item), "%s thread denormals", name);
+        if (enable_flush_to_zero() == 0) {
+            report_result(item, 1, "flush-to-zero enabled");
+        } else {
+            report_result(item, 0, "not supported on this CPU");
+            failures++;
+        }
+    }
+    
+    prefault_stack();
+    
+    return failures ? -1 : 0;
+}
+
+// JACK thread init callback for the audio thread
+void rt_setup_audio_thread_init(void *arg) {
+    (void)arg;
+    rt_setup_thread(RT_THREAD_AUDIO);
+}
+
+// Print what could and couldn't be applied
+void rt_setup_report(void) {
+    pthread_mutex_lock(&report_mutex);
+    
+    printf("Real-time setup:\n");
+    for (int i = 0; i < report_count; i++) {
+        printf("  [%s] %-26s %s\n", report[i].applied ? " OK " : "FAIL",
+               report[i].item, report[i].detail);
+    }
+    if (report_count == 0) {
+        printf("  Nothing applied\n");
+    }
+    
+    pthread_mutex_unlock(&report_mutex);
+}
@@ -0,0 +1,51 @@
+#ifndef RT_SETUP_H
+#define RT_SETUP_H
+
+// Threads that get real-time treatment
+typedef enum {
+    RT_THREAD_AUDIO,    // JACK process thread (priority is set by JACK)
+    RT_THREAD_MIDI,     // MIDI input thread
+    RT_THREAD_LOADER,   // Background sample loading
+    RT_THREAD_DSP,      // DSP work offloaded from the audio thread (deadline of one period)
+    RT_THREAD_RENDER,   // Voice rendering helpers (deadline within the current period, never pinned)
+    RT_THREAD_COUNT
+} rt_thread_role_t;
+
+// Real-time configuration ([PERFORMANCE] section)
+typedef struct {
+    int process_priority;       // Base priority if JACK is not running realtime (1-99)
+    int lock_memory;            // mlockall() all current and future memory
+    int disable_swap;           // Requested swap off (system setting, only reported)
+    char cpu_governor[32];      // CPU frequency governor ("" to leave unchanged)
+    int cpu[RT_THREAD_COUNT];   // CPU core per thread role (-1 = no pinning)
+} rt_config_t;
+
+// Priorities below JACK's process thread for our own threads
+#define RT_RENDER_PRIORITY_OFFSET 1
+#define RT_MIDI_PRIORITY_OFFSET 5
+#define RT_DSP_PRIORITY_OFFSET 10
+#define RT_LOADER_PRIORITY_OFFSET 20
+
+// Stack touched on thread setup so the first deep call doesn't page fault
+#define RT_STACK_PREFAULT_BYTES (64 * 1024)
+
+// Configuration
+rt_config_t rt_setup_get_default_config(void);
+void rt_setup_load_config(rt_config_t *config);
+
+// Process-wide setup (memory locking, malloc tuning, CPU governor)
+int rt_setup_init(const rt_config_t *config);
+
+// Base priority: JACK's RT priority if known, else config process_priority
+void rt_setup_set_jack_priority(int jack_priority);
+
+// Per-thread setup for the calling thread (priority, affinity, denormals, stack)
+int rt_setup_thread(rt_thread_role_t role);
+
+// JACK thread init callback for the audio thread
+void rt_setup_audio_thread_init(void *arg);
+
+// Print what could and couldn't be applied
+void rt_setup_report(void);
+
+#endif // RT_SETUP_H
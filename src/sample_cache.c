@@ -0,0 +1,376 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sample_cache.h"
+
+// Longest wait for the audio thread to finish a block before an eviction is undone
+#define SAMPLE_CACHE_BLOCK_WAIT_MS 500
+
+typedef struct {
+    audio_sample_t *sample;     // NULL = free slot
+    char path[512];
+    size_t mapped_bytes;        // Whole mapping (page multiple)
+    size_t head_bytes;          // Kept when the tail is evicted (page multiple)
+    size_t resident;            // Bytes of the mapping in RAM now
+    size_t mip_bytes;           // Mip levels built for it (malloc'd, outside the mapping)
+    long long file_size;        // Source file state at load; a changed file is not reloaded
+    long long file_mtime;
+    unsigned long evicted_at;   // Engine frame count at eviction
+    int failed;                 // Reload failed; stays partly evicted
+    int busy;                   // Worker is evicting or reloading it without the mutex
+    int removing;               // Being freed; a reload in progress stops early
+} cache_entry_t;
+
+// Entries are claimed and released under the mutex (never taken by the audio
+// thread); the worker drops it while an entry it marked busy is evicted or
+// reloaded. The counters below are also read without it for stats
+static cache_entry_t entries[SAMPLE_CACHE_MAX_SAMPLES];
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t cache_budget = 0;
+static int cache_head_ms = SAMPLE_CACHE_DEFAULT_HEAD_MS;
+static sample_cache_read_t cache_read = NULL;
+static size_t page_size = 4096;
+
+static size_t resident_bytes = 0;
+static size_t mip_bytes = 0;
+static int sample_total = 0;
+static int evicted_total = 0;
+static unsigned long evictions = 0;
+static unsigned long reloads = 0;
+
+static pthread_t worker_thread;
+static int worker_running = 0;
+static int cache_initialized = 0;
+
+static size_t page_round(size_t bytes) {
+    return (bytes + page_size - 1) / page_size * page_size;
+}
+
+static size_t frame_bytes(const audio_sample_t *sample) {
+    return (size_t)sample->channels * sizeof(float);
+}
+
+// Wait until the block running now (if any) has finished; 0 if the engine didn't advance in time
+static int wait_for_block_boundary(void) {
+    unsigned long frames = audio_engine_get_frames_processed();
+    for (int waited = 0; waited < SAMPLE_CACHE_BLOCK_WAIT_MS; waited++) {
+        if (audio_engine_get_frames_processed() != frames) {
+            return 1;
+        }
+        usleep(1000);
+    }
+    return 0;
+}
+
+// Drop the tail of an idle sample, keeping the head locked
+static int evict(cache_entry_t *entry) {
+    audio_sample_t *sample = entry->sample;
+    unsigned long used = __atomic_load_n(&sample->last_used, __ATOMIC_RELAXED);
+    
+    __atomic_store_n(&sample->evicted_frame, (int)(entry->head_bytes / frame_bytes(sample)), __ATOMIC_RELEASE);
+    
+    // Voices read past the head only in blocks that started before the store; a note
+    // that started meanwhile is left alone
+    if (!wait_for_block_boundary() || __atomic_load_n(&sample->last_used, __ATOMIC_RELAXED) != used) {
+        __atomic_store_n(&sample->evicted_frame, 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+    
+    char *tail = (char*)sample->data + entry->head_bytes;
+    size_t tail_bytes = entry->mapped_bytes - entry->head_bytes;
+    munlock(tail, tail_bytes);
+    madvise(tail, tail_bytes, MADV_DONTNEED);
+    
+    entry->resident = entry->head_bytes;
+    entry->evicted_at = audio_engine_get_frames_processed();
+    entry->failed = 0;
+    __atomic_sub_fetch(&resident_bytes, tail_bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&evicted_total, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&evictions, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// Read the tail back from the file a chunk at a time; each chunk is published as soon as
+// it lands, so a voice started on the head keeps finding its next frames resident
+static void reload(cache_entry_t *entry) {
+    audio_sample_t *sample = entry->sample;
+    int restored = __atomic_load_n(&sample->evicted_frame, __ATOMIC_RELAXED);
+    int chunk = sample->sample_rate * SAMPLE_CACHE_RELOAD_CHUNK_MS / 1000;
+    if (chunk < 1) chunk = 1;
+    
+    struct stat st;
+    int unchanged = stat(entry->path, &st) == 0 && (long long)st.st_size == entry->file_size &&
+                    (long long)st.st_mtime == entry->file_mtime;
+    
+    char *tail = (char*)sample->data + entry->head_bytes;
+    mlock(tail, entry->mapped_bytes - entry->head_bytes);
+    while (unchanged && restored < sample->frames && !__atomic_load_n(&entry->removing, __ATOMIC_RELAXED)) {
+        int frames = sample->frames - restored < chunk ? sample->frames - restored : chunk;
+        if (cache_read(entry->path, sample->file_offset + restored, sample->channels,
+                       sample->data + (size_t)restored * sample->channels, frames) < 0) {
+            break;
+        }
+        restored += frames;
+        __atomic_store_n(&sample->evicted_frame, restored < sample->frames ? restored : 0, __ATOMIC_RELEASE);
+    }
+    
+    size_t resident = entry->mapped_bytes;
+    if (restored < sample->frames) {
+        if (!__atomic_load_n(&entry->removing, __ATOMIC_RELAXED)) {
+            printf("Warning: Sample cache cannot reload '%s' (missing or changed), playing its first %.1f s only\n",
+                   entry->path, (float)restored / sample->sample_rate);
+        }
+        entry->failed = 1;
+        
+        // Voices never read past evicted_frame, so the pages after it go again
+        resident = page_round((size_t)restored * frame_bytes(sample));
+        munlock((char*)sample->data + resident, entry->mapped_bytes - resident);
+        madvise((char*)sample->data + resident, entry->mapped_bytes - resident, MADV_DONTNEED);
+    } else {
+        __atomic_sub_fetch(&evicted_total, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&reloads, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&resident_bytes, resident - entry->resident, __ATOMIC_RELAXED);
+    entry->resident = resident;
+}
+
+// Least recently played sample that can give up its tail, or NULL
+static cache_entry_t* eviction_candidate(unsigned long now) {
+    cache_entry_t *oldest = NULL;
+    for (int i = 0; i < SAMPLE_CACHE_MAX_SAMPLES; i++) {
+        cache_entry_t *entry = &entries[i];
+        audio_sample_t *sample = entry->sample;
+        if (!sample || entry->removing || entry->head_bytes >= entry->mapped_bytes ||
+            __atomic_load_n(&sample->evicted_frame, __ATOMIC_RELAXED) > 0 ||
+            __atomic_load_n(&sample->mip_building, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        
+        unsigned long used = __atomic_load_n(&sample->last_used, __ATOMIC_RELAXED);
+        unsigned long idle_frames = (unsigned long)sample->sample_rate * SAMPLE_CACHE_IDLE_MS / 1000;
+        if (used != 0 && now - used < idle_frames) {
+            continue;
+        }
+        if (!oldest || used < __atomic_load_n(&oldest->sample->last_used, __ATOMIC_RELAXED)) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+static void* worker_func(void *arg) {
+    (void)arg;
+    unsigned long last_frames = audio_engine_get_frames_processed();
+    
+    while (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&cache_mutex);
+        
+        // Played since its eviction: bring the tail back
+        for (int i = 0; i < SAMPLE_CACHE_MAX_SAMPLES; i++) {
+            cache_entry_t *entry = &entries[i];
+            if (entry->sample && !entry->failed &&
+                __atomic_load_n(&entry->sample->evicted_frame, __ATOMIC_ACQUIRE) > 0 &&
+                __atomic_load_n(&entry->sample->last_used, __ATOMIC_RELAXED) >= entry->evicted_at) {
+                entry->busy = 1;
+                pthread_mutex_unlock(&cache_mutex);
+                reload(entry);
+                pthread_mutex_lock(&cache_mutex);
+                entry->busy = 0;
+            }
+        }
+        
+        // Evicting needs block boundaries, so wait while the engine isn't running
+        // (before activation, or in a process that never renders)
+        unsigned long now = audio_engine_get_frames_processed();
+        int engine_running = now != last_frames;
+        last_frames = now;
+        
+        while (engine_running && __atomic_load_n(&resident_bytes, __ATOMIC_RELAXED) > cache_budget) {
+            cache_entry_t *entry = eviction_candidate(audio_engine_get_frames_processed());
+            if (!entry) {
+                break;
+            }
+            entry->busy = 1;
+            pthread_mutex_unlock(&cache_mutex);
+            int result = evict(entry);
+            pthread_mutex_lock(&cache_mutex);
+            entry->busy = 0;
+            if (result < 0) {
+                break;
+            }
+        }
+        
+        pthread_mutex_unlock(&cache_mutex);
+        usleep(SAMPLE_CACHE_POLL_MS * 1000);
+    }
+    
+    return NULL;
+}
+
+// Start the worker (does nothing with a budget of 0)
+int sample_cache_init(size_t budget_bytes, int head_ms, sample_cache_read_t reader) {
+    if (cache_initialized || budget_bytes == 0) {
+        return 0;
+    }
+    if (!reader) {
+        return -1;
+    }
+    
+    long page = sysconf(_SC_PAGESIZE);
+    page_size = page > 0 ? (size_t)page : 4096;
+    cache_budget = budget_bytes;
+    cache_head_ms = head_ms > 0 ? head_ms : SAMPLE_CACHE_DEFAULT_HEAD_MS;
+    cache_read = reader;
+    resident_bytes = 0;
+    mip_bytes = 0;
+    sample_total = 0;
+    evicted_total = 0;
+    evictions = 0;
+    reloads = 0;
+    memset(entries, 0, sizeof(entries));
+    
+    __atomic_store_n(&worker_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&worker_thread, NULL, worker_func, NULL) != 0) {
+        printf("Error: Cannot start sample cache thread\n");
+        worker_running = 0;
+        return -1;
+    }
+    
+    cache_initialized = 1;
+    printf("Sample cache: %zu MB budget, %d ms heads kept resident\n", budget_bytes >> 20, cache_head_ms);
+    return 0;
+}
+
+// Stop the worker; samples still registered keep their mappings until freed
+void sample_cache_cleanup(void) {
+    if (!cache_initialized) {
+        return;
+    }
+    __atomic_store_n(&worker_running, 0, __ATOMIC_RELEASE);
+    pthread_join(worker_thread, NULL);
+    cache_initialized = 0;
+}
+
+int sample_cache_add(audio_sample_t *sample, const char *filepath) {
+    if (!cache_initialized || sample->pooled || sample->cached || sample->frames <= 0) {
+        return -1;
+    }
+    
+    struct stat st;
+    if (stat(filepath, &st) != 0) {
+        return -1;
+    }
+    
+    // Sustain loops stay resident: looped voices play them until the release ends
+    size_t data_bytes = (size_t)sample->frames * frame_bytes(sample);
+    size_t mapped_bytes = page_round(data_bytes);
+    size_t head_frames = (size_t)cache_head_ms * sample->sample_rate / 1000;
+    if ((size_t)sample->loop_end > head_frames) {
+        head_frames = (size_t)sample->loop_end;
+    }
+    size_t head_bytes = page_round(head_frames * frame_bytes(sample));
+    
+    pthread_mutex_lock(&cache_mutex);
+    cache_entry_t *entry = NULL;
+    for (int i = 0; i < SAMPLE_CACHE_MAX_SAMPLES && !entry; i++) {
+        if (!entries[i].sample) {
+            entry = &entries[i];
+        }
+    }
+    if (!entry) {
+        pthread_mutex_unlock(&cache_mutex);
+        printf("Warning: Sample cache full, '%s' stays outside the budget\n", filepath);
+        return -1;
+    }
+    
+    void *data = mmap(NULL, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        pthread_mutex_unlock(&cache_mutex);
+        printf("Warning: Cannot map %zu bytes for '%s', it stays outside the budget\n", mapped_bytes, filepath);
+        return -1;
+    }
+    memcpy(data, sample->data, data_bytes);
+    mlock(data, mapped_bytes);
+    free(sample->data);
+    
+    sample->data = data;
+    sample->cached = 1;
+    sample->evicted_frame = 0;
+    sample->last_used = 0;
+    
+    memset(entry, 0, sizeof(*entry));
+    entry->sample = sample;
+    snprintf(entry->path, sizeof(entry->path), "%s", filepath);
+    entry->mapped_bytes = mapped_bytes;
+    entry->head_bytes = head_bytes < mapped_bytes ? head_bytes : mapped_bytes;
+    entry->resident = mapped_bytes;
+    entry->file_size = (long long)st.st_size;
+    entry->file_mtime = (long long)st.st_mtime;
+    __atomic_add_fetch(&resident_bytes, mapped_bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sample_total, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&cache_mutex);
+    return 0;
+}
+
+void sample_cache_add_mip_level(audio_sample_t *sample, size_t bytes) {
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < SAMPLE_CACHE_MAX_SAMPLES; i++) {
+        if (entries[i].sample == sample) {
+            entries[i].mip_bytes += bytes;
+            __atomic_add_fetch(&resident_bytes, bytes, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&mip_bytes, bytes, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void sample_cache_remove(audio_sample_t *sample) {
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < SAMPLE_CACHE_MAX_SAMPLES; i++) {
+        cache_entry_t *entry = &entries[i];
+        if (entry->sample != sample) {
+            continue;
+        }
+        
+        // Let the worker finish with it first (a reload stops at its next chunk)
+        __atomic_store_n(&entry->removing, 1, __ATOMIC_RELAXED);
+        while (entry->busy) {
+            pthread_mutex_unlock(&cache_mutex);
+            usleep(1000);
+            pthread_mutex_lock(&cache_mutex);
+        }
+        
+        if (__atomic_load_n(&sample->evicted_frame, __ATOMIC_RELAXED) > 0) {
+            __atomic_sub_fetch(&evicted_total, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_sub_fetch(&resident_bytes, entry->resident + entry->mip_bytes, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&mip_bytes, entry->mip_bytes, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&sample_total, 1, __ATOMIC_RELAXED);
+        munmap(sample->data, entry->mapped_bytes);
+        sample->data = NULL;
+        entry->sample = NULL;
+        break;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+int sample_cache_is_enabled(void) {
+    return cache_initialized;
+}
+
+// Counters only, so a reload in progress never holds up a telemetry request
+void sample_cache_get_stats(sample_cache_stats_t *stats) {
+    stats->budget_bytes = cache_initialized ? cache_budget : 0;
+    stats->resident_bytes = __atomic_load_n(&resident_bytes, __ATOMIC_RELAXED);
+    stats->mip_bytes = __atomic_load_n(&mip_bytes, __ATOMIC_RELAXED);
+    stats->samples = __atomic_load_n(&sample_total, __ATOMIC_RELAXED);
+    stats->evicted_samples = __atomic_load_n(&evicted_total, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&evictions, __ATOMIC_RELAXED);
+    stats->reloads = __atomic_load_n(&reloads, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,71 @@
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include <stddef.h>
+#include "audio_engine.h"
+
+// Sample memory cap ([SAMPLES] memory_budget_mb, 0 = unlimited and no cache)
+#define SAMPLE_CACHE_DEFAULT_BUDGET_MB 0
+
+// Attack kept resident when a sample's tail is evicted ([SAMPLES] resident_head_ms)
+#define SAMPLE_CACHE_DEFAULT_HEAD_MS 250
+
+// Only samples no voice has played for this long are evicted
+#define SAMPLE_CACHE_IDLE_MS 2000
+
+#define SAMPLE_CACHE_MAX_SAMPLES 256
+
+// Worker thread polling interval (the audio thread never signals it)
+#define SAMPLE_CACHE_POLL_MS 20
+
+// Evicted tails are read back in chunks this long, each published as it lands
+#define SAMPLE_CACHE_RELOAD_CHUNK_MS 50
+
+// Reads 'frames' frames of a sample's file from 'first_frame' on, exactly as they were
+// decoded at load (0 on success); the cache adds the sample's file_offset
+typedef int (*sample_cache_read_t)(const char *filepath, int first_frame, int channels, float *dest, int frames);
+
+typedef struct {
+    size_t budget_bytes;        // 0 = unlimited
+    size_t resident_bytes;      // Sample data currently in RAM, mip levels included
+    size_t mip_bytes;           // Of that, mip levels (never evicted)
+    int samples;                // Samples under the cache's control
+    int evicted_samples;        // Of those, samples with only their head resident
+    unsigned long evictions;
+    unsigned long reloads;
+} sample_cache_stats_t;
+
+// Sample memory budget
+//
+// Samples decoded from files move into page-aligned mappings that the cache
+// owns. While the total exceeds the budget, a normal-priority worker evicts
+// the tails of the samples played least recently, keeping a short attack
+// head (and any sustain loop) locked in RAM: it publishes the sample's
+// evicted_frame, waits for the audio thread to finish the block in progress,
+// then unlocks and drops the tail pages. Voices never read past
+// evicted_frame and fade out just before it. A note-on of an evicted sample
+// plays the head right away and counts a miss; the worker sees the new use
+// and reads the tail back from the file, moving evicted_frame forward after
+// each chunk so the voice keeps finding its next frames resident.
+// Mip levels of cached samples count against the budget too, but stay
+// resident; the tails give way for them.
+// Samples in the shared pool are sized by pool_mb and stay outside the budget.
+
+// Setup (not real-time safe)
+int sample_cache_init(size_t budget_bytes, int head_ms, sample_cache_read_t reader);
+void sample_cache_cleanup(void);
+
+// Take over a freshly decoded private sample (moves its data into a cache mapping)
+int sample_cache_add(audio_sample_t *sample, const char *filepath);
+
+// Count a mip level built for a cached sample against the budget
+void sample_cache_add_mip_level(audio_sample_t *sample, size_t bytes);
+
+// Forget a sample and unmap its data (called by audio_sample_free)
+void sample_cache_remove(audio_sample_t *sample);
+
+// Status
+int sample_cache_is_enabled(void);
+void sample_cache_get_stats(sample_cache_stats_t *stats);
+
+#endif // SAMPLE_CACHE_H
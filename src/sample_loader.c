@@ -4,8 +4,15 @@
 #include <string.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <sndfile.h>
 #include "sample_loader.h"
+#include "sample_pool.h"
+#include "sample_cache.h"
+#include "config.h"
+#include "trace.h"
 
 // Internal state
 static char samples_directory[512] = "";
@@ -13,6 +20,7 @@ static audio_sample_t *first_sample = NULL;
 static char first_sample_name[256] = "";
 static int sample_count = 0;
 static int loader_initialized = 0;
+static int mip_builds_running = 0;
 
 // Helper function to check if file is a WAV file
 static int is_wav_file(const char *filename) {
@@ -23,8 +31,340 @@ static int is_wav_file(const char *filename) {
     return (strcasecmp(ext, ".wav") == 0);
 }
 
-// Load a WAV file into memory
-static audio_sample_t* load_wav_file(const char *filepath) {
+// Read the first forward loop of the smpl chunk, if any
+static void read_loop_points(SNDFILE *file, audio_sample_t *sample) {
+    SF_INSTRUMENT instrument;
+    
+    sample->loop_start = 0;
+    sample->loop_end = 0;
+    
+    memset(&instrument, 0, sizeof(instrument));
+    if (sf_command(file, SFC_GET_INSTRUMENT, &instrument, sizeof(instrument)) != SF_TRUE) {
+        return;
+    }
+    
+    for (int i = 0; i < instrument.loop_count && i < 16; i++) {
+        // Backward and alternating loops are played forward
+        if (instrument.loops[i].mode == SF_LOOP_NONE) {
+            continue;
+        }
+        
+        // smpl loop ends are inclusive
+        int start = (int)instrument.loops[i].start;
+        int end = (int)instrument.loops[i].end + 1;
+        if (start >= 0 && end > start + 1 && end <= sample->frames) {
+            sample->loop_start = start;
+            sample->loop_end = end;
+            return;
+        }
+    }
+}
+
+// Blend the frames before the loop end with the frames before the loop start,
+// so jumping from loop_end back to loop_start continues seamlessly
+// Equal-power weights suit the uncorrelated material of pads and organs
+// Returns the crossfade length actually applied, in frames
+static int crossfade_loop(audio_sample_t *sample, int crossfade_frames) {
+    int channels = sample->channels;
+    int length = crossfade_frames;
+    if (length > (sample->loop_end - sample->loop_start) / 2) length = (sample->loop_end - sample->loop_start) / 2;
+    if (length <= 0) {
+        return 0;
+    }
+    
+    // A loop starting at the first frame has nothing before it, but the frames
+    // after loop_end can fade into the loop head instead (the attack then opens
+    // on the same blend, which is short enough to pass as part of it)
+    if (sample->loop_start == 0 && sample->frames - sample->loop_end >= length) {
+        for (int i = 0; i < length; i++) {
+            float t = (float)(i + 1) / (float)(length + 1);
+            float fade_out = cosf(t * (float)M_PI_2);
+            float fade_in = sinf(t * (float)M_PI_2);
+            int head = sample->loop_start + i;
+            int after = sample->loop_end + i;
+            
+            for (int c = 0; c < channels; c++) {
+                float *dst = &sample->data[head * channels + c];
+                *dst = sample->data[after * channels + c] * fade_out + *dst * fade_in;
+            }
+        }
+        return length;
+    }
+    
+    // Otherwise a loop too close to the start borrows its own head as the
+    // frames before loop_start (the loop gets that much shorter)
+    if (sample->loop_start < length) {
+        sample->loop_start += length - sample->loop_start;
+        if (length > (sample->loop_end - sample->loop_start) / 2) length = (sample->loop_end - sample->loop_start) / 2;
+        if (length <= 0) {
+            return 0;
+        }
+    }
+    
+    for (int i = 0; i < length; i++) {
+        float t = (float)(i + 1) / (float)(length + 1);
+        float fade_out = cosf(t * (float)M_PI_2);
+        float fade_in = sinf(t * (float)M_PI_2);
+        int tail = sample->loop_end - length + i;
+        int head = sample->loop_start - length + i;
+        
+        for (int c = 0; c < channels; c++) {
+            float *dst = &sample->data[tail * channels + c];
+            *dst = *dst * fade_out + sample->data[head * channels + c] * fade_in;
+        }
+    }
+    return length;
+}
+
+// Trim leading and trailing frames below the threshold (never cutting into the loop)
+static void trim_silence(audio_sample_t *sample, float threshold) {
+    int channels = sample->channels;
+    int first = -1;
+    int last = -1;
+    
+    for (int f = 0; f < sample->frames; f++) {
+        for (int c = 0; c < channels; c++) {
+            if (fabsf(sample->data[f * channels + c]) > threshold) {
+                if (first < 0) first = f;
+                last = f;
+                break;
+            }
+        }
+    }
+    if (first < 0) {
+        return;  // Entirely below the threshold; leave it alone
+    }
+    
+    int start = first - SAMPLE_TRIM_PREROLL_MS * sample->sample_rate / 1000;
+    int end = last + 1 + SAMPLE_TRIM_TAIL_MS * sample->sample_rate / 1000;
+    if (start < 0) start = 0;
+    if (end > sample->frames) end = sample->frames;
+    if (sample->loop_end > 0) {
+        if (start > sample->loop_start) start = sample->loop_start;
+        if (end < sample->loop_end) end = sample->loop_end;
+        sample->loop_start -= start;
+        sample->loop_end -= start;
+    }
+    if (start == 0 && end == sample->frames) {
+        return;
+    }
+    
+    sample->file_offset += start;
+    int frames = end - start;
+    memmove(sample->data, sample->data + (size_t)start * channels, (size_t)frames * channels * sizeof(float));
+    float *shrunk = realloc(sample->data, (size_t)frames * channels * sizeof(float));
+    if (shrunk) {
+        sample->data = shrunk;
+    }
+    
+    printf("  Trimmed silence: %.1f ms leading, %.1f ms trailing\n",
+           start * 1000.0f / sample->sample_rate,
+           (sample->frames - end) * 1000.0f / sample->sample_rate);
+    sample->frames = frames;
+}
+
+// Peak and RMS over all channels
+static void measure_levels(audio_sample_t *sample) {
+    size_t count = (size_t)sample->frames * sample->channels;
+    float peak = 0.0f;
+    double sum = 0.0;
+    
+    for (size_t i = 0; i < count; i++) {
+        float value = fabsf(sample->data[i]);
+        if (value > peak) peak = value;
+        sum += (double)value * value;
+    }
+    
+    sample->peak = peak;
+    sample->rms = count > 0 ? (float)sqrt(sum / count) : 0.0f;
+}
+
+// Index the rising zero crossings of the channel sum, for click-free start/end offsets
+static void build_zero_crossing_index(audio_sample_t *sample) {
+    int channels = sample->channels;
+    int count = 0;
+    int capacity = 0;
+    int *index = NULL;
+    float previous = 0.0f;
+    
+    sample->zero_crossings = NULL;
+    sample->zero_crossing_count = 0;
+    
+    for (int f = 0; f < sample->frames; f++) {
+        float value = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            value += sample->data[f * channels + c];
+        }
+        
+        if (previous <= 0.0f && value > 0.0f) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                int *grown = realloc(index, capacity * sizeof(int));
+                if (!grown) {
+                    printf("Warning: Zero-crossing index allocation failed, offsets won't snap\n");
+                    free(index);
+                    return;
+                }
+                index = grown;
+            }
+            index[count++] = f;
+        }
+        previous = value;
+    }
+    
+    if (count > 0) {
+        int *shrunk = realloc(index, count * sizeof(int));
+        sample->zero_crossings = shrunk ? shrunk : index;
+        sample->zero_crossing_count = count;
+    } else {
+        free(index);
+    }
+}
+
+// Half-band low-pass for the mip levels (windowed sinc, cutoff at half the level's Nyquist)
+// Only the centre and the odd taps are non-zero; halfband[i] is the tap at +/-(2i + 1)
+static float halfband[SAMPLE_MIP_HALF_TAPS / 2];
+static float halfband_centre = 0.0f;
+
+static void init_halfband(void) {
+    const int reach = SAMPLE_MIP_HALF_TAPS;
+    float sum = 0.5f;
+    
+    for (int i = 0; i < reach / 2; i++) {
+        int n = 2 * i + 1;
+        float x = (float)M_PI * n / 2.0f;
+        float window = 0.42f + 0.5f * cosf((float)M_PI * n / (reach + 1)) +
+                       0.08f * cosf(2.0f * (float)M_PI * n / (reach + 1));    // Blackman
+        halfband[i] = 0.5f * sinf(x) / x * window;
+        sum += 2.0f * halfband[i];
+    }
+    
+    // Unity gain at DC
+    for (int i = 0; i < reach / 2; i++) {
+        halfband[i] /= sum;
+    }
+    halfband_centre = 0.5f / sum;
+}
+
+// Source frame for the filter: silence outside a one-shot, wrapped past the end of a loop
+static inline float level_frame(const float *src, int frames, int channels, int loop_start, int loop_end,
+                                int frame, int channel) {
+    if (loop_end > loop_start && frame >= loop_end) {
+        frame = loop_start + (frame - loop_end) % (loop_end - loop_start);
+    }
+    if (frame < 0 || frame >= frames) {
+        return 0.0f;
+    }
+    return src[frame * channels + channel];
+}
+
+// Filter and decimate one level by two; NULL if out of memory or cancelled
+static float* build_mip_level(const audio_sample_t *sample, const float *src, int frames,
+                              int loop_start, int loop_end, int out_frames) {
+    int channels = sample->channels;
+    float *level = malloc((size_t)out_frames * channels * sizeof(float));
+    if (!level) {
+        return NULL;
+    }
+    
+    for (int j = 0; j < out_frames; j++) {
+        if ((j & 0xFFFF) == 0 && __atomic_load_n(&sample->mip_cancel, __ATOMIC_ACQUIRE)) {
+            free(level);
+            return NULL;
+        }
+        
+        int centre = 2 * j;
+        for (int c = 0; c < channels; c++) {
+            float acc = halfband_centre * level_frame(src, frames, channels, loop_start, loop_end, centre, c);
+            for (int i = 0; i < SAMPLE_MIP_HALF_TAPS / 2; i++) {
+                int n = 2 * i + 1;
+                acc += halfband[i] * (level_frame(src, frames, channels, loop_start, loop_end, centre - n, c) +
+                                      level_frame(src, frames, channels, loop_start, loop_end, centre + n, c));
+            }
+            level[j * channels + c] = acc;
+        }
+    }
+    return level;
+}
+
+typedef struct {
+    audio_sample_t *sample;
+    int levels;
+} mip_job_t;
+
+// Background build: each level is published as soon as it is ready, so voices
+// can use the first levels while the smaller ones are still being computed
+static void* mip_builder_func(void *arg) {
+    mip_job_t *job = arg;
+    audio_sample_t *sample = job->sample;
+    
+    const float *src = sample->data;
+    int frames = sample->frames;
+    for (int k = 1; k <= job->levels; k++) {
+        int out_frames = (sample->frames + (1 << k) - 1) >> k;
+        if (out_frames < SAMPLE_MIP_MIN_FRAMES) {
+            break;
+        }
+        
+        float *level = build_mip_level(sample, src, frames, sample->loop_start >> (k - 1),
+                                       sample->loop_end >> (k - 1), out_frames);
+        if (!level) {
+            break;
+        }
+        sample->mip_data[k - 1] = level;
+        __atomic_store_n(&sample->mip_count, k, __ATOMIC_RELEASE);
+        if (sample->cached) {
+            sample_cache_add_mip_level(sample, (size_t)out_frames * sample->channels * sizeof(float));
+        }
+        src = level;
+        frames = out_frames;
+    }
+    
+    printf("  Mip levels built: %d\n", __atomic_load_n(&sample->mip_count, __ATOMIC_RELAXED));
+    __atomic_store_n(&sample->mip_building, 0, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&mip_builds_running, 1, __ATOMIC_RELEASE);
+    free(job);
+    return NULL;
+}
+
+// Start building the sample's mip levels ([SAMPLES] mip_levels) on a background thread
+static void start_mip_build(audio_sample_t *sample) {
+    int levels = config_get_int("SAMPLES", "mip_levels", SAMPLE_MIP_DEFAULT_LEVELS);
+    if (levels <= 0) {
+        return;
+    }
+    if (levels > AUDIO_SAMPLE_MAX_MIP_LEVELS) {
+        levels = AUDIO_SAMPLE_MAX_MIP_LEVELS;
+    }
+    
+    mip_job_t *job = malloc(sizeof(mip_job_t));
+    if (!job) {
+        return;
+    }
+    job->sample = sample;
+    job->levels = levels;
+    if (halfband_centre == 0.0f) {
+        init_halfband();
+    }
+    
+    // Normal priority: playback just uses the full-rate data until levels appear
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    __atomic_store_n(&sample->mip_building, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&mip_builds_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&thread, &attr, mip_builder_func, job) != 0) {
+        printf("Warning: Cannot start mip level build, playing full-rate data only\n");
+        __atomic_store_n(&sample->mip_building, 0, __ATOMIC_RELEASE);
+        __atomic_sub_fetch(&mip_builds_running, 1, __ATOMIC_RELEASE);
+        free(job);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Read a WAV file into memory
+static audio_sample_t* read_wav_file(const char *filepath) {
     SF_INFO info;
     SNDFILE *file;
     audio_sample_t *sample = NULL;
@@ -45,8 +385,8 @@ static audio_sample_t* load_wav_file(const char *filepath) {
     printf("  Sample Rate: %d Hz\n", info.samplerate);
     printf("  Format: 0x%08X\n", info.format);
     
-    // Allocate sample structure
-    sample = malloc(sizeof(audio_sample_t));
+    // Allocate sample structure (analysis fields start empty)
+    sample = calloc(1, sizeof(audio_sample_t));
     if (!sample) {
         printf("Error allocating memory for sample structure\n");
         sf_close(file);
@@ -75,12 +415,119 @@ static audio_sample_t* load_wav_file(const char *filepath) {
         sample->frames = frames_read;
     }
     
+    // Sustain loop (smpl chunk)
+    read_loop_points(file, sample);
     sf_close(file);
     
     printf("  Successfully loaded %d frames of audio data\n", sample->frames);
     return sample;
 }
 
+// Prepare a decoded file for playback: trim silence, bake in the loop crossfade,
+// measure levels and index zero crossings (played samples only, never e.g. an impulse response)
+static void prepare_sample(audio_sample_t *sample) {
+    if (config_get_bool("SAMPLES", "trim_silence", 1)) {
+        float threshold_db = config_get_float("SAMPLES", "trim_threshold_db", SAMPLE_TRIM_THRESHOLD_DB);
+        trim_silence(sample, powf(10.0f, threshold_db / 20.0f));
+    }
+    
+    if (sample->loop_end > 0) {
+        int crossfade_ms = config_get_int("SAMPLES", "loop_crossfade_ms", SAMPLE_LOOP_CROSSFADE_MS);
+        int applied = crossfade_loop(sample, (int)((long)crossfade_ms * sample->sample_rate / 1000));
+        printf("  Sustain loop: frames %d-%d (%.1f ms crossfade)\n",
+               sample->loop_start, sample->loop_end, applied * 1000.0f / sample->sample_rate);
+    }
+    
+    measure_levels(sample);
+    build_zero_crossing_index(sample);
+    printf("  Peak %.1f dBFS, RMS %.1f dBFS, %d zero crossings indexed\n",
+           20.0f * log10f(sample->peak > 1e-9f ? sample->peak : 1e-9f),
+           20.0f * log10f(sample->rms > 1e-9f ? sample->rms : 1e-9f),
+           sample->zero_crossing_count);
+}
+
+// Read frames of a file as read_wav_file decodes them (before prepare_sample)
+// (the sample cache restores evicted tails with it, so a reload reads only the tail)
+static int read_wav_frames(const char *filepath, int first_frame, int channels, float *dest, int frames) {
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    SNDFILE *file = sf_open(filepath, SFM_READ, &info);
+    if (!file) {
+        return -1;
+    }
+    
+    int result = -1;
+    if (info.channels == channels && first_frame + (sf_count_t)frames <= info.frames &&
+        sf_seek(file, first_frame, SEEK_SET) == first_frame &&
+        sf_readf_float(file, dest, frames) == frames) {
+        result = 0;
+    }
+    sf_close(file);
+    return result;
+}
+
+// Fingerprint of the settings that shape decoded data, so the pool never serves a stale decode
+static uint32_t load_settings_fingerprint(void) {
+    char settings[64];
+    snprintf(settings, sizeof(settings), "%d:%g:%d",
+             config_get_bool("SAMPLES", "trim_silence", 1),
+             config_get_float("SAMPLES", "trim_threshold_db", SAMPLE_TRIM_THRESHOLD_DB),
+             config_get_int("SAMPLES", "loop_crossfade_ms", SAMPLE_LOOP_CROSSFADE_MS));
+    
+    uint32_t hash = 2166136261u;    // FNV-1a
+    for (const char *c = settings; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash;
+}
+
+// Load and prepare a sample to play, traced so slow loads show up next to the audio callbacks
+// With the shared pool attached, an unchanged file is mapped instead of decoded
+static audio_sample_t* load_wav_file(const char *filepath) {
+    trace_record(TRACE_SAMPLE_LOAD_BEGIN, 0, 0);
+    
+    struct stat file_stat;
+    int pooled = sample_pool_is_attached() && stat(filepath, &file_stat) == 0;
+    uint32_t settings = pooled ? load_settings_fingerprint() : 0;
+    
+    audio_sample_t *sample = pooled ? sample_pool_find(filepath, &file_stat, settings) : NULL;
+    if (!sample) {
+        sample = read_wav_file(filepath);
+        if (sample) {
+            prepare_sample(sample);
+        }
+        if (sample && pooled) {
+            sample_pool_store(filepath, &file_stat, settings, sample);
+        }
+        
+        // Private copies count against [SAMPLES] memory_budget_mb
+        if (sample && !sample->pooled) {
+            sample_cache_add(sample, filepath);
+        }
+    }
+    
+    trace_record(TRACE_SAMPLE_LOAD_END, sample ? sample->frames : 0, 0);
+    return sample;
+}
+
+// Load an audio file outside the sample folder (e.g. an impulse response) exactly as decoded
+audio_sample_t* sample_loader_load_file(const char *filepath) {
+    return read_wav_file(filepath);
+}
+
+// Load a sample to play (e.g. from a kit), with its mip levels built in the background
+audio_sample_t* sample_loader_load_sample(const char *filepath) {
+    audio_sample_t *sample = load_wav_file(filepath);
+    if (sample) {
+        start_mip_build(sample);
+    }
+    return sample;
+}
+
+int sample_loader_is_sample_file(const char *filename) {
+    return is_wav_file(filename);
+}
+
 // Scan directory for WAV files and load the first one
 static int scan_and_load_first_sample(void) {
     DIR *dir;
@@ -126,6 +573,7 @@ static int scan_and_load_first_sample(void) {
         if (!found) {
             first_sample = load_wav_file(filepath);
             if (first_sample) {
+                start_mip_build(first_sample);
                 strncpy(first_sample_name, entry->d_name, sizeof(first_sample_name) - 1);
                 first_sample_name[sizeof(first_sample_name) - 1] = '\0';
                 found = 1;
@@ -176,8 +624,26 @@ int sample_loader_init(const char *samples_dir) {
         return -1;
     }
     
+    // Decoded samples survive restarts in shared memory ([SAMPLES] shared_pool)
+    if (config_get_bool("SAMPLES", "shared_pool", 1) &&
+        sample_pool_init(config_get_string("SAMPLES", "pool_name", SAMPLE_POOL_DEFAULT_NAME),
+                         config_get_int("SAMPLES", "pool_mb", SAMPLE_POOL_DEFAULT_MB)) < 0) {
+        printf("Warning: Sample pool unavailable, decoding every sample\n");
+    }
+    
+    // Memory budget for private sample data ([SAMPLES] memory_budget_mb, 0 = unlimited)
+    int budget_mb = config_get_int("SAMPLES", "memory_budget_mb", SAMPLE_CACHE_DEFAULT_BUDGET_MB);
+    if (budget_mb > 0 &&
+        sample_cache_init((size_t)budget_mb << 20, config_get_int("SAMPLES", "resident_head_ms",
+                                                                  SAMPLE_CACHE_DEFAULT_HEAD_MS),
+                          read_wav_frames) < 0) {
+        printf("Warning: Sample memory budget disabled\n");
+    }
+    
     // Scan directory and load first sample
     if (scan_and_load_first_sample() < 0) {
+        sample_cache_cleanup();
+        sample_pool_cleanup();
         return -1;
     }
     
@@ -193,6 +659,8 @@ void sample_loader_cleanup(void) {
         audio_sample_free(first_sample);
         first_sample = NULL;
     }
+    sample_cache_cleanup();
+    sample_pool_cleanup();
     
     samples_directory[0] = '\0';
     first_sample_name[0] = '\0';
@@ -240,9 +708,33 @@ void sample_loader_list_samples(void) {
     } else {
         printf("No samples loaded\n");
     }
+    if (sample_pool_is_attached()) {
+        sample_pool_print_status();
+    }
+    if (sample_cache_is_enabled()) {
+        sample_cache_stats_t stats;
+        sample_cache_get_stats(&stats);
+        printf("Sample cache: %zu of %zu MB resident (%zu MB mip levels), %d of %d samples evicted to their heads\n",
+               stats.resident_bytes >> 20, stats.budget_bytes >> 20, stats.mip_bytes >> 20,
+               stats.evicted_samples, stats.samples);
+    }
+}
+
+// Measure levels and index zero crossings of audio that didn't come from a file (e.g. live input)
+void sample_loader_analyze(audio_sample_t *sample) {
+    free(sample->zero_crossings);
+    measure_levels(sample);
+    build_zero_crossing_index(sample);
 }
 
 // Check if initialized
 int sample_loader_is_initialized(void) {
     return loader_initialized;
+}
+
+// Block until every background mip build has finished
+void sample_loader_wait_for_mips(void) {
+    while (__atomic_load_n(&mip_builds_running, __ATOMIC_ACQUIRE) > 0) {
+        usleep(1000);
+    }
 }
\ No newline at end of file
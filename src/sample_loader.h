@@ -3,6 +3,23 @@
 
 #include "audio_engine.h"
 
+// Default crossfade baked into sustain loops ([SAMPLES] loop_crossfade_ms)
+#define SAMPLE_LOOP_CROSSFADE_MS 20
+
+// Leading/trailing silence below this level is trimmed at load ([SAMPLES] trim_threshold_db)
+#define SAMPLE_TRIM_THRESHOLD_DB -60.0f
+#define SAMPLE_TRIM_PREROLL_MS 1        // Kept before the first audible frame
+#define SAMPLE_TRIM_TAIL_MS 10          // Kept after the last audible frame
+
+// Band-limited half-rate levels built in the background after loading ([SAMPLES] mip_levels, 0 = off)
+#define SAMPLE_MIP_DEFAULT_LEVELS 0
+#define SAMPLE_MIP_HALF_TAPS 16         // Half-band filter reach on each side (31 taps, 17 non-zero)
+#define SAMPLE_MIP_MIN_FRAMES 256       // No level shorter than this
+
+// Subfolder of the samples folder holding impulse responses ([EFFECTS] reverb_ir);
+// the folder scan never plays them and it is never a kit
+#define SAMPLE_LOADER_IR_FOLDER "ir"
+
 // Sample loader functions
 int sample_loader_init(const char *samples_dir);
 void sample_loader_cleanup(void);
@@ -12,6 +29,19 @@ audio_sample_t* sample_loader_get_first_sample(void);
 const char* sample_loader_get_first_sample_name(void);
 const char* sample_loader_get_samples_directory(void);
 
+// Load any audio file libsndfile can read (caller frees with audio_sample_free)
+// The raw decode: no trimming, loop crossfade or analysis, and outside the pool and memory budget
+audio_sample_t* sample_loader_load_file(const char *filepath);
+
+// Same, for samples that will be played: also starts the background mip build
+audio_sample_t* sample_loader_load_sample(const char *filepath);
+
+// File names the folder scan loads (.wav)
+int sample_loader_is_sample_file(const char *filename);
+
+// Fill in peak/RMS and the zero-crossing index of a sample built in memory
+void sample_loader_analyze(audio_sample_t *sample);
+
 // Sample discovery functions
 int sample_loader_get_sample_count(void);
 void sample_loader_list_samples(void);
@@ -19,4 +49,7 @@ void sample_loader_list_samples(void);
 // Utility functions
 int sample_loader_is_initialized(void);
 
+// Block until every background mip build has finished (e.g. before forking)
+void sample_loader_wait_for_mips(void);
+
 #endif // SAMPLE_LOADER_H
\ No newline at end of file
@@ -0,0 +1,421 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "sample_pool.h"
+
+#define SAMPLE_POOL_MAGIC 0x50535052u     // "RPSP"
+#define SAMPLE_POOL_ALIGN 64
+
+// One decoded sample; 'valid' is cleared when the source file changes
+typedef struct {
+    char path[SAMPLE_POOL_PATH_MAX];
+    long long file_size;
+    long long mtime_sec;
+    long long mtime_nsec;
+    uint32_t settings;          // Load settings fingerprint (trim, crossfade)
+    int valid;
+    int frames;
+    int channels;
+    int sample_rate;
+    int loop_start;
+    int loop_end;
+    float peak;
+    float rms;
+    int zero_crossing_count;
+    uint64_t data_offset;       // From the start of the segment
+    uint64_t zero_crossing_offset;
+} pool_entry_t;
+
+// Start of the segment; every process takes the file lock before touching it
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;              // Segment size in bytes
+    uint64_t used;              // End of the appended data
+    int entry_count;
+    pool_entry_t entries[SAMPLE_POOL_MAX_ENTRIES];
+} pool_header_t;
+
+static char pool_name[64] = "";
+static int pool_fd = -1;
+static pool_header_t *pool = NULL;
+static size_t pool_size = 0;
+static int pool_hits = 0;
+static int pool_misses = 0;
+
+static uint64_t align_up(uint64_t value) {
+    return (value + SAMPLE_POOL_ALIGN - 1) & ~(uint64_t)(SAMPLE_POOL_ALIGN - 1);
+}
+
+static void format_pool(pool_header_t *header, size_t size) {
+    memset(header, 0, sizeof(pool_header_t));
+    header->magic = SAMPLE_POOL_MAGIC;
+    header->version = SAMPLE_POOL_VERSION;
+    header->size = size;
+    header->used = align_up(sizeof(pool_header_t));
+}
+
+// Map the segment, creating (or replacing an incompatible) one as needed; called with the lock held
+static int map_pool(size_t size) {
+    struct stat st;
+    if (fstat(pool_fd, &st) != 0) {
+        return -1;
+    }
+    
+    int fresh = st.st_size == 0;
+    if (fresh && ftruncate(pool_fd, (off_t)size) != 0) {
+        printf("Error: Cannot size sample pool '%s' to %zu MB: %s\n", pool_name, size >> 20, strerror(errno));
+        return -1;
+    }
+    size_t mapped = fresh ? size : (size_t)st.st_size;
+    if (mapped < sizeof(pool_header_t)) {
+        return -1;
+    }
+    
+    void *base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, pool_fd, 0);
+    if (base == MAP_FAILED) {
+        printf("Error: Cannot map sample pool '%s': %s\n", pool_name, strerror(errno));
+        return -1;
+    }
+    
+    pool = base;
+    pool_size = mapped;
+    if (fresh) {
+        format_pool(pool, mapped);
+        printf("Sample pool: created '%s' (%zu MB)\n", pool_name, mapped >> 20);
+    } else if (pool->magic != SAMPLE_POOL_MAGIC || pool->version != SAMPLE_POOL_VERSION ||
+               pool->size != mapped || pool->used > mapped) {
+        return -2;
+    } else {
+        printf("Sample pool: attached to '%s' (%d samples, %llu of %zu MB used)\n", pool_name,
+               pool->entry_count, (unsigned long long)(pool->used >> 20), mapped >> 20);
+        if (mapped != size) {
+            printf("Warning: Sample pool '%s' already exists at %zu MB; pool_mb = %zu takes effect once it is deleted\n",
+                   pool_name, mapped >> 20, size >> 20);
+        }
+    }
+    
+    if (mlock(pool, mapped) != 0) {
+        printf("Warning: Cannot lock sample pool '%s' in memory: %s\n", pool_name, strerror(errno));
+    }
+    return 0;
+}
+
+static int entry_matches_file(const pool_entry_t *entry, const struct stat *file_stat) {
+    return entry->file_size == (long long)file_stat->st_size &&
+           entry->mtime_sec == (long long)file_stat->st_mtim.tv_sec &&
+           entry->mtime_nsec == (long long)file_stat->st_mtim.tv_nsec;
+}
+
+// Space an entry's data and zero-crossing index take up, alignment included
+static uint64_t entry_bytes(const pool_entry_t *entry) {
+    size_t index_bytes = (size_t)entry->zero_crossing_count * sizeof(int);
+    return align_up(entry->zero_crossing_offset + index_bytes) - entry->data_offset;
+}
+
+// Bytes taken by retired decodes (appended data is only reclaimed by compact_pool)
+static uint64_t wasted_bytes(void) {
+    uint64_t live = align_up(sizeof(pool_header_t));
+    for (int i = 0; i < pool->entry_count; i++) {
+        if (pool->entries[i].valid) {
+            live += entry_bytes(&pool->entries[i]);
+        }
+    }
+    return pool->used > live ? pool->used - live : 0;
+}
+
+// Every attached process holds a read lock on the segment's first byte for as long
+// as it is attached (fcntl locks, independent of the flock taken around changes);
+// getting the write lock instead means no other process has the segment mapped
+static int claim_sole_use(void) {
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 1 };
+    return fcntl(pool_fd, F_SETLK, &lock) == 0;
+}
+
+static void hold_shared_use(void) {
+    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 1 };
+    fcntl(pool_fd, F_SETLK, &lock);
+}
+
+static int compare_data_offsets(const void *a, const void *b) {
+    uint64_t offset_a = ((const pool_entry_t*)a)->data_offset;
+    uint64_t offset_b = ((const pool_entry_t*)b)->data_offset;
+    return offset_a < offset_b ? -1 : offset_a > offset_b;
+}
+
+// Drop entries whose file changed or is gone and move the rest down over the
+// space of retired decodes (only while no other process has the segment mapped)
+static void compact_pool(void) {
+    struct stat st;
+    int kept = 0;
+    for (int i = 0; i < pool->entry_count; i++) {
+        pool_entry_t *entry = &pool->entries[i];
+        if (entry->valid && (stat(entry->path, &st) != 0 || !entry_matches_file(entry, &st))) {
+            entry->valid = 0;
+        }
+        if (entry->valid) {
+            pool->entries[kept++] = *entry;
+        }
+    }
+    int retired = pool->entry_count - kept;
+    pool->entry_count = kept;
+    if (retired == 0 && wasted_bytes() == 0) {
+        return;
+    }
+    
+    // In data order every move goes downwards, into space already vacated
+    qsort(pool->entries, kept, sizeof(pool_entry_t), compare_data_offsets);
+    char *base = (char*)pool;
+    uint64_t before = pool->used;
+    uint64_t used = align_up(sizeof(pool_header_t));
+    for (int i = 0; i < kept; i++) {
+        pool_entry_t *entry = &pool->entries[i];
+        size_t data_bytes = (size_t)entry->frames * entry->channels * sizeof(float);
+        size_t index_bytes = (size_t)entry->zero_crossing_count * sizeof(int);
+        
+        uint64_t new_index_offset = align_up(used + data_bytes);
+        memmove(base + used, base + entry->data_offset, data_bytes);
+        memmove(base + new_index_offset, base + entry->zero_crossing_offset, index_bytes);
+        entry->data_offset = used;
+        entry->zero_crossing_offset = new_index_offset;
+        used = align_up(new_index_offset + index_bytes);
+    }
+    pool->used = used;
+    printf("Sample pool: reclaimed %llu KB of %d retired samples\n",
+           (unsigned long long)((before - used) >> 10), retired);
+}
+
+static void close_pool(void) {
+    if (pool) {
+        munmap(pool, pool_size);
+        pool = NULL;
+    }
+    if (pool_fd >= 0) {
+        close(pool_fd);
+        pool_fd = -1;
+    }
+}
+
+// Open or create the named segment
+int sample_pool_init(const char *name, int size_mb) {
+    if (pool) {
+        return 0;
+    }
+    if (!name || name[0] != '/' || size_mb <= 0) {
+        printf("Error: Sample pool name must start with '/' and pool_mb must be positive\n");
+        return -1;
+    }
+    snprintf(pool_name, sizeof(pool_name), "%s", name);
+    size_t size = (size_t)size_mb << 20;
+    
+    for (int attempt = 0; attempt < 2; attempt++) {
+        pool_fd = shm_open(pool_name, O_RDWR | O_CREAT, 0660);
+        if (pool_fd < 0) {
+            printf("Error: Cannot open sample pool '%s': %s\n", pool_name, strerror(errno));
+            return -1;
+        }
+        flock(pool_fd, LOCK_EX);
+        int result = map_pool(size);
+        
+        // Left by an older build: unlink it (instances still using it keep their mapping)
+        if (result == -2 && attempt == 0) {
+            printf("Sample pool: replacing incompatible segment '%s'\n", pool_name);
+            shm_unlink(pool_name);
+            flock(pool_fd, LOCK_UN);
+            close_pool();
+            continue;
+        }
+        
+        if (result == 0 && claim_sole_use()) {
+            compact_pool();
+        }
+        hold_shared_use();
+        flock(pool_fd, LOCK_UN);
+        if (result < 0) {
+            close_pool();
+            return -1;
+        }
+        pool_hits = 0;
+        pool_misses = 0;
+        return 0;
+    }
+    return -1;
+}
+
+// Unmap the segment; it stays in /dev/shm for the next start
+void sample_pool_cleanup(void) {
+    close_pool();
+}
+
+// Entry for this file state and settings; entries for an older state of the file are retired
+static pool_entry_t* find_entry(const char *filepath, const struct stat *file_stat, uint32_t settings) {
+    pool_entry_t *found = NULL;
+    for (int i = 0; i < pool->entry_count; i++) {
+        pool_entry_t *entry = &pool->entries[i];
+        if (!entry->valid || strcmp(entry->path, filepath) != 0) {
+            continue;
+        }
+        if (!entry_matches_file(entry, file_stat)) {
+            entry->valid = 0;
+        } else if (entry->settings == settings) {
+            found = entry;
+        }
+    }
+    return found;
+}
+
+static audio_sample_t* sample_from_entry(const pool_entry_t *entry) {
+    audio_sample_t *sample = calloc(1, sizeof(audio_sample_t));
+    if (!sample) {
+        return NULL;
+    }
+    
+    char *base = (char*)pool;
+    sample->data = (float*)(base + entry->data_offset);
+    sample->frames = entry->frames;
+    sample->channels = entry->channels;
+    sample->sample_rate = entry->sample_rate;
+    sample->loop_start = entry->loop_start;
+    sample->loop_end = entry->loop_end;
+    sample->peak = entry->peak;
+    sample->rms = entry->rms;
+    sample->zero_crossings = entry->zero_crossing_count > 0 ? (int*)(base + entry->zero_crossing_offset) : NULL;
+    sample->zero_crossing_count = entry->zero_crossing_count;
+    sample->pooled = 1;
+    return sample;
+}
+
+audio_sample_t* sample_pool_find(const char *filepath, const struct stat *file_stat, uint32_t settings) {
+    if (!pool || strlen(filepath) >= SAMPLE_POOL_PATH_MAX) {
+        return NULL;
+    }
+    
+    flock(pool_fd, LOCK_EX);
+    pool_entry_t *entry = find_entry(filepath, file_stat, settings);
+    audio_sample_t *sample = entry ? sample_from_entry(entry) : NULL;
+    flock(pool_fd, LOCK_UN);
+    
+    if (sample) {
+        pool_hits++;
+        printf("Loaded from sample pool: %s (%d frames)\n", filepath, sample->frames);
+    } else {
+        pool_misses++;
+    }
+    return sample;
+}
+
+// Point the sample at the pool copy and release its private buffers
+static void adopt_entry(audio_sample_t *sample, const pool_entry_t *entry) {
+    audio_sample_t *shared = sample_from_entry(entry);
+    if (!shared) {
+        return;
+    }
+    free(sample->data);
+    free(sample->zero_crossings);
+    sample->data = shared->data;
+    sample->zero_crossings = shared->zero_crossings;
+    sample->zero_crossing_count = shared->zero_crossing_count;
+    sample->pooled = 1;
+    free(shared);
+}
+
+int sample_pool_store(const char *filepath, const struct stat *file_stat, uint32_t settings,
+                      audio_sample_t *sample) {
+    if (!pool || sample->pooled || strlen(filepath) >= SAMPLE_POOL_PATH_MAX) {
+        return -1;
+    }
+    
+    size_t data_bytes = (size_t)sample->frames * sample->channels * sizeof(float);
+    size_t index_bytes = (size_t)sample->zero_crossing_count * sizeof(int);
+    int result = -1;
+    
+    flock(pool_fd, LOCK_EX);
+    
+    // Another instance may have decoded the same file meanwhile
+    pool_entry_t *entry = find_entry(filepath, file_stat, settings);
+    if (entry) {
+        adopt_entry(sample, entry);
+        flock(pool_fd, LOCK_UN);
+        return 0;
+    }
+    
+    // Reuse a retired slot for the index entry; its data stays where it is
+    int slot = -1;
+    for (int i = 0; i < pool->entry_count && slot < 0; i++) {
+        if (!pool->entries[i].valid) {
+            slot = i;
+        }
+    }
+    if (slot < 0 && pool->entry_count < SAMPLE_POOL_MAX_ENTRIES) {
+        slot = pool->entry_count;
+    }
+    
+    uint64_t data_offset = pool->used;
+    uint64_t index_offset = align_up(data_offset + data_bytes);
+    uint64_t end = align_up(index_offset + index_bytes);
+    
+    if (slot < 0) {
+        printf("Warning: Sample pool index full, '%s' stays private\n", filepath);
+    } else if (end > pool->size) {
+        printf("Warning: Sample pool full (%zu MB), '%s' stays private\n", pool_size >> 20, filepath);
+    } else {
+        char *base = (char*)pool;
+        memcpy(base + data_offset, sample->data, data_bytes);
+        if (index_bytes > 0) {
+            memcpy(base + index_offset, sample->zero_crossings, index_bytes);
+        }
+        
+        entry = &pool->entries[slot];
+        memset(entry, 0, sizeof(*entry));
+        snprintf(entry->path, sizeof(entry->path), "%s", filepath);
+        entry->file_size = (long long)file_stat->st_size;
+        entry->mtime_sec = (long long)file_stat->st_mtim.tv_sec;
+        entry->mtime_nsec = (long long)file_stat->st_mtim.tv_nsec;
+        entry->settings = settings;
+        entry->frames = sample->frames;
+        entry->channels = sample->channels;
+        entry->sample_rate = sample->sample_rate;
+        entry->loop_start = sample->loop_start;
+        entry->loop_end = sample->loop_end;
+        entry->peak = sample->peak;
+        entry->rms = sample->rms;
+        entry->zero_crossing_count = sample->zero_crossing_count;
+        entry->data_offset = data_offset;
+        entry->zero_crossing_offset = index_offset;
+        entry->valid = 1;
+        
+        pool->used = end;
+        if (slot == pool->entry_count) {
+            pool->entry_count++;
+        }
+        adopt_entry(sample, entry);
+        result = 0;
+    }
+    
+    flock(pool_fd, LOCK_UN);
+    return result;
+}
+
+int sample_pool_is_attached(void) {
+    return pool != NULL;
+}
+
+void sample_pool_print_status(void) {
+    if (!pool) {
+        printf("Sample pool: not attached\n");
+        return;
+    }
+    flock(pool_fd, LOCK_EX);
+    uint64_t used = pool->used;
+    uint64_t wasted = wasted_bytes();
+    flock(pool_fd, LOCK_UN);
+    printf("Sample pool: '%s', %d hits, %d misses, %llu of %zu MB used (%llu MB by retired samples)\n",
+           pool_name, pool_hits, pool_misses, (unsigned long long)(used >> 20), pool_size >> 20,
+           (unsigned long long)(wasted >> 20));
+}
@@ -0,0 +1,46 @@
+#ifndef SAMPLE_POOL_H
+#define SAMPLE_POOL_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include "audio_engine.h"
+
+// Shared-memory segment holding decoded samples ([SAMPLES] pool_name, pool_mb)
+#define SAMPLE_POOL_DEFAULT_NAME "/rpi-sampler-pool"
+#define SAMPLE_POOL_DEFAULT_MB 64
+
+// Bump when the segment layout or the decoded format changes; older segments are replaced
+#define SAMPLE_POOL_VERSION 2
+
+#define SAMPLE_POOL_MAX_ENTRIES 256
+#define SAMPLE_POOL_PATH_MAX 256
+
+// Shared sample pool
+//
+// Decoded, trimmed and analysed sample data is kept in a named POSIX
+// shared-memory segment that outlives the process. Each entry in the index
+// records the source file's path, size and modification time plus the load
+// settings it was decoded with; a restarted sampler (or a second instance
+// on another audio interface) maps the segment and plays straight from it
+// when all of them still match. While attached, data is only ever
+// appended, so an entry replaced after its file changed never moves under
+// a process still playing it. The first process to attach while no other
+// has the segment open drops stale entries and compacts the rest.
+
+// Setup (not real-time safe); returns -1 if the segment can't be used
+int sample_pool_init(const char *name, int size_mb);
+void sample_pool_cleanup(void);
+
+// Decoded copy of a file if the pool has one for this file state and settings
+// (returns a new sample whose data lives in the pool, NULL on a miss)
+audio_sample_t* sample_pool_find(const char *filepath, const struct stat *file_stat, uint32_t settings);
+
+// Copy a freshly decoded sample into the pool and point it at the shared copy
+int sample_pool_store(const char *filepath, const struct stat *file_stat, uint32_t settings,
+                      audio_sample_t *sample);
+
+// Status
+int sample_pool_is_attached(void);
+void sample_pool_print_status(void);
+
+#endif // SAMPLE_POOL_H
@@ -0,0 +1,487 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include "sequencer.h"
+#include "config.h"
+
+// Step velocities ('X' and 'x' in a track)
+#define SEQUENCER_ACCENT_VELOCITY 127
+#define SEQUENCER_NORMAL_VELOCITY 96
+
+// One note-on of a compiled pattern
+typedef struct {
+    int tick;                   // Position in the pattern
+    int gate;                   // Ticks until the note-off
+    uint8_t note;
+    uint8_t velocity;
+} pattern_step_t;
+
+typedef struct {
+    int length;                 // Ticks per cycle (never 0)
+    int step_ticks;             // Grid a pattern starting from silence is anchored to
+    int channel;
+    int count;                  // Note-ons in 'steps' (0 = silent)
+    pattern_step_t steps[SEQUENCER_MAX_EVENTS];
+} pattern_t;
+
+// Playback state of one track (audio thread only); ticks count from song position 0
+typedef struct {
+    const pattern_t *pattern;
+    double origin;              // Tick the pattern's cycles are anchored to (-1 = next step)
+    double cycle_start;         // Tick where the cursor's cycle began
+    int next;                   // Next step to play
+    int seek;                   // Place the cursor before the next window
+    int sounding;               // Note waiting for its note-off (-1 = none)
+    int sounding_channel;
+    double off_tick;
+} track_t;
+
+static sequencer_config_t seq_config;
+static int seq_initialized = 0;
+
+static pattern_t step_patterns[SEQUENCER_STEP_TRACKS];
+
+// Arpeggio triple buffer: the MIDI thread compiles into arp_back and swaps it into
+// arp_pending; the audio thread swaps arp_pending with arp_front while ARP_DIRTY is set
+#define ARP_DIRTY 4
+static pattern_t arp_patterns[3];
+static int arp_back = 0;                    // MIDI thread
+static int arp_pending = 1;                 // Shared
+static int arp_front = 2;                   // Audio thread
+
+// Held arpeggiator notes in press order (MIDI thread)
+static uint8_t held_notes[SEQUENCER_MAX_HELD];
+static uint8_t held_velocities[SEQUENCER_MAX_HELD];
+static int held_count = 0;
+static unsigned int arp_seed = 1;
+
+// Audio thread
+static track_t tracks[SEQUENCER_STEP_TRACKS + 1];
+static int track_count = 0;
+static int arp_track = -1;
+static double internal_beat = 0.0;
+static double expected_tick = -1.0;        // Where the last window ended (-1 = stopped)
+
+sequencer_config_t sequencer_get_default_config(void) {
+    sequencer_config_t config = {
+        .enabled = 0,
+        .midi_sync = 0,
+        .tempo = 120.0f,
+        .step = 16,
+        .gate = 0.5f,
+        .arp_channel = -1,
+        .arp_mode = ARP_UP,
+        .arp_octaves = 1,
+        .arp_step = 16
+    };
+    return config;
+}
+
+static int parse_arp_mode(const char *name, int fallback) {
+    static const char *names[] = {"up", "down", "updown", "order", "random"};
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcasecmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return fallback;
+}
+
+// Ticks per step for a note division (16 = sixteenth notes)
+static int division_ticks(int division) {
+    int ticks = division > 0 ? SEQUENCER_PPQN * 4 / division : SEQUENCER_PPQN / 4;
+    return ticks > 0 ? ticks : 1;
+}
+
+// Load the [SEQUENCER] section
+void sequencer_load_config(sequencer_config_t *config) {
+    char key[16];
+    
+    config->enabled = config_get_bool("SEQUENCER", "enabled", config->enabled);
+    config->midi_sync = strcasecmp(config_get_string("SEQUENCER", "sync", config->midi_sync ? "midi" : "internal"),
+                                   "midi") == 0;
+    config->tempo = config_get_float("SEQUENCER", "tempo", config->tempo);
+    if (config->tempo < 20.0f) config->tempo = 20.0f;
+    if (config->tempo > 300.0f) config->tempo = 300.0f;
+    config->step = config_get_int("SEQUENCER", "step", config->step);
+    config->gate = config_get_float("SEQUENCER", "gate", config->gate);
+    if (config->gate < 0.05f) config->gate = 0.05f;
+    if (config->gate > 1.0f) config->gate = 1.0f;
+    
+    for (int t = 0; t < SEQUENCER_STEP_TRACKS; t++) {
+        snprintf(key, sizeof(key), "track_%d", t + 1);
+        snprintf(config->tracks[t], sizeof(config->tracks[t]), "%s",
+                 config_get_string("SEQUENCER", key, config->tracks[t]));
+    }
+    
+    config->arp_channel = config_get_int("SEQUENCER", "arp_channel", config->arp_channel + 1) - 1;
+    if (config->arp_channel > 15) config->arp_channel = -1;
+    config->arp_mode = parse_arp_mode(config_get_string("SEQUENCER", "arp_mode", "up"), config->arp_mode);
+    config->arp_octaves = config_get_int("SEQUENCER", "arp_octaves", config->arp_octaves);
+    if (config->arp_octaves < 1) config->arp_octaves = 1;
+    if (config->arp_octaves > 4) config->arp_octaves = 4;
+    config->arp_step = config_get_int("SEQUENCER", "arp_step", config->arp_step);
+}
+
+// Compile "channel:note:steps" ('X' accent, 'x' note, '-' tie, anything else rest)
+static int compile_track(pattern_t *pattern, const char *spec) {
+    int channel, note, consumed = 0;
+    if (sscanf(spec, "%d:%d:%n", &channel, &note, &consumed) < 2 || consumed == 0 ||
+        channel < 1 || channel > 16 || note < 0 || note > 127) {
+        return -1;
+    }
+    
+    int step_ticks = division_ticks(seq_config.step);
+    int gate = (int)(step_ticks * seq_config.gate);
+    int steps = 0;
+    pattern->count = 0;
+    
+    for (const char *c = spec + consumed; *c && steps < SEQUENCER_MAX_STEPS; c++) {
+        if (*c == ' ' || *c == '|') {
+            continue;   // Separators for readability
+        }
+        int tick = steps++ * step_ticks;
+        
+        if (*c == 'X' || *c == 'x') {
+            pattern_step_t *step = &pattern->steps[pattern->count++];
+            step->tick = tick;
+            step->gate = gate > 0 ? gate : 1;
+            step->note = (uint8_t)note;
+            step->velocity = *c == 'X' ? SEQUENCER_ACCENT_VELOCITY : SEQUENCER_NORMAL_VELOCITY;
+        } else if (*c == '-' && pattern->count > 0) {
+            pattern_step_t *step = &pattern->steps[pattern->count - 1];
+            step->gate = tick - step->tick + (gate > 0 ? gate : 1);
+        }
+    }
+    if (steps == 0) {
+        return -1;
+    }
+    
+    pattern->length = steps * step_ticks;
+    pattern->step_ticks = step_ticks;
+    pattern->channel = channel - 1;
+    return 0;
+}
+
+// Compile the held chord into an arpeggio (MIDI thread)
+static void compile_arp(pattern_t *pattern) {
+    int step_ticks = division_ticks(seq_config.arp_step);
+    int gate = (int)(step_ticks * seq_config.gate);
+    int order[SEQUENCER_MAX_HELD];
+    int n = held_count;
+    
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    if (seq_config.arp_mode == ARP_RANDOM) {
+        for (int i = n - 1; i > 0; i--) {
+            arp_seed = arp_seed * 1103515245u + 12345u;
+            int j = (int)((arp_seed >> 16) % (unsigned int)(i + 1));
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+    } else if (seq_config.arp_mode != ARP_ORDER) {
+        for (int i = 1; i < n; i++) {
+            int value = order[i];
+            int j = i - 1;
+            while (j >= 0 && held_notes[order[j]] > held_notes[value]) {
+                order[j + 1] = order[j];
+                j--;
+            }
+            order[j + 1] = value;
+        }
+    }
+    
+    // One octave after the other, then reversed for down and mirrored for up/down
+    pattern_step_t *steps = pattern->steps;
+    int count = 0;
+    for (int octave = 0; octave < seq_config.arp_octaves; octave++) {
+        for (int i = 0; i < n; i++) {
+            int note = held_notes[order[i]] + 12 * octave;
+            if (note <= 127) {
+                steps[count].note = (uint8_t)note;
+                steps[count].velocity = held_velocities[order[i]];
+                count++;
+            }
+        }
+    }
+    if (seq_config.arp_mode == ARP_DOWN) {
+        for (int i = 0; i < count / 2; i++) {
+            pattern_step_t swap = steps[i];
+            steps[i] = steps[count - 1 - i];
+            steps[count - 1 - i] = swap;
+        }
+    } else if (seq_config.arp_mode == ARP_UP_DOWN) {
+        for (int i = count - 2; i > 0; i--) {
+            steps[count + (count - 2 - i)] = steps[i];
+        }
+        count = count > 2 ? count * 2 - 2 : count;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        steps[i].tick = i * step_ticks;
+        steps[i].gate = gate > 0 ? gate : 1;
+    }
+    pattern->count = count;
+    pattern->length = (count > 0 ? count : 1) * step_ticks;
+    pattern->step_ticks = step_ticks;
+    pattern->channel = seq_config.arp_channel;
+}
+
+// Compile the step tracks and set up the arpeggiator (does nothing unless [SEQUENCER] enabled)
+int sequencer_init(const sequencer_config_t *config) {
+    if (seq_initialized) {
+        return 0;
+    }
+    
+    seq_config = *config;
+    if (!seq_config.enabled) {
+        return 0;
+    }
+    
+    track_count = 0;
+    for (int t = 0; t < SEQUENCER_STEP_TRACKS; t++) {
+        if (seq_config.tracks[t][0] == '\0') {
+            continue;
+        }
+        if (compile_track(&step_patterns[t], seq_config.tracks[t]) < 0) {
+            printf("Warning: Sequencer track_%d '%s' is not channel:note:steps, ignored\n",
+                   t + 1, seq_config.tracks[t]);
+            continue;
+        }
+        tracks[track_count++].pattern = &step_patterns[t];
+        printf("Sequencer: track_%d, %d notes over %d steps on channel %d\n", t + 1, step_patterns[t].count,
+               step_patterns[t].length / step_patterns[t].step_ticks, step_patterns[t].channel + 1);
+    }
+    
+    if (seq_config.arp_channel >= 0) {
+        held_count = 0;
+        for (int i = 0; i < 3; i++) {
+            compile_arp(&arp_patterns[i]);
+        }
+        arp_track = track_count;
+        tracks[track_count++].pattern = &arp_patterns[arp_front];
+        printf("Sequencer: arpeggiator on channel %d\n", seq_config.arp_channel + 1);
+    }
+    
+    if (track_count == 0) {
+        printf("Sequencer: no tracks configured\n");
+        return 0;
+    }
+    
+    for (int t = 0; t < track_count; t++) {
+        tracks[t].origin = t == arp_track ? -1.0 : 0.0;
+        tracks[t].seek = 1;
+        tracks[t].sounding = -1;
+    }
+    internal_beat = 0.0;
+    expected_tick = -1.0;
+    seq_initialized = 1;
+    printf("Sequencer: %s\n", seq_config.midi_sync ? "following MIDI clock" : "internal tempo");
+    return 0;
+}
+
+// Track the arpeggiator channel's keys and recompile the arpeggio when they change
+int sequencer_filter_events(midi_event_t *events, int count) {
+    if (!seq_initialized || arp_track < 0) {
+        return count;
+    }
+    
+    int kept = 0;
+    int changed = 0;
+    for (int i = 0; i < count; i++) {
+        const midi_event_t *e = &events[i];
+        if (e->channel != seq_config.arp_channel ||
+            (e->type != MIDI_EVENT_NOTE_ON && e->type != MIDI_EVENT_NOTE_OFF)) {
+            events[kept++] = *e;
+            continue;
+        }
+        
+        int held = -1;
+        for (int h = 0; h < held_count; h++) {
+            if (held_notes[h] == e->data1) {
+                held = h;
+            }
+        }
+        if (e->type == MIDI_EVENT_NOTE_ON && held < 0 && held_count < SEQUENCER_MAX_HELD) {
+            held_notes[held_count] = e->data1;
+            held_velocities[held_count] = e->data2;
+            held_count++;
+            changed = 1;
+        } else if (e->type == MIDI_EVENT_NOTE_OFF && held >= 0) {
+            memmove(&held_notes[held], &held_notes[held + 1], held_count - held - 1);
+            memmove(&held_velocities[held], &held_velocities[held + 1], held_count - held - 1);
+            held_count--;
+            changed = 1;
+        }
+    }
+    
+    if (changed) {
+        compile_arp(&arp_patterns[arp_back]);
+        arp_back = __atomic_exchange_n(&arp_pending, arp_back | ARP_DIRTY, __ATOMIC_ACQ_REL) & 3;
+    }
+    return kept;
+}
+
+// Place the cursor on the first step at or after 'tick'
+static void seek_track(track_t *track, double tick) {
+    const pattern_t *pattern = track->pattern;
+    
+    // A pattern starting from silence begins on the next step of its grid
+    if (track->origin < 0.0) {
+        track->origin = ceil(tick / pattern->step_ticks) * pattern->step_ticks;
+    }
+    
+    track->next = 0;
+    track->seek = 0;
+    if (tick < track->origin) {
+        track->cycle_start = track->origin;
+        return;
+    }
+    
+    track->cycle_start = track->origin + floor((tick - track->origin) / pattern->length) * pattern->length;
+    while (track->next < pattern->count && track->cycle_start + pattern->steps[track->next].tick < tick) {
+        track->next++;
+    }
+    if (track->next == pattern->count) {
+        track->next = 0;
+        track->cycle_start += pattern->length;
+    }
+}
+
+static void emit(sequencer_event_t *events, int *count, int offset, int type, int channel, int note, int velocity) {
+    sequencer_event_t *event = &events[(*count)++];
+    event->offset = offset;
+    event->type = (uint8_t)type;
+    event->channel = (uint8_t)channel;
+    event->note = (uint8_t)note;
+    event->velocity = (uint8_t)velocity;
+}
+
+// End the track's sounding note at the start of the block
+static void silence_track(track_t *track, sequencer_event_t *events, int *count, int max_events) {
+    if (track->sounding >= 0 && *count < max_events) {
+        emit(events, count, 0, MIDI_EVENT_NOTE_OFF, track->sounding_channel, track->sounding, 0);
+        track->sounding = -1;
+    }
+    track->seek = 1;
+}
+
+// Emit the track's note-ons and note-offs in [from, to); 'start' is the block's first frame
+static void advance_track(track_t *track, double from, double to, double start, double ticks_per_frame,
+                          jack_nframes_t nframes, sequencer_event_t *events, int *count, int max_events) {
+    const pattern_t *pattern = track->pattern;
+    
+    if (track->seek) {
+        seek_track(track, from);
+    }
+    
+    // Room for a note-off and the note-on that cuts it
+    while (*count + 2 <= max_events) {
+        double on_tick = pattern->count > 0 ? track->cycle_start + pattern->steps[track->next].tick : INFINITY;
+        double off_tick = track->sounding >= 0 ? track->off_tick : INFINITY;
+        double tick = on_tick < off_tick ? on_tick : off_tick;
+        if (tick >= to) {
+            break;
+        }
+        
+        double frame = (tick - start) / ticks_per_frame + 0.5;
+        int offset = frame < 1.0 ? 0 : (frame >= nframes ? (int)nframes - 1 : (int)frame);
+        
+        if (track->sounding >= 0) {
+            emit(events, count, offset, MIDI_EVENT_NOTE_OFF, track->sounding_channel, track->sounding, 0);
+            track->sounding = -1;
+        }
+        if (on_tick <= tick) {
+            const pattern_step_t *step = &pattern->steps[track->next];
+            emit(events, count, offset, MIDI_EVENT_NOTE_ON, pattern->channel, step->note, step->velocity);
+            track->sounding = step->note;
+            track->sounding_channel = pattern->channel;
+            track->off_tick = on_tick + step->gate;
+            if (++track->next == pattern->count) {
+                track->next = 0;
+                track->cycle_start += pattern->length;
+            }
+        }
+    }
+}
+
+// Turn this block's stretch of song position into note events
+int sequencer_render(const midi_clock_state_t *clock, int sample_rate, jack_nframes_t nframes,
+                     sequencer_event_t *events, int max_events) {
+    if (!seq_initialized || sample_rate <= 0 || nframes == 0) {
+        return 0;
+    }
+    int count = 0;
+    
+    // A new arpeggio keeps the grid; the cursor finds its place in it
+    if (arp_track >= 0 && (__atomic_load_n(&arp_pending, __ATOMIC_ACQUIRE) & ARP_DIRTY)) {
+        track_t *track = &tracks[arp_track];
+        if (track->pattern->count == 0) {
+            track->origin = -1.0;   // Checked before the MIDI thread can reuse the old buffer
+        }
+        arp_front = __atomic_exchange_n(&arp_pending, arp_front, __ATOMIC_ACQ_REL) & 3;
+        track->pattern = &arp_patterns[arp_front];
+        track->seek = 1;
+    }
+    
+    int running;
+    double beat;
+    double beats_per_frame;
+    if (seq_config.midi_sync) {
+        running = clock->running && clock->locked;
+        beat = clock->beat;
+        beats_per_frame = clock->beats_per_frame;
+    } else {
+        running = 1;
+        beat = internal_beat;
+        beats_per_frame = seq_config.tempo / 60.0 / sample_rate;
+        internal_beat += beats_per_frame * nframes;
+    }
+    
+    if (!running || beats_per_frame <= 0.0) {
+        if (expected_tick >= 0.0) {
+            for (int t = 0; t < track_count; t++) {
+                silence_track(&tracks[t], events, &count, max_events);
+            }
+            expected_tick = -1.0;
+        }
+        return count;
+    }
+    
+    double ticks_per_frame = beats_per_frame * SEQUENCER_PPQN;
+    double start = beat * SEQUENCER_PPQN;
+    double end = start + ticks_per_frame * nframes;
+    
+    // Small differences from the last window are clock corrections: carry on from where
+    // it ended so nothing plays twice or is skipped. Jumps (Start, Continue) relocate.
+    double from = start;
+    if (expected_tick >= 0.0 && fabs(start - expected_tick) < SEQUENCER_PPQN) {
+        from = expected_tick;
+    } else {
+        for (int t = 0; t < track_count; t++) {
+            silence_track(&tracks[t], events, &count, max_events);
+        }
+    }
+    
+    for (int t = 0; t < track_count; t++) {
+        advance_track(&tracks[t], from, end, start, ticks_per_frame, nframes, events, &count, max_events);
+    }
+    expected_tick = end > from ? end : from;
+    
+    // Tracks were advanced one after the other; the engine wants the block in time order
+    for (int i = 1; i < count; i++) {
+        sequencer_event_t event = events[i];
+        int j = i - 1;
+        while (j >= 0 && events[j].offset > event.offset) {
+            events[j + 1] = events[j];
+            j--;
+        }
+        events[j + 1] = event;
+    }
+    return count;
+}
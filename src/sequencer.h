@@ -0,0 +1,79 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stdint.h>
+#include <jack/jack.h>
+#include "midi.h"
+#include "midi_clock.h"
+
+// Pattern resolution (ticks per quarter note)
+#define SEQUENCER_PPQN 96
+
+// Step tracks from [SEQUENCER] track_1..track_4, plus the arpeggiator
+#define SEQUENCER_STEP_TRACKS 4
+#define SEQUENCER_MAX_STEPS 64
+
+// Note-ons per compiled pattern (an arpeggio of 16 notes over 4 octaves up and down fits)
+#define SEQUENCER_MAX_EVENTS 256
+
+// Notes the arpeggiator can hold at once
+#define SEQUENCER_MAX_HELD 16
+
+// Most note events one block can produce
+#define SEQUENCER_BLOCK_EVENTS 64
+
+typedef enum {
+    ARP_UP,
+    ARP_DOWN,
+    ARP_UP_DOWN,
+    ARP_ORDER,                  // Order the keys were pressed in
+    ARP_RANDOM                  // Shuffled once per chord, then repeated
+} arp_mode_t;
+
+// Sequencer configuration ([SEQUENCER] section)
+typedef struct {
+    int enabled;
+    int midi_sync;              // Follow MIDI clock position and Start/Stop instead of 'tempo'
+    float tempo;                // Internal tempo in BPM
+    int step;                   // Step length as a note division (16 = sixteenth notes)
+    float gate;                 // Note length as a fraction of a step
+    char tracks[SEQUENCER_STEP_TRACKS][SEQUENCER_MAX_STEPS + 16];   // "channel:note:steps"
+    int arp_channel;            // MIDI channel (0-15) whose held notes are arpeggiated, -1 = off
+    int arp_mode;               // arp_mode_t
+    int arp_octaves;            // 1-4
+    int arp_step;               // Arpeggio note length as a note division
+} sequencer_config_t;
+
+// Note event for the engine, 'offset' frames into the block
+typedef struct {
+    int offset;
+    uint8_t type;               // MIDI_EVENT_NOTE_ON or MIDI_EVENT_NOTE_OFF
+    uint8_t channel;
+    uint8_t note;
+    uint8_t velocity;
+} sequencer_event_t;
+
+// Step sequencer and arpeggiator
+//
+// Patterns are compiled ahead of time into flat arrays of note-ons with
+// their gate lengths: step tracks at init, the arpeggio by the MIDI thread
+// whenever the held chord changes (handed over through a triple buffer).
+// Once per block the audio thread turns the tempo into a tick window and
+// advances each track's cursor through it, emitting notes at exact frame
+// offsets. Tracks are monophonic; a note ends before the next one starts.
+
+// Configuration
+sequencer_config_t sequencer_get_default_config(void);
+void sequencer_load_config(sequencer_config_t *config);
+
+// Setup (not real-time safe, before JACK activation)
+int sequencer_init(const sequencer_config_t *config);
+
+// MIDI thread: take the arpeggiator channel's notes out of the batch; returns the events kept
+int sequencer_filter_events(midi_event_t *events, int count);
+
+// Real-time safe (audio thread only): note events for the next block, in time order
+int sequencer_render(const midi_clock_state_t *clock, int sample_rate, jack_nframes_t nframes,
+                     sequencer_event_t *events, int max_events);
+
+#endif // SEQUENCER_H
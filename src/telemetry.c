@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "telemetry.h"
+#include "audio_engine.h"
+#include "jack_client.h"
+#include "recorder.h"
+#include "midi_clock.h"
+#include "sample_cache.h"
+#include "kit_loader.h"
+
+// Longest request line and snapshot
+#define TELEMETRY_LINE_MAX 128
+#define TELEMETRY_REPLY_MAX 4096
+
+typedef struct {
+    int fd;                             // -1 if the slot is free
+    char line[TELEMETRY_LINE_MAX];
+    int line_length;
+} telemetry_client_t;
+
+static telemetry_client_t clients[TELEMETRY_MAX_CLIENTS];
+static int listen_fd = -1;
+static char socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+static pthread_t server_thread;
+static int server_running = 0;
+
+static float level_db(float level) {
+    return level > 1e-6f ? 20.0f * log10f(level) : -120.0f;
+}
+
+// Resident memory of the process (kB, 0 if unknown)
+static long memory_rss_kb(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    
+    long size = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int append_meter(char *reply, int length, const char *name, const engine_meter_t *m) {
+    return length + snprintf(reply + length, TELEMETRY_REPLY_MAX - length,
+                             "meter %s %.1f %.1f %.1f %.1f\n", name,
+                             level_db(m->peak[0]), level_db(m->peak[1]),
+                             level_db(m->rms[0]), level_db(m->rms[1]));
+}
+
+// Format one snapshot; returns its length
+static int format_snapshot(char *reply) {
+    engine_meters_t meters;
+    if (audio_engine_read_meters(&meters) < 0) {
+        return snprintf(reply, TELEMETRY_REPLY_MAX, "error meters busy\nend\n");
+    }
+    
+    sample_cache_stats_t cache;
+    sample_cache_get_stats(&cache);
+    
+    midi_clock_state_t clock;
+    memset(&clock, 0, sizeof(clock));
+    for (int attempt = 0; attempt < 100 && midi_clock_read(&clock, jack_client_get_sample_rate()) < 0; attempt++) {
+        sched_yield();
+    }
+    
+    int length = snprintf(reply, TELEMETRY_REPLY_MAX,
+                          "frames %lu\nsample_rate %d\nbuffer_size %d\ncpu_load %.1f\nxruns %lu\n"
+                          "memory_rss_kb %ld\nvoices %d\nevents_dropped %lu\nnotes_dropped %lu\n"
+                          "limiter_gain_db %.1f\nrecording %d\nrecorder_overruns %lu\n"
+                          "clock_bpm %.2f\nclock_locked %d\ntransport %d\nbeat %.2f\n"
+                          "sample_memory_kb %zu\nsample_hits %lu\nsample_misses %lu\n"
+                          "sample_evictions %lu\nsample_reloads %lu\nkit %d\nchannel_voices",
+                          meters.frames, jack_client_get_sample_rate(), jack_client_get_buffer_size(),
+                          jack_client_get_cpu_load(), jack_client_get_xrun_count(), memory_rss_kb(),
+                          meters.active_voices, meters.events_dropped, meters.notes_dropped,
+                          level_db(meters.limiter_gain), recorder_is_recording(), recorder_get_overruns(),
+                          clock.bpm, clock.locked, clock.running, clock.beat,
+                          cache.resident_bytes >> 10, meters.sample_hits, meters.sample_misses,
+                          cache.evictions, cache.reloads, kit_loader_get_current() + 1);
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        length += snprintf(reply + length, TELEMETRY_REPLY_MAX - length, " %d", meters.channel_voices[ch]);
+    }
+    length += snprintf(reply + length, TELEMETRY_REPLY_MAX - length, "\n");
+    
+    length = append_meter(reply, length, "output", &meters.output);
+    length = append_meter(reply, length, "reverb", &meters.reverb);
+    for (int ch = 0; ch < ENGINE_CHANNEL_BUSES; ch++) {
+        char name[8];
+        snprintf(name, sizeof(name), "ch%d", ch + 1);
+        length = append_meter(reply, length, name, &meters.channels[ch]);
+    }
+    length += snprintf(reply + length, TELEMETRY_REPLY_MAX - length, "end\n");
+    return length;
+}
+
+static void close_client(telemetry_client_t *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->line_length = 0;
+}
+
+// Send a whole reply; a client that can't take it right away is dropped
+static int send_reply(telemetry_client_t *client, const char *reply, int length) {
+    if (send(client->fd, reply, length, MSG_NOSIGNAL | MSG_DONTWAIT) != length) {
+        close_client(client);
+        return -1;
+    }
+    return 0;
+}
+
+static void handle_line(telemetry_client_t *client, char *line) {
+    static char reply[TELEMETRY_REPLY_MAX];
+    
+    // Strip trailing whitespace (telnet/netcat send \r\n)
+    int n = strlen(line);
+    while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == ' ')) {
+        line[--n] = '\0';
+    }
+    
+    if (n == 0 || strcmp(line, "get") == 0) {
+        send_reply(client, reply, format_snapshot(reply));
+    } else if (strcmp(line, "quit") == 0) {
+        close_client(client);
+    } else {
+        int length = snprintf(reply, sizeof(reply), "error unknown command %.32s\nend\n", line);
+        send_reply(client, reply, length);
+    }
+}
+
+static void read_client(telemetry_client_t *client) {
+    char buffer[TELEMETRY_LINE_MAX];
+    ssize_t received = recv(client->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (received <= 0) {
+        if (received == 0 || (errno != EAGAIN && errno != EINTR)) {
+            close_client(client);
+        }
+        return;
+    }
+    
+    for (ssize_t i = 0; i < received && client->fd >= 0; i++) {
+        if (buffer[i] == '\n') {
+            client->line[client->line_length] = '\0';
+            client->line_length = 0;
+            handle_line(client, client->line);
+        } else if (client->line_length < TELEMETRY_LINE_MAX - 1) {
+            client->line[client->line_length++] = buffer[i];
+        }
+    }
+}
+
+static void accept_client(void) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            clients[i].fd = fd;
+            clients[i].line_length = 0;
+            return;
+        }
+    }
+    
+    const char *busy = "error too many clients\nend\n";
+    send(fd, busy, strlen(busy), MSG_NOSIGNAL | MSG_DONTWAIT);
+    close(fd);
+}
+
+// Server thread (normal priority, never touches the audio thread directly)
+static void* server_func(void *arg) {
+    (void)arg;
+    struct pollfd fds[TELEMETRY_MAX_CLIENTS + 1];
+    
+    while (__atomic_load_n(&server_running, __ATOMIC_ACQUIRE)) {
+        int count = 0;
+        fds[count].fd = listen_fd;
+        fds[count].events = POLLIN;
+        count++;
+        for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+            fds[count].fd = clients[i].fd;      // Negative fds are ignored by poll
+            fds[count].events = POLLIN;
+            count++;
+        }
+        
+        // The timeout only bounds shutdown time
+        if (poll(fds, count, 100) <= 0) {
+            continue;
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            accept_client();
+        }
+        for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+            if (clients[i].fd >= 0 && fds[i + 1].fd == clients[i].fd &&
+                (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                read_client(&clients[i]);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+// Start serving telemetry on a Unix domain socket (replaces a stale socket file)
+int telemetry_start(const char *path) {
+    if (server_running) {
+        return 0;
+    }
+    
+    if (!path || path[0] == '\0' || strlen(path) >= sizeof(socket_path)) {
+        printf("Error: Invalid telemetry socket path\n");
+        return -1;
+    }
+    snprintf(socket_path, sizeof(socket_path), "%s", path);
+    
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        printf("Error: Cannot create telemetry socket: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+    unlink(socket_path);
+    
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, TELEMETRY_MAX_CLIENTS) < 0) {
+        printf("Error: Cannot listen on %s: %s\n", socket_path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+    
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+        clients[i].line_length = 0;
+    }
+    
+    __atomic_store_n(&server_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&server_thread, NULL, server_func, NULL) != 0) {
+        printf("Error: Cannot start telemetry thread\n");
+        server_running = 0;
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path);
+        return -1;
+    }
+    
+    printf("Telemetry: %s\n", socket_path);
+    return 0;
+}
+
+void telemetry_stop(void) {
+    if (!__atomic_load_n(&server_running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    
+    __atomic_store_n(&server_running, 0, __ATOMIC_RELEASE);
+    pthread_join(server_thread, NULL);
+    
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) {
+            close_client(&clients[i]);
+        }
+    }
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(socket_path);
+}
@@ -0,0 +1,31 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Default socket path ([SYSTEM] telemetry_socket, empty = off)
+#define TELEMETRY_DEFAULT_SOCKET "/tmp/rpi-sampler.sock"
+
+// Concurrent dashboard connections
+#define TELEMETRY_MAX_CLIENTS 4
+
+// Engine telemetry over a local Unix domain stream socket
+//
+// A normal-priority thread answers each line a client sends ("get" or an
+// empty line) with a snapshot in "key value..." lines ending with "end".
+// Meters come from audio_engine_read_meters(), so polling never touches the
+// audio thread. Levels are in dBFS (-120.0 = silence).
+//
+//   frames 1234567             sample_rate 48000    buffer_size 256
+//   cpu_load 12.5              xruns 0              memory_rss_kb 23456
+//   voices 3                   events_dropped 0     notes_dropped 0
+//   limiter_gain_db -0.8       recording 0          recorder_overruns 0
+//   clock_bpm 120.00           clock_locked 1       transport 1          beat 12.25
+//   sample_memory_kb 51200     sample_hits 310      sample_misses 4
+//   sample_evictions 12        sample_reloads 4     kit 2 (program number, 0 = samples folder)
+//   channel_voices 2 1 0 ... (16 values, MIDI channels 1-16)
+//   meter output|reverb|ch1..ch16 <peak L> <peak R> <rms L> <rms R>
+//   end
+
+int telemetry_start(const char *socket_path);
+void telemetry_stop(void);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,175 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "trace.h"
+
+typedef struct {
+    unsigned long stamp;        // Ring index + 1 once written, 0 while being written
+    uint64_t time_ns;           // CLOCK_MONOTONIC
+    int event;                  // trace_event_t
+    int value;
+    int value2;
+} trace_record_t;
+
+// Timeline rows (Chrome trace thread ids)
+enum {
+    TRACE_ROW_AUDIO = 1,
+    TRACE_ROW_MIDI,
+    TRACE_ROW_LOADER,
+    TRACE_ROW_JACK
+};
+
+static trace_record_t ring[TRACE_RING_SIZE];
+static unsigned long ring_head = 0;         // Next ring index (all writers)
+static int trace_enabled = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Clear and pre-touch the ring, enable recording
+void trace_init(int enabled) {
+    memset(ring, 0, sizeof(ring));
+    __atomic_store_n(&ring_head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&trace_enabled, enabled, __ATOMIC_RELEASE);
+}
+
+// Record an event (lock-free; writers only collide after a full lap of the ring)
+void trace_record(trace_event_t event, int value, int value2) {
+    if (!__atomic_load_n(&trace_enabled, __ATOMIC_RELAXED)) {
+        return;
+    }
+    
+    unsigned long index = __atomic_fetch_add(&ring_head, 1, __ATOMIC_RELAXED);
+    trace_record_t *record = &ring[index & (TRACE_RING_SIZE - 1)];
+    
+    __atomic_store_n(&record->stamp, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record->time_ns = now_ns();
+    record->event = event;
+    record->value = value;
+    record->value2 = value2;
+    __atomic_store_n(&record->stamp, index + 1, __ATOMIC_RELEASE);
+}
+
+// Copy the complete records in ring order; returns the number copied
+static int copy_ring(trace_record_t *out) {
+    unsigned long head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    unsigned long start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    int count = 0;
+    
+    for (unsigned long index = start; index < head; index++) {
+        const trace_record_t *record = &ring[index & (TRACE_RING_SIZE - 1)];
+        if (__atomic_load_n(&record->stamp, __ATOMIC_ACQUIRE) != index + 1) {
+            continue;   // Still being written, or already overwritten
+        }
+        
+        out[count] = *record;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&record->stamp, __ATOMIC_RELAXED) == index + 1) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void write_thread_name(FILE *f, int row, const char *name) {
+    fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            row == TRACE_ROW_AUDIO ? "" : ",\n", row, name);
+}
+
+// Write one record as a trace event (begin/end pairs update the open flags)
+static void write_record(FILE *f, const trace_record_t *r, double ts, int *process_open, int *load_open) {
+    switch (r->event) {
+        case TRACE_PROCESS_BEGIN:
+            *process_open = 1;
+            fprintf(f, "{\"name\":\"process\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"nframes\":%d}}", TRACE_ROW_AUDIO, ts, r->value);
+            break;
+        
+        case TRACE_PROCESS_END:
+            *process_open = 0;
+            fprintf(f, "{\"name\":\"process\",\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"voices\":%d}},\n", TRACE_ROW_AUDIO, ts, r->value);
+            fprintf(f, "{\"name\":\"voices\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"voices\":%d}}", TRACE_ROW_AUDIO, ts, r->value);
+            break;
+        
+        case TRACE_MIDI_RECEIVED:
+            fprintf(f, "{\"name\":\"midi received\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"events\":%d}}", TRACE_ROW_MIDI, ts, r->value);
+            break;
+        
+        case TRACE_MIDI_QUEUED:
+            fprintf(f, "{\"name\":\"midi queued\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"queued\":%d,\"dropped\":%d}}", TRACE_ROW_MIDI, ts, r->value, r->value2);
+            break;
+        
+        case TRACE_SAMPLE_LOAD_BEGIN:
+            *load_open = 1;
+            fprintf(f, "{\"name\":\"sample load\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                    TRACE_ROW_LOADER, ts);
+            break;
+        
+        case TRACE_SAMPLE_LOAD_END:
+            *load_open = 0;
+            fprintf(f, "{\"name\":\"sample load\",\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"frames\":%d}}", TRACE_ROW_LOADER, ts, r->value);
+            break;
+        
+        case TRACE_XRUN:
+            fprintf(f, "{\"name\":\"xrun\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"delay_us\":%d}}", TRACE_ROW_JACK, ts, r->value);
+            break;
+    }
+}
+
+// Write the ring as Chrome trace JSON (timestamps relative to the oldest record)
+int trace_dump(const char *path) {
+    trace_record_t *records = malloc(TRACE_RING_SIZE * sizeof(trace_record_t));
+    if (!records) {
+        printf("Error: Cannot allocate trace dump buffer\n");
+        return -1;
+    }
+    int count = copy_ring(records);
+    
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        printf("Error: Cannot write trace file %s\n", path);
+        free(records);
+        return -1;
+    }
+    
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    write_thread_name(f, TRACE_ROW_AUDIO, "audio");
+    write_thread_name(f, TRACE_ROW_MIDI, "midi");
+    write_thread_name(f, TRACE_ROW_LOADER, "loader");
+    write_thread_name(f, TRACE_ROW_JACK, "jack");
+    
+    int process_open = 0;
+    int load_open = 0;
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        // The oldest records may end a callback or load whose begin was overwritten
+        int event = records[i].event;
+        if ((event == TRACE_PROCESS_END && !process_open) || (event == TRACE_SAMPLE_LOAD_END && !load_open)) {
+            continue;
+        }
+        
+        fprintf(f, ",\n");
+        written++;
+        double ts = (records[i].time_ns - records[0].time_ns) / 1000.0;
+        write_record(f, &records[i], ts, &process_open, &load_open);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    free(records);
+    
+    printf("Trace: %d events written to %s\n", written, path);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Records kept (power of two; about 40 s of history at 48 kHz / 256 frames)
+#define TRACE_RING_SIZE 16384
+
+// Default dump file ([SYSTEM] trace_file), written on SIGUSR1
+#define TRACE_DEFAULT_FILE "/tmp/rpi-sampler-trace.json"
+
+// Traced events; each belongs to one timeline row in the viewer
+typedef enum {
+    TRACE_PROCESS_BEGIN,        // Audio: process callback entered (value = nframes)
+    TRACE_PROCESS_END,          // Audio: process callback done (value = active voices)
+    TRACE_MIDI_RECEIVED,        // MIDI: batch decoded (value = events)
+    TRACE_MIDI_QUEUED,          // MIDI: batch queued to the engine (value = queued, value2 = dropped)
+    TRACE_SAMPLE_LOAD_BEGIN,    // Loader: sample file load started
+    TRACE_SAMPLE_LOAD_END,      // Loader: sample file loaded (value = frames, 0 on failure)
+    TRACE_XRUN,                 // JACK: xrun reported (value = delay in microseconds)
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+// Trace recorder
+//
+// A fixed ring of timestamped records written lock-free from any thread,
+// including the audio thread (one atomic increment and a few stores).
+// Dumping copies the ring and writes it as Chrome trace JSON, viewable in
+// chrome://tracing or ui.perfetto.dev.
+
+// Setup (not real-time safe)
+void trace_init(int enabled);
+
+// Real-time safe, any thread
+void trace_record(trace_event_t event, int value, int value2);
+
+// Write the recorded history as Chrome trace JSON (not real-time safe)
+int trace_dump(const char *path);
+
+#endif // TRACE_H
@@ -0,0 +1,184 @@
+#define _GNU_SOURCE
+#include <math.h>
+#include <string.h>
+#include "voice_filter.h"
+#include "dsp.h"
+
+// A low-pass fully open with no resonance is passed through untouched
+static int is_neutral(int mode, float cutoff, float resonance) {
+    return mode == FILTER_LOWPASS && cutoff >= FILTER_VALUE_MAX && resonance <= 0.0f;
+}
+
+// Recompute the coefficients of both lanes of a voice
+static void update_coefficients(voice_filter_bank_t *bank, int voice) {
+    float cutoff = bank->cutoff[voice];
+    float resonance = bank->resonance[voice];
+    int mode = bank->mode[voice];
+    
+    float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+    float m0 = 1.0f, m1 = 0.0f, m2 = 0.0f;
+    
+    if (!is_neutral(mode, cutoff, resonance)) {
+        // 0-127 maps exponentially to 20 Hz - 20 kHz, clamped below Nyquist
+        float hz = 20.0f * powf(1000.0f, cutoff / FILTER_VALUE_MAX);
+        float hz_limit = 0.45f * (float)bank->sample_rate;
+        if (hz > hz_limit) hz = hz_limit;
+        
+        // Damping k = 1/Q: 0 = Butterworth (Q 0.707), 127 = Q 20
+        float k = 1.414f - (1.364f * resonance / FILTER_VALUE_MAX);
+        float g = tanf((float)M_PI * hz / (float)bank->sample_rate);
+        
+        a1 = 1.0f / (1.0f + g * (g + k));
+        a2 = g * a1;
+        a3 = g * a2;
+        
+        switch (mode) {
+            case FILTER_HIGHPASS:
+                m0 = 1.0f; m1 = -k; m2 = -1.0f;
+                break;
+            case FILTER_BANDPASS:
+                m0 = 0.0f; m1 = 1.0f; m2 = 0.0f;
+                break;
+            default:
+                m0 = 0.0f; m1 = 0.0f; m2 = 1.0f;
+                break;
+        }
+    }
+    
+    for (int ch = 0; ch < 2; ch++) {
+        int lane = voice * 2 + ch;
+        if (m0 == 1.0f && m1 == 0.0f) {
+            // Pass-through: clear memories so re-enabling starts clean
+            bank->ic1eq[lane] = 0.0f;
+            bank->ic2eq[lane] = 0.0f;
+        }
+        bank->a1[lane] = a1;
+        bank->a2[lane] = a2;
+        bank->a3[lane] = a3;
+        bank->m0[lane] = m0;
+        bank->m1[lane] = m1;
+        bank->m2[lane] = m2;
+    }
+}
+
+// Initialize all voices as neutral low-pass filters
+void voice_filter_init(voice_filter_bank_t *bank, int sample_rate) {
+    memset(bank, 0, sizeof(*bank));
+    bank->sample_rate = sample_rate;
+    
+    for (int v = 0; v < VOICE_FILTER_MAX_VOICES; v++) {
+        voice_filter_start(bank, v, FILTER_LOWPASS, FILTER_VALUE_MAX, 0.0f);
+    }
+}
+
+void voice_filter_set_sample_rate(voice_filter_bank_t *bank, int sample_rate) {
+    bank->sample_rate = sample_rate;
+    for (int v = 0; v < VOICE_FILTER_MAX_VOICES; v++) {
+        update_coefficients(bank, v);
+    }
+}
+
+// Start a voice's filter from silence with the given settings (no ramp)
+void voice_filter_start(voice_filter_bank_t *bank, int voice, int mode, float cutoff, float resonance) {
+    bank->mode[voice] = mode;
+    bank->cutoff[voice] = bank->cutoff_target[voice] = cutoff;
+    bank->resonance[voice] = bank->resonance_target[voice] = resonance;
+    bank->modulating[voice] = 0;
+    bank->ic1eq[voice * 2] = bank->ic1eq[voice * 2 + 1] = 0.0f;
+    bank->ic2eq[voice * 2] = bank->ic2eq[voice * 2 + 1] = 0.0f;
+    update_coefficients(bank, voice);
+}
+
+// Change a sounding voice's filter; cutoff and resonance ramp over the next block
+void voice_filter_modulate(voice_filter_bank_t *bank, int voice, int mode, float cutoff, float resonance) {
+    if (mode != bank->mode[voice]) {
+        bank->mode[voice] = mode;
+        update_coefficients(bank, voice);
+    }
+    bank->cutoff_target[voice] = cutoff;
+    bank->resonance_target[voice] = resonance;
+    bank->modulating[voice] = 1;
+}
+
+int voice_filter_is_bypassed(const voice_filter_bank_t *bank, int voice) {
+    return !bank->modulating[voice] &&
+           is_neutral(bank->mode[voice], bank->cutoff[voice], bank->resonance[voice]);
+}
+
+// Filter lanes first_lane..first_lane+lanes-1 in place (both multiples of 4); frames are 'stride' floats apart
+// Disjoint lane ranges can be processed by different threads
+void voice_filter_process(voice_filter_bank_t *bank, float *frames, int stride, int first_lane, int lanes,
+                          int nframes) {
+    int first_voice = first_lane / 2;
+    int voices = (first_lane + lanes) / 2;
+    int subblocks = (nframes + VOICE_FILTER_SUBBLOCK - 1) / VOICE_FILTER_SUBBLOCK;
+    
+    // Per sub-block parameter steps for modulated voices
+    float cutoff_step[VOICE_FILTER_MAX_VOICES];
+    float resonance_step[VOICE_FILTER_MAX_VOICES];
+    int any_modulating = 0;
+    for (int v = first_voice; v < voices; v++) {
+        if (bank->modulating[v]) {
+            cutoff_step[v] = (bank->cutoff_target[v] - bank->cutoff[v]) / subblocks;
+            resonance_step[v] = (bank->resonance_target[v] - bank->resonance[v]) / subblocks;
+            any_modulating = 1;
+        }
+    }
+    
+    for (int sb = 0; sb < subblocks; sb++) {
+        int start = sb * VOICE_FILTER_SUBBLOCK;
+        int end = start + VOICE_FILTER_SUBBLOCK < nframes ? start + VOICE_FILTER_SUBBLOCK : nframes;
+        
+        if (any_modulating) {
+            for (int v = first_voice; v < voices; v++) {
+                if (!bank->modulating[v]) {
+                    continue;
+                }
+                if (sb == subblocks - 1) {
+                    bank->cutoff[v] = bank->cutoff_target[v];
+                    bank->resonance[v] = bank->resonance_target[v];
+                    bank->modulating[v] = 0;
+                } else {
+                    bank->cutoff[v] += cutoff_step[v];
+                    bank->resonance[v] += resonance_step[v];
+                }
+                update_coefficients(bank, v);
+            }
+        }
+        
+        // Four lanes per vector; coefficients stay constant across the sub-block
+        for (int lane = first_lane; lane < first_lane + lanes; lane += 4) {
+            v4sf a1 = v4sf_load(bank->a1 + lane);
+            v4sf a2 = v4sf_load(bank->a2 + lane);
+            v4sf a3 = v4sf_load(bank->a3 + lane);
+            v4sf m0 = v4sf_load(bank->m0 + lane);
+            v4sf m1 = v4sf_load(bank->m1 + lane);
+            v4sf m2 = v4sf_load(bank->m2 + lane);
+            v4sf ic1eq = v4sf_load(bank->ic1eq + lane);
+            v4sf ic2eq = v4sf_load(bank->ic2eq + lane);
+            v4sf two = v4sf_set1(2.0f);
+            
+            float *p = frames + start * stride + lane;
+            for (int f = start; f < end; f++, p += stride) {
+                v4sf v0 = v4sf_load(p);
+                v4sf v3 = v0 - ic2eq;
+                v4sf v1 = a1 * ic1eq + a2 * v3;
+                v4sf v2 = ic2eq + a2 * ic1eq + a3 * v3;
+                ic1eq = two * v1 - ic1eq;
+                ic2eq = two * v2 - ic2eq;
+                v4sf_store(p, m0 * v0 + m1 * v1 + m2 * v2);
+            }
+            
+            v4sf_store(bank->ic1eq + lane, ic1eq);
+            v4sf_store(bank->ic2eq + lane, ic2eq);
+        }
+    }
+}
+
+const char* voice_filter_mode_name(int mode) {
+    switch (mode) {
+        case FILTER_HIGHPASS: return "highpass";
+        case FILTER_BANDPASS: return "bandpass";
+        default: return "lowpass";
+    }
+}
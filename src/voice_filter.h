@@ -0,0 +1,61 @@
+#ifndef VOICE_FILTER_H
+#define VOICE_FILTER_H
+
+// Voices and lanes in a filter bank (lane = voice * 2 + channel)
+#define VOICE_FILTER_MAX_VOICES 16
+#define VOICE_FILTER_MAX_LANES (VOICE_FILTER_MAX_VOICES * 2)
+
+// Coefficients are recomputed once per block, or every sub-block while modulated
+#define VOICE_FILTER_SUBBLOCK 16
+
+// Filter modes
+typedef enum {
+    FILTER_LOWPASS = 0,
+    FILTER_HIGHPASS,
+    FILTER_BANDPASS
+} filter_mode_t;
+
+// Parameters use the MIDI range (0-127) so they map directly to CCs
+#define FILTER_VALUE_MAX 127
+
+// Bank of resonant state-variable filters (trapezoidal SVF), one per voice
+//
+// Everything per lane is stored as structure-of-arrays so the per-frame loop
+// processes four lanes per vector instruction. Audio is interleaved by frame:
+// frames[frame * stride + lane].
+typedef struct {
+    // Per-lane coefficients and state
+    float a1[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));
+    float a2[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));
+    float a3[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));
+    float m0[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));  // Output mix: input
+    float m1[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));  // Output mix: band
+    float m2[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));  // Output mix: low
+    float ic1eq[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));
+    float ic2eq[VOICE_FILTER_MAX_LANES] __attribute__((aligned(16)));
+    
+    // Per-voice parameters
+    int mode[VOICE_FILTER_MAX_VOICES];
+    float cutoff[VOICE_FILTER_MAX_VOICES];          // 0-127, exponential 20 Hz - 20 kHz
+    float cutoff_target[VOICE_FILTER_MAX_VOICES];
+    float resonance[VOICE_FILTER_MAX_VOICES];       // 0-127
+    float resonance_target[VOICE_FILTER_MAX_VOICES];
+    int modulating[VOICE_FILTER_MAX_VOICES];        // Ramping towards the targets
+    
+    int sample_rate;
+} voice_filter_bank_t;
+
+// Setup
+void voice_filter_init(voice_filter_bank_t *bank, int sample_rate);
+void voice_filter_set_sample_rate(voice_filter_bank_t *bank, int sample_rate);
+
+// Real-time functions
+void voice_filter_start(voice_filter_bank_t *bank, int voice, int mode, float cutoff, float resonance);
+void voice_filter_modulate(voice_filter_bank_t *bank, int voice, int mode, float cutoff, float resonance);
+int voice_filter_is_bypassed(const voice_filter_bank_t *bank, int voice);
+void voice_filter_process(voice_filter_bank_t *bank, float *frames, int stride, int first_lane, int lanes,
+                          int nframes);
+
+const char* voice_filter_mode_name(int mode);
+
+#endif // VOICE_FILTER_H
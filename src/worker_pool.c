@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "worker_pool.h"
+#include "rt_setup.h"
+
+static pthread_t worker_threads[WORKER_POOL_MAX_THREADS];
+static int thread_count = 0;
+static int pool_running = 0;
+
+// Current job; task and arg are written before the job word publishes them
+static worker_pool_task_t job_task = NULL;
+static void *job_arg = NULL;
+
+// Job word: generation (bits 32-63), task count (16-31), next task to claim (0-15)
+// A claim only succeeds for the current generation, so a late worker can't take
+// a task of the next job with the previous job's function
+static uint64_t job_claim = 0;
+static int job_pending = 0;             // Tasks claimed or not, not yet finished
+
+// Futex word bumped for every job; sleeping workers wait for it to change
+static int job_generation = 0;
+static int sleepers = 0;
+
+static long futex(int *word, int op, int value) {
+    return syscall(SYS_futex, word, op, value, NULL, NULL, 0);
+}
+
+static inline void cpu_relax(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Claim and run tasks of job 'generation' until none are left
+static void run_tasks(uint32_t generation) {
+    uint64_t claim = __atomic_load_n(&job_claim, __ATOMIC_ACQUIRE);
+    
+    while ((uint32_t)(claim >> 32) == generation && (claim & 0xFFFF) < ((claim >> 16) & 0xFFFF)) {
+        if (!__atomic_compare_exchange_n(&job_claim, &claim, claim + 1, 1,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            continue;   // claim was reloaded
+        }
+        
+        // The job can't finish (or be replaced) before this task does
+        job_task((int)(claim & 0xFFFF), job_arg);
+        __atomic_sub_fetch(&job_pending, 1, __ATOMIC_RELEASE);
+        claim = __atomic_load_n(&job_claim, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void* worker_func(void *arg) {
+    (void)arg;
+    rt_setup_thread(RT_THREAD_RENDER);
+    
+    int seen = __atomic_load_n(&job_generation, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&pool_running, __ATOMIC_ACQUIRE)) {
+        // Jobs come once per period: spin a little in case the next one is close, then sleep
+        int generation = __atomic_load_n(&job_generation, __ATOMIC_ACQUIRE);
+        for (int i = 0; i < WORKER_POOL_SPIN && generation == seen; i++) {
+            cpu_relax();
+            generation = __atomic_load_n(&job_generation, __ATOMIC_ACQUIRE);
+        }
+        if (generation == seen) {
+            __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+            futex(&job_generation, FUTEX_WAIT_PRIVATE, seen);
+            __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        
+        seen = generation;
+        run_tasks((uint32_t)generation);
+    }
+    
+    return NULL;
+}
+
+// Start 'threads' workers (0 = run every job on the caller)
+int worker_pool_start(int threads) {
+    if (thread_count > 0) {
+        return 0;
+    }
+    if (threads > WORKER_POOL_MAX_THREADS) {
+        threads = WORKER_POOL_MAX_THREADS;
+    }
+    
+    __atomic_store_n(&pool_running, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&worker_threads[thread_count], NULL, worker_func, NULL) != 0) {
+            printf("Warning: Started %d of %d render threads\n", thread_count, threads);
+            break;
+        }
+        thread_count++;
+    }
+    
+    if (thread_count == 0) {
+        __atomic_store_n(&pool_running, 0, __ATOMIC_RELEASE);
+        return threads > 0 ? -1 : 0;
+    }
+    return 0;
+}
+
+void worker_pool_stop(void) {
+    if (thread_count == 0) {
+        return;
+    }
+    
+    __atomic_store_n(&pool_running, 0, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&job_generation, 1, __ATOMIC_SEQ_CST);
+    futex(&job_generation, FUTEX_WAKE_PRIVATE, INT_MAX);
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(worker_threads[i], NULL);
+    }
+    thread_count = 0;
+}
+
+int worker_pool_get_threads(void) {
+    return thread_count;
+}
+
+// Run tasks 0..tasks-1 across the caller and the workers; returns when all are done
+void worker_pool_run(worker_pool_task_t task, void *arg, int tasks) {
+    if (tasks > WORKER_POOL_MAX_TASKS) {
+        tasks = WORKER_POOL_MAX_TASKS;
+    }
+    if (thread_count == 0 || tasks <= 1) {
+        for (int i = 0; i < tasks; i++) {
+            task(i, arg);
+        }
+        return;
+    }
+    
+    // Publish the job, then wake workers only if some went to sleep
+    uint32_t generation = (uint32_t)__atomic_load_n(&job_generation, __ATOMIC_RELAXED) + 1;
+    job_task = task;
+    job_arg = arg;
+    __atomic_store_n(&job_pending, tasks, __ATOMIC_RELAXED);
+    __atomic_store_n(&job_claim, ((uint64_t)generation << 32) | ((uint64_t)tasks << 16), __ATOMIC_RELEASE);
+    __atomic_store_n(&job_generation, (int)generation, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sleepers, __ATOMIC_SEQ_CST) > 0) {
+        futex(&job_generation, FUTEX_WAKE_PRIVATE, INT_MAX);
+    }
+    
+    run_tasks(generation);
+    
+    // Only tasks already running on a worker are left
+    while (__atomic_load_n(&job_pending, __ATOMIC_ACQUIRE) > 0) {
+        cpu_relax();
+    }
+}
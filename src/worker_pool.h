@@ -0,0 +1,32 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// Most worker threads (the caller always takes part as well)
+#define WORKER_POOL_MAX_THREADS 7
+
+// Most tasks per job
+#define WORKER_POOL_MAX_TASKS 16
+
+// Polls of the job word before a waiting worker sleeps on the futex
+#define WORKER_POOL_SPIN 2000
+
+// Task function: 'task' is 0..tasks-1, whichever thread runs it
+typedef void (*worker_pool_task_t)(int task, void *arg);
+
+// Fork/join pool of pre-spawned real-time threads
+//
+// The audio thread posts a job of independent tasks and runs tasks itself
+// until none are left, then spins until the ones taken by workers are done.
+// Workers spin briefly after each job, then sleep on a futex. Tasks are
+// claimed one at a time, so a worker that wakes late simply finds nothing
+// to do and the job never waits for a thread that hasn't started.
+
+// Setup (not real-time safe)
+int worker_pool_start(int threads);
+void worker_pool_stop(void);
+int worker_pool_get_threads(void);
+
+// Real-time safe (one caller at a time, normally the audio thread)
+void worker_pool_run(worker_pool_task_t task, void *arg, int tasks);
+
+#endif // WORKER_POOL_H